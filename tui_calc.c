@@ -8,16 +8,25 @@
  *   Linux/macOS:            gcc tui_calc_pro_c89.c -O2 -lm -o calc
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#  define _GNU_SOURCE   /* sched_setaffinity/sched_getcpu--perfcheck ̶ CPU */
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <math.h>
 #include <errno.h>
+#include <float.h>
+#include <time.h>
 
 #ifdef _WIN32
 #  include <windows.h>
 #endif
+#ifdef __linux__
+#  include <sched.h>
+#  include <sys/utsname.h>
+#endif
 
 #ifndef M_PI
 #  define M_PI 3.14159265358979323846
@@ -30,6 +39,18 @@
 #  endif
 #endif
 
+/* 64 λC89  long longѡ */
+#ifdef _MSC_VER
+typedef unsigned __int64 calc_u64;
+typedef __int64 calc_s64;
+#else
+typedef unsigned long long calc_u64;
+typedef long long calc_s64;
+#endif
+#define CALC_U64(hi,lo) (((calc_u64)(hi)<<32) | (calc_u64)(lo))
+/* 32 λ޷Ŀƽ̨ int Ϊ 32 λ float λ */
+typedef unsigned int calc_u32;
+
 /* ------------  ------------ */
 #define MAX_LINE     512
 #define MAX_TOKENS   1024
@@ -37,6 +58,11 @@
 #define MAX_HISTORY  50
 #define MAX_VARS     64
 #define NAME_LEN     16
+#define MAX_MATS     16
+#define MAX_BIND     8      /* Ԥʽɰ󶨵ı */
+#define MAX_FUNC_ARGS 16
+#define FFT_MAX_N    (1<<24)
+#define MAX_MAT_ELEMS 4096
 
 /* ------------ ƽ̨ ------------ */
 static void enable_ansi_if_windows(void){
@@ -50,12 +76,384 @@ static void enable_ansi_if_windows(void){
 #endif
 }
 static void clear_screen(void){ printf("\x1b[2J\x1b[H"); }
+/* ʱӣ룬⣩Windows  QueryPerformanceCounter CLOCK_MONOTONIC ʱ
+ * clock_gettime˻ clock()Ϊ CPU ʱ䣬Ҳϴ֣ */
+static double calc_now(void){
+#if defined(_WIN32)
+    static LARGE_INTEGER freq; LARGE_INTEGER c;
+    if(freq.QuadPart==0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&c);
+    return (double)c.QuadPart/(double)freq.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (double)ts.tv_sec+1e-9*(double)ts.tv_nsec;
+#else
+    return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+/* ѽ̶̹һ CPU ϣ--perfcheck ãǨƴĶLinux ȡǰڵ CPU
+ * Windows ȡ CPU 0 CPU ţֻ֧ʧܷ -1 */
+static int calc_pin_cpu(void){
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(),1)? 0 : -1;
+#elif defined(__linux__)
+    cpu_set_t set; int c=sched_getcpu();
+    if(c<0) c=0;
+    CPU_ZERO(&set); CPU_SET(c,&set);
+    return sched_setaffinity(0,sizeof(set),&set)==0? c : -1;
+#else
+    return -1;
+#endif
+}
+static const char* calc_clock_name(void){
+#if defined(_WIN32)
+    return "QueryPerformanceCounter";
+#elif defined(CLOCK_MONOTONIC)
+    return "clock_gettime(CLOCK_MONOTONIC)";
+#else
+    return "clock()";
+#endif
+}
+
+/* ------------ ڴˣ/mem ------------
+ * жѷ䶼 calc_malloc/calc_calloc/calc_realloc/calc_freeϵͳͳƵǰֵֽ
+ * ÿǰ 16 ֽڵͷ¼Сϵͳͷʱٸϵͳrealloc ԭ
+ * ϵͳ޵ķ䷵ NULLɵ÷ڴ治㱨һ·ǵϵͳɱ */
+typedef enum { MEM_HISTORY=0, MEM_VARS, MEM_CODE, MEM_CACHE, MEM_ARRAY, MEM_BIGNUM, MEM_ARENA, MEM_POOL, MEM_OTHER, MEM_NTAGS } MemTag;
+#define MEM_DEFAULT_LIMIT_MB 4096.0   /* ޵Ĭֵ/mem limit total off ȡ */
+typedef union { struct { size_t size; int tag; } h; double align[2]; } MemHdr;
+typedef struct { size_t cur, peak; double limit; long nalloc, nfree, nfail; } MemStat;   /* limitֽڣ0 Ϊ */
+static MemStat g_mem[MEM_NTAGS];
+static MemStat g_mem_total = { 0, 0, MEM_DEFAULT_LIMIT_MB*1048576.0, 0, 0, 0 };
+static const char* const g_mem_names[MEM_NTAGS]={"history","vars","code","cache","array","bignum","arena","pool","other"};
+static const char* const g_mem_desc[MEM_NTAGS]={
+    "ʷ¼ַ","","Ԥʽֵջ","FFT תݱ","ֵĹ",
+    "ȷģʽı","ʱ鱣","пеС","׷ٻ塢׼Բ"
+};
+
+static int mem_admit_local(int tag,size_t add){
+    if((g_mem[tag].limit>0 && (double)g_mem[tag].cur+(double)add>g_mem[tag].limit)
+       || (g_mem_total.limit>0 && (double)g_mem_total.cur+(double)add>g_mem_total.limit)){
+        g_mem[tag].nfail++; g_mem_total.nfail++;
+        return 0;
+    }
+    return 1;
+}
+static void mem_add_local(int tag,size_t n){
+    g_mem[tag].cur+=n; if(g_mem[tag].cur>g_mem[tag].peak) g_mem[tag].peak=g_mem[tag].cur;
+    g_mem_total.cur+=n; if(g_mem_total.cur>g_mem_total.peak) g_mem_total.peak=g_mem_total.cur;
+}
+static void mem_sub_local(int tag,size_t n){ g_mem[tag].cur-=n; g_mem_total.cur-=n; }
+static void* mem_attach_local(MemHdr* h,MemTag tag,size_t n){
+    if(!h){ g_mem[tag].nfail++; g_mem_total.nfail++; return NULL; }
+    h->h.size=n; h->h.tag=(int)tag;
+    mem_add_local(tag,n); g_mem[tag].nalloc++; g_mem_total.nalloc++;
+    return h+1;
+}
+static void* calc_malloc(MemTag tag,size_t n){
+    if(n>(size_t)-1-sizeof(MemHdr) || !mem_admit_local(tag,n)) return NULL;
+    return mem_attach_local((MemHdr*)malloc(sizeof(MemHdr)+n),tag,n);
+}
+static void* calc_calloc(MemTag tag,size_t cnt,size_t sz){
+    size_t n;
+    if(sz && cnt>((size_t)-1-sizeof(MemHdr))/sz) return NULL;
+    n=cnt*sz;
+    if(!mem_admit_local(tag,n)) return NULL;
+    return mem_attach_local((MemHdr*)calloc(1,sizeof(MemHdr)+n),tag,n);   /* ͷһ㣬дͷ */
+}
+static void* calc_realloc(MemTag tag,void* p,size_t n){
+    MemHdr *h, *nh; size_t old;
+    if(!p) return calc_malloc(tag,n);
+    h=(MemHdr*)p-1; old=h->h.size; tag=(MemTag)h->h.tag;
+    if(n>(size_t)-1-sizeof(MemHdr) || (n>old && !mem_admit_local(tag,n-old))) return NULL;
+    if(!(nh=(MemHdr*)realloc(h,sizeof(MemHdr)+n))){ g_mem[tag].nfail++; g_mem_total.nfail++; return NULL; }
+    mem_sub_local(tag,old); mem_add_local(tag,n);
+    nh->h.size=n; g_mem[tag].nalloc++; g_mem_total.nalloc++;
+    return nh+1;
+}
+static void calc_free(void* p){
+    MemHdr* h;
+    if(!p) return;
+    h=(MemHdr*)p-1;
+    mem_sub_local(h->h.tag,h->h.size); g_mem[h->h.tag].nfree++; g_mem_total.nfree++;
+    free(h);
+}
+/* ѷĿļǵһϵͳɴ֮ڻݱ */
+static void calc_mem_retag(void* p,MemTag tag){
+    MemHdr* h;
+    if(!p) return;
+    h=(MemHdr*)p-1;
+    mem_sub_local(h->h.tag,h->h.size); h->h.tag=(int)tag; mem_add_local(tag,h->h.size);
+}
+
+/* ------------ ʱС ------------
+ * ʱarenaִеʱ飨ͼɨؿ޵塢ѡFFT ȣ
+ *  16 ֽڶ˳з ARENA_CHUNK СĿ飬÷Ϊ mk=calc_arena_mark(); ...; calc_arena_release(mk);
+ * ͷֻ˻ָ룬´ʹãѭÿнʱ帴λֻһ׼顣
+ * С󵥶ռһ顣ʱڴ治 calc_free ͷţҲܿб档
+ * СأpoolʷַԤֵջȳڵ滻С 2 ݷΪ POOL_CLASSES 
+ *  calc_pool_free 黹ĿڶӦĿÿ POOL_KEEP 飬 pool £
+ * calc_pool_alloc ȸãֱ calc_mallocиòϵͳķ/ͷŴ */
+#define ARENA_CHUNK    (64*1024)
+#define POOL_MIN_SHIFT 4          /* Сһ 16 ֽ */
+#define POOL_CLASSES   11         /* 16 B .. 16 KB */
+#define POOL_KEEP      64
+typedef union ArenaHead { struct { union ArenaHead* next; size_t cap, used; } c; double align[4]; } ArenaHead;
+typedef struct { ArenaHead *head, *cur; size_t inuse, peak; long allocs, chunks, leaked; } CalcArena;
+typedef struct { ArenaHead* chunk; size_t used, inuse; } ArenaMark;
+static CalcArena g_arena;
+static void*     g_pool_free[POOL_CLASSES];
+static int       g_pool_n[POOL_CLASSES];
+static long      g_pool_hits = 0, g_pool_misses = 0;
+
+static ArenaMark calc_arena_mark(void){
+    ArenaMark m;
+    m.chunk=g_arena.cur; m.used=g_arena.cur? g_arena.cur->c.used : 0; m.inuse=g_arena.inuse;
+    return m;
+}
+static void calc_arena_release(ArenaMark m){
+    g_arena.cur=m.chunk;
+    if(m.chunk) m.chunk->c.used=m.used;
+    g_arena.inuse=m.inuse;
+}
+/* ǰ鲻ʱԺ汣Ŀ飨У·һĩβʧܷ NULL ״̬ */
+static void* calc_arena_alloc(size_t n){
+    ArenaHead *c=g_arena.cur, *prev=c;
+    if(n>(size_t)-1-sizeof(ArenaHead)-64) return NULL;
+    n=n? (n+15)&~(size_t)15 : 16;
+    if(!c || c->c.cap-c->c.used<n){
+        for(c=c? c->c.next : g_arena.head; c && c->c.cap<n; c=c->c.next) prev=c;
+        if(!c){
+            size_t cap=n>ARENA_CHUNK? n : ARENA_CHUNK;
+            if(!(c=(ArenaHead*)calc_malloc(MEM_ARENA,sizeof(ArenaHead)+cap))) return NULL;
+            c->c.cap=cap; c->c.next=NULL;
+            while(prev && prev->c.next) prev=prev->c.next;
+            if(prev) prev->c.next=c; else g_arena.head=c;
+            g_arena.chunks++;
+        }
+        c->c.used=0;
+        g_arena.cur=c;
+    }
+    c->c.used+=n; g_arena.inuse+=n; g_arena.allocs++;
+    if(g_arena.inuse>g_arena.peak) g_arena.peak=g_arena.inuse;
+    return (char*)(c+1)+c->c.used-n;
+}
+/* 帴λѭÿһΣδͷŵļ leakedֻһ׼СĿ */
+static void calc_arena_reset(void){
+    ArenaHead *c, *nx, *keep=NULL;
+    if(g_arena.inuse) g_arena.leaked++;
+    g_arena.cur=NULL; g_arena.inuse=0;
+    for(c=g_arena.head;c;c=nx){
+        nx=c->c.next;
+        if(!keep && c->c.cap==ARENA_CHUNK){ keep=c; continue; }
+        calc_free(c); g_arena.chunks--;
+    }
+    if(keep) keep->c.next=NULL;
+    g_arena.head=keep;
+}
+static int pool_class_local(size_t n){
+    int k=0;
+    while(k<POOL_CLASSES && ((size_t)1<<(POOL_MIN_SHIFT+k))<n) ++k;
+    return k;
+}
+static void* calc_pool_alloc(MemTag tag,size_t n){
+    int k=pool_class_local(n); size_t sz; void* p;
+    if(k==POOL_CLASSES) return calc_malloc(tag,n);
+    sz=(size_t)1<<(POOL_MIN_SHIFT+k);
+    if(!(p=g_pool_free[k])){ g_pool_misses++; return calc_malloc(tag,sz); }
+    if(g_mem[tag].limit>0 && (double)g_mem[tag].cur+(double)sz>g_mem[tag].limit){ g_mem[tag].nfail++; g_mem_total.nfail++; return NULL; }
+    memcpy(&g_pool_free[k],p,sizeof(void*));
+    g_pool_n[k]--; g_pool_hits++;
+    calc_mem_retag(p,tag);
+    return p;
+}
+/* ֻǡΪĳСĿأСֱͷ */
+static void calc_pool_free(void* p){
+    int k; size_t sz;
+    if(!p) return;
+    sz=((MemHdr*)p-1)->h.size; k=pool_class_local(sz);
+    if(k==POOL_CLASSES || sz!=((size_t)1<<(POOL_MIN_SHIFT+k)) || g_pool_n[k]>=POOL_KEEP){ calc_free(p); return; }
+    calc_mem_retag(p,MEM_POOL);
+    memcpy(p,&g_pool_free[k],sizeof(void*));
+    g_pool_free[k]=p; g_pool_n[k]++;
+}
+
+static void mem_report_print(void){
+    int i;
+    printf("ڴˣλ KB realloc - Ϊޣ\n\n");
+    printf("%-8s %12s %12s %10s %10s %6s %10s  %s\n","ϵͳ","ǰ","ֵ","","ͷ","ʧ","","");
+    for(i=0;i<=MEM_NTAGS;++i){
+        const MemStat* m=(i<MEM_NTAGS)? &g_mem[i] : &g_mem_total;
+        char lim[24];
+        if(m->limit>0) sprintf(lim,"%.0f",m->limit/1024.0); else strcpy(lim,"-");
+        printf("%-8s %12.1f %12.1f %10ld %10ld %6ld %10s  %s\n",(i<MEM_NTAGS)? g_mem_names[i] : "total",
+               m->cur/1024.0,m->peak/1024.0,m->nalloc,m->nfree,m->nfail,lim,(i<MEM_NTAGS)? g_mem_desc[i] : "ϼ");
+    }
+    {
+        int k, nb=0;
+        for(k=0;k<POOL_CLASSES;++k) nb+=g_pool_n[k];
+        printf("\nʱ %ld 飬ʹ %.1f KBֵ %.1f KBз %ld Σĩδͷ %ld \n",
+               g_arena.chunks,g_arena.inuse/1024.0,g_arena.peak/1024.0,g_arena.allocs,g_arena.leaked);
+        printf("Сأ %d 飬 %ld Σ· %ld \n",nb,g_pool_hits,g_pool_misses);
+    }
+    printf("\nй̶Сľ̬ʷۡǺŻȣڴС\n");
+}
+
+/* ------------ ֽ׶μʱ/timing ------------
+ * 򿪺ۼƸ׶ǽʱ䣺ʷת RPN  tokenize_local/to_rpn_local 룻
+ * ֵȡ䣬۳ѼĴʷ/ת͵ȴسʱ䣻ʽȾѭʱ
+ * رʱÿֻһ g_timing жϡ */
+typedef enum { TM_TOKENIZE=0, TM_RPN, TM_EVAL, TM_CMD, TM_FORMAT, TM_RENDER, TM_TOTAL, TM_COUNT } TimingPhase;
+#define TIMING_SAMPLES 1024   /* λȡô */
+typedef struct { long count; double sum, max; double ring[TIMING_SAMPLES]; } TimingStat;
+static int    g_timing = 0;
+static double g_tm_cur[TM_COUNT];    /* и׶ۼƣ룩 */
+static long   g_tm_calls[TM_COUNT];  /* и׶ν */
+static double g_tm_line0 = 0.0, g_tm_wait = 0.0, g_tm_mark_t = 0.0, g_tm_mark_in = 0.0;
+static TimingStat g_tm_stat[TM_COUNT];
+static const char* const g_tm_names[TM_COUNT]={"ʷ","תRPN","ֵ","","ʽ","Ⱦ","ϼ"};
+
+static void timing_add_local(TimingPhase p,double dt){ g_tm_cur[p]+=dt; g_tm_calls[p]++; }
+static double timing_inner_local(void){ return g_tm_cur[TM_TOKENIZE]+g_tm_cur[TM_RPN]+g_tm_wait; }
+/* ʱǶףmark Ѽڲʱ䣬stop ۳ڲĲ */
+static void timing_mark_local(void){ g_tm_mark_in=timing_inner_local(); g_tm_mark_t=calc_now(); }
+static void timing_stop_local(TimingPhase p){ timing_add_local(p,calc_now()-g_tm_mark_t-(timing_inner_local()-g_tm_mark_in)); }
+static void timing_reset_line_local(void){
+    memset(g_tm_cur,0,sizeof(g_tm_cur)); memset(g_tm_calls,0,sizeof(g_tm_calls));
+    g_tm_wait=0.0; g_tm_line0=0.0; g_tm_mark_in=0.0; g_tm_mark_t=calc_now();
+}
+static void timing_begin_line_local(void){ timing_reset_line_local(); g_tm_line0=calc_now(); }
+/* ȫȴسȴʱ䲻 */
+static void wait_enter_local(void){
+    double t0;
+    if(!g_timing){ getchar(); return; }
+    t0=calc_now(); getchar(); g_tm_wait+=calc_now()-t0;
+}
+/* ȾϣȾϼƣͳƲ´ӡи׶κʱֻȾУеȣ */
+static void timing_end_line_local(double trender){
+    double now=calc_now(); int p, any=0;
+    timing_add_local(TM_RENDER,now-trender);
+    for(p=0;p<TM_RENDER;++p) any|=(g_tm_calls[p]>0);
+    if(g_tm_line0>0.0 && any){
+        g_tm_cur[TM_TOTAL]=now-g_tm_line0-g_tm_wait; g_tm_calls[TM_TOTAL]=1;
+        printf("ʱ(ms):");
+        for(p=0;p<TM_COUNT;++p){
+            TimingStat* st=&g_tm_stat[p];
+            if(!g_tm_calls[p]) continue;
+            st->ring[st->count%TIMING_SAMPLES]=g_tm_cur[p];
+            st->count++; st->sum+=g_tm_cur[p];
+            if(g_tm_cur[p]>st->max) st->max=g_tm_cur[p];
+            printf(" %s %.3f",g_tm_names[p],1e3*g_tm_cur[p]);
+            if(g_tm_calls[p]>1) printf("%ld",g_tm_calls[p]);
+        }
+        printf("\n");
+    }
+    g_tm_line0=0.0;
+}
+static void timing_stats_print(void){
+    static double v[TIMING_SAMPLES];
+    int p, n, k, j;
+    printf("ֽ׶μʱͳƣÿһλ msλȡ %d Уʱ %s\n\n",TIMING_SAMPLES,calc_clock_name());
+    printf("%-8s %8s %10s %10s %10s %10s\n","׶","","ƽ","p50","p99","");
+    for(p=0;p<TM_COUNT;++p){
+        const TimingStat* st=&g_tm_stat[p];
+        if(!st->count){ printf("%-8s %8d %10s %10s %10s %10s\n",g_tm_names[p],0,"-","-","-","-"); continue; }
+        n=st->count<TIMING_SAMPLES? (int)st->count : TIMING_SAMPLES;
+        memcpy(v,st->ring,sizeof(double)*(size_t)n);
+        for(k=1;k<n;++k){   /*  */
+            double x=v[k];
+            for(j=k-1;j>=0 && v[j]>x;--j) v[j+1]=v[j];
+            v[j+1]=x;
+        }
+        k=(int)ceil(0.99*n)-1;
+        printf("%-8s %8ld %10.3f %10.3f %10.3f %10.3f\n",g_tm_names[p],st->count,1e3*st->sum/(double)st->count,
+               1e3*v[(n-1)/2],1e3*v[k<0? 0 : k],1e3*st->max);
+    }
+}
+
+/* ------------ ¼׷٣--trace-outChrome trace ʽ ------------
+ * ¼ȼڴ滺壬ѭȴǰʱ򻺳ʱд·ֻȡʱӡ
+ * βӣ TRACE_MERGE_GAP 룩ͬ¼ϲΪһֱȴﵽ TRACE_MERGE_SPAN
+ * õ eval_batchargs  spans ΪϲĴn ΪۼƵ
+ * ÿ TRACE_LINE_DETAIL ϸ¼ʷתֵЩ̽رյһУ
+ * һ detail_limit ǣȾ¼ޡ
+ * Ϊ JSON ʽ chrome://tracing  Perfetto 򿪣;˳ȱĩβ ']' Ҳܼء
+ * Ϊ̣߳¼ͬһ tid ϰʱǶ */
+#define TRACE_BUF_EVENTS 16384
+#define TRACE_MERGE_GAP  5e-6
+#define TRACE_MERGE_SPAN 1e-3
+#define TRACE_LINE_DETAIL 4096
+typedef struct { char name[16]; const char* cat; double t0, dur; long arg, spans; } TraceEvent;
+typedef struct { int on, detail; FILE* fp; double base; TraceEvent* ev; int n; long budget, written, flushes, limited; } TraceBuf;
+static TraceBuf g_trace;
+
+static void trace_write_local(const TraceEvent* e){
+    fprintf(g_trace.fp,",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1",
+            e->name,e->cat,1e6*(e->t0-g_trace.base),1e6*e->dur);
+    if(e->arg>=0 && e->spans>1) fprintf(g_trace.fp,",\"args\":{\"n\":%ld,\"spans\":%ld}",e->arg,e->spans);
+    else if(e->arg>=0) fprintf(g_trace.fp,",\"args\":{\"n\":%ld}",e->arg);
+    fputc('}',g_trace.fp);
+}
+static void trace_flush_local(void){
+    int i;
+    if(!g_trace.on || g_trace.n==0) return;
+    for(i=0;i<g_trace.n;++i) trace_write_local(&g_trace.ev[i]);
+    fflush(g_trace.fp);
+    g_trace.written+=g_trace.n; g_trace.flushes++;
+    g_trace.n=0;
+}
+/* ¼ t0 ڵ䣻name ضϵ 15 ֽҲ뷴бܣ̶ƣarg<0 ʾ޲ */
+static void trace_event_local(const char* name,const char* cat,double t0,long arg){
+    TraceEvent* e; double now=calc_now(); size_t k;
+    if(g_trace.n>0){
+        e=&g_trace.ev[g_trace.n-1];
+        if(e->cat==cat && t0-(e->t0+e->dur)<TRACE_MERGE_GAP && e->dur<TRACE_MERGE_SPAN && strncmp(e->name,name,sizeof(e->name)-1)==0){
+            e->dur=now-e->t0; e->arg+=arg; e->spans++;
+            return;
+        }
+    }
+    if(g_trace.n==TRACE_BUF_EVENTS){   /* ͵ддҲΪһ¼ */
+        double tf=calc_now();
+        trace_flush_local();
+        e=&g_trace.ev[g_trace.n++];
+        strcpy(e->name,"trace_flush"); e->cat="trace"; e->t0=tf; e->dur=calc_now()-tf; e->arg=TRACE_BUF_EVENTS; e->spans=1;
+    }
+    e=&g_trace.ev[g_trace.n++];
+    for(k=0;k<sizeof(e->name)-1 && name[k] && name[k]!='"' && name[k]!='\\';++k) e->name[k]=name[k];
+    e->name[k]='\0';
+    e->cat=cat; e->t0=t0; e->dur=now-t0; e->arg=arg; e->spans=1;
+    if(g_trace.detail && --g_trace.budget<=0){
+        g_trace.detail=0; g_trace.limited++;
+        trace_event_local("detail_limit","trace",calc_now(),TRACE_LINE_DETAIL);
+    }
+}
+/* µУָϸ̽Ķ */
+static void trace_line_begin_local(void){ g_trace.detail=g_trace.on; g_trace.budget=TRACE_LINE_DETAIL; }
+static int trace_open_local(const char* file){
+    g_trace.ev=(TraceEvent*)calc_malloc(MEM_OTHER,sizeof(TraceEvent)*TRACE_BUF_EVENTS);
+    if(!g_trace.ev || !(g_trace.fp=fopen(file,"w"))){ calc_free(g_trace.ev); g_trace.ev=NULL; return 0; }
+    g_trace.base=calc_now(); g_trace.n=0; g_trace.written=0; g_trace.flushes=0; g_trace.limited=0; g_trace.on=1;
+    trace_line_begin_local();
+    fprintf(g_trace.fp,"[{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"tui_calc\"}}");
+    return 1;
+}
+static void trace_close_local(void){
+    if(!g_trace.on) return;
+    trace_flush_local();
+    fprintf(g_trace.fp,",\n{\"name\":\"trace_stats\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"events\":%ld,\"flushes\":%ld,\"detail_limited_lines\":%ld,\"clock\":\"%s\"}}\n]\n",
+            g_trace.written,g_trace.flushes,g_trace.limited,calc_clock_name());
+    fclose(g_trace.fp);
+    calc_free(g_trace.ev); g_trace.ev=NULL; g_trace.on=0; g_trace.detail=0;
+}
 
 /* ------------ Ƕģʽ ------------ */
 typedef enum { MODE_RAD=0, MODE_DEG=1 } AngleMode;
 static AngleMode g_mode = MODE_RAD;
 static double to_radian(double x){ return (g_mode==MODE_DEG)? x*M_PI/180.0 : x; }
 static double from_radian(double x){ return (g_mode==MODE_DEG)? x*180.0/M_PI : x; }
+/* ٽģʽӰ /plot /plot2d /sweep /montecarlo ֵ */
+static int g_fast = 0;
 
 /* ------------ ʷ ------------ */
 typedef struct {
@@ -72,14 +470,14 @@ static double g_memory      = 0.0;
 
 static char* dupstr_local(const char* s){
     size_t n = strlen(s)+1;
-    char* p = (char*)malloc(n);
+    char* p = (char*)calc_pool_alloc(MEM_HISTORY,n);
     if(p) memcpy(p,s,n);
     return p;
 }
 static void history_add(const char* expr,double value,int ok,const char* errmsg){
     if(g_hist_count==MAX_HISTORY){
         int i;
-        if(g_hist[0].expr) free(g_hist[0].expr);
+        calc_pool_free(g_hist[0].expr);
         for(i=1;i<MAX_HISTORY;++i) g_hist[i-1]=g_hist[i];
         g_hist_count--;
     }
@@ -164,10 +562,1051 @@ static void vars_init_defaults(void){
     var_set("ans", 0.0);
 }
 
+/* ------------ ˫˫/prec dd ------------
+ * δֵ hi+lo|lo|<=ulp(hi)/2ʾԼ 106 λЧλ~31 λʮƣ
+ * 任TwoSumKnuth TwoProdC89 û fma˻ Dekker 
+ * 2^27+1 ָܴ |x| Сٲ֡hi Ϊ inf ʱ lo  0 inf-inf
+ *  NaN  hiӦ double ·һʾ inf */
+typedef struct { double hi, lo; } CalcDD;
+
+static CalcDD dd_make(double hi,double lo){ CalcDD r; r.hi=hi; r.lo=lo; return r; }
+static CalcDD dd_quick_two_sum(double a,double b){
+    double s=a+b;
+    if(!isfinite(s)) return dd_make(s,0.0);
+    return dd_make(s,b-(s-a));
+}
+static CalcDD dd_two_sum(double a,double b){
+    double s=a+b, bb=s-a;
+    if(!isfinite(s)) return dd_make(s,0.0);
+    return dd_make(s,(a-(s-bb))+(b-bb));
+}
+static void dd_split(double a,double* hi,double* lo){
+    double t;
+    if(a>6.69692879491417e+299 || a<-6.69692879491417e+299){
+        /* С 2^28 ٲ֣ (2^27+1)*a  */
+        a*=3.7252902984619140625e-09;
+        t=134217729.0*a; *hi=t-(t-a); *lo=a-*hi;
+        *hi*=268435456.0; *lo*=268435456.0;
+        return;
+    }
+    t=134217729.0*a;   /* 2^27+1 */
+    *hi=t-(t-a); *lo=a-*hi;
+}
+static CalcDD dd_two_prod(double a,double b){
+    double p=a*b, ah,al,bh,bl;
+    if(!isfinite(p)) return dd_make(p,0.0);
+    dd_split(a,&ah,&al); dd_split(b,&bh,&bl);
+    return dd_make(p,((ah*bh-p)+ah*bl+al*bh)+al*bl);
+}
+static CalcDD dd_add(CalcDD a,CalcDD b){
+    CalcDD s=dd_two_sum(a.hi,b.hi), t=dd_two_sum(a.lo,b.lo);
+    s.lo+=t.hi; s=dd_quick_two_sum(s.hi,s.lo);
+    s.lo+=t.lo; return dd_quick_two_sum(s.hi,s.lo);
+}
+static CalcDD dd_neg(CalcDD a){ return dd_make(-a.hi,-a.lo); }
+static CalcDD dd_sub(CalcDD a,CalcDD b){ return dd_add(a,dd_neg(b)); }
+static CalcDD dd_add_d(CalcDD a,double b){
+    CalcDD s=dd_two_sum(a.hi,b);
+    s.lo+=a.lo; return dd_quick_two_sum(s.hi,s.lo);
+}
+static CalcDD dd_mul(CalcDD a,CalcDD b){
+    CalcDD p=dd_two_prod(a.hi,b.hi);
+    if(!isfinite(p.hi)) return p;
+    p.lo+=a.hi*b.lo+a.lo*b.hi;
+    return dd_quick_two_sum(p.hi,p.lo);
+}
+static CalcDD dd_mul_d(CalcDD a,double b){
+    CalcDD p=dd_two_prod(a.hi,b);
+    if(!isfinite(p.hi)) return p;
+    p.lo+=a.lo*b;
+    return dd_quick_two_sum(p.hi,p.lo);
+}
+/* ̷ */
+static CalcDD dd_div(CalcDD a,CalcDD b){
+    double q1=a.hi/b.hi, q2, q3; CalcDD r, q;
+    r=dd_sub(a,dd_mul_d(b,q1)); q2=r.hi/b.hi;
+    r=dd_sub(r,dd_mul_d(b,q2)); q3=r.hi/b.hi;
+    q=dd_quick_two_sum(q1,q2);
+    return dd_add_d(q,q3);
+}
+static CalcDD dd_div_d(CalcDD a,double b){ return dd_div(a,dd_make(b,0.0)); }
+static CalcDD dd_ldexp(CalcDD a,int e){ return dd_make(ldexp(a.hi,e),ldexp(a.lo,e)); }
+static CalcDD dd_sqr(CalcDD a){ return dd_mul(a,a); }
+
+static const CalcDD DD_PI     ={3.14159265358979312e+00, 1.22464679914735321e-16};
+static const CalcDD DD_2PI    ={6.28318530717958623e+00, 2.44929359829470641e-16};
+static const CalcDD DD_PI2    ={1.57079632679489656e+00, 6.12323399573676604e-17};
+static const CalcDD DD_E      ={2.71828182845904509e+00, 1.44564689172925016e-16};
+static const CalcDD DD_LN2    ={6.93147180559945286e-01, 2.31904681384629956e-17};
+static const CalcDD DD_LN10   ={2.30258509299404590e+00,-2.17075622338224935e-16};
+static const CalcDD DD_PI_180 ={1.74532925199432955e-02, 2.94865227087016869e-19};
+#define DD_EPS 4.93038065763132e-32   /* 2^-104 */
+
+/* 1/i!i<DD_NFACT״ʹʱ˫˫ɣԳ˷ */
+#define DD_NFACT 32
+static const CalcDD* dd_inv_fact(void){
+    static CalcDD t[DD_NFACT]; static int ready=0;
+    int i;
+    if(!ready){
+        CalcDD f={1.0,0.0};
+        for(i=0;i<DD_NFACT;++i){
+            if(i>1) f=dd_mul_d(f,(double)i);
+            t[i]=dd_div(dd_make(1.0,0.0),f);
+        }
+        ready=1;
+    }
+    return t;
+}
+
+/* ݣƳ˷n<0 ʱȡ */
+static CalcDD dd_powi(CalcDD a,long n){
+    CalcDD r=dd_make(1.0,0.0), b=a; long m=n<0? -n : n;
+    while(m){ if(m&1) r=dd_mul(r,b); m>>=1; if(m) b=dd_sqr(b); }
+    return n<0? dd_div(dd_make(1.0,0.0),r) : r;
+}
+/* sqrtһ NewtonKarp ɣa<0 ʱ÷ */
+static CalcDD dd_sqrt(CalcDD a){
+    double x, ax; CalcDD r;
+    if(a.hi<=0.0) return dd_make(a.hi==0.0? 0.0 : NAN,0.0);
+    x=1.0/sqrt(a.hi); ax=a.hi*x;
+    r=dd_sub(a,dd_two_prod(ax,ax));
+    return dd_two_sum(ax,r.hi*x*0.5);
+}
+/* exp ln2 ԼС 2^9  Taylorƽ 9  */
+static CalcDD dd_exp(CalcDD a){
+    double k; CalcDD r, s, p, t; int i; const CalcDD* inv=dd_inv_fact();
+    if(a.hi>709.78) return dd_make(HUGE_VAL,0.0);
+    if(a.hi<-745.2) return dd_make(0.0,0.0);
+    if(a.hi==0.0) return dd_make(1.0,0.0);
+    k=floor(a.hi/DD_LN2.hi+0.5);
+    r=dd_ldexp(dd_sub(a,dd_mul_d(DD_LN2,k)),-9);
+    s=r; p=r;
+    for(i=2;i<DD_NFACT;++i){
+        p=dd_mul(p,r); t=dd_mul(p,inv[i]);
+        s=dd_add(s,t);
+        if(fabs(t.hi)<=DD_EPS*1e-3) break;
+    }
+    for(i=0;i<9;++i) s=dd_add(dd_ldexp(s,1),dd_sqr(s));   /* e^(2r)-1 = 2s+s^2 */
+    s=dd_add_d(s,1.0);
+    return dd_ldexp(s,(int)k);
+}
+/* lnȲ 2 ʹ m[1/2,2) e^(-x) 
+ * m ӽ 1 ʱ 2atanh((m-1)/(m+1)) סԾȣ
+ *  double Ϊֵһ Newtonx += me^(-x) - 1 */
+static CalcDD dd_log(CalcDD a){
+    CalcDD x, m; int k, i;
+    if(a.hi==1.0 && a.lo==0.0) return dd_make(0.0,0.0);
+    frexp(a.hi,&k);
+    m=dd_ldexp(a,-k);
+    if(m.hi<0.70710678118654752){ m=dd_ldexp(m,1); k--; }
+    if(fabs(m.hi-1.0)<0.125){
+        CalcDD sq, t, s2;
+        sq=dd_div(dd_add_d(m,-1.0),dd_add_d(m,1.0));
+        s2=dd_sqr(sq); t=sq; x=sq;
+        for(i=3;i<80 && sq.hi!=0.0;i+=2){
+            CalcDD term;
+            t=dd_mul(t,s2); term=dd_div_d(t,(double)i);
+            x=dd_add(x,term);
+            if(fabs(term.hi)<=DD_EPS*1e-3*fabs(x.hi)) break;
+        }
+        x=dd_ldexp(x,1);
+    }else{
+        x=dd_make(log(m.hi),0.0);
+        x=dd_add_d(dd_add(x,dd_mul(m,dd_exp(dd_neg(x)))),-1.0);
+    }
+    return k? dd_add(x,dd_mul_d(DD_LN2,(double)k)) : x;
+}
+/* |r|<=/4 ϵ Taylor  */
+static CalcDD dd_sin_taylor(CalcDD r){
+    CalcDD s=r, p=r, t, r2=dd_neg(dd_sqr(r)); int i; const CalcDD* inv=dd_inv_fact();
+    if(r.hi==0.0) return r;
+    for(i=3;i<DD_NFACT;i+=2){
+        p=dd_mul(p,r2); t=dd_mul(p,inv[i]);   /* (-1)^k r^(2k+1)/(2k+1)! */
+        s=dd_add(s,t);
+        if(fabs(t.hi)<=DD_EPS*1e-3*fabs(s.hi)) break;
+    }
+    return s;
+}
+static CalcDD dd_cos_taylor(CalcDD r){
+    CalcDD s=dd_make(1.0,0.0), p=s, t, r2=dd_neg(dd_sqr(r)); int i; const CalcDD* inv=dd_inv_fact();
+    for(i=2;i<DD_NFACT;i+=2){
+        p=dd_mul(p,r2); t=dd_mul(p,inv[i]);
+        s=dd_add(s,t);
+        if(fabs(t.hi)<=DD_EPS*1e-3) break;
+    }
+    return s;
+}
+/* Ȱ 2Сٰ /2 Լ*q Ϊ */
+static CalcDD dd_reduce_pio2(CalcDD a,int* q){
+    double z=floor(a.hi/DD_2PI.hi+0.5), j;
+    CalcDD r=dd_sub(a,dd_mul_d(DD_2PI,z));
+    j=floor(r.hi/DD_PI2.hi+0.5);
+    r=dd_sub(r,dd_mul_d(DD_PI2,j));
+    *q=((int)j+4)&3;
+    return r;
+}
+static CalcDD dd_sin(CalcDD a){
+    int q; CalcDD r=dd_reduce_pio2(a,&q);
+    switch(q){
+        case 0: return dd_sin_taylor(r);
+        case 1: return dd_cos_taylor(r);
+        case 2: return dd_neg(dd_sin_taylor(r));
+        default: return dd_neg(dd_cos_taylor(r));
+    }
+}
+static CalcDD dd_cos(CalcDD a){
+    int q; CalcDD r=dd_reduce_pio2(a,&q);
+    switch(q){
+        case 0: return dd_cos_taylor(r);
+        case 1: return dd_neg(dd_sin_taylor(r));
+        case 2: return dd_neg(dd_cos_taylor(r));
+        default: return dd_sin_taylor(r);
+    }
+}
+/* atan2double ֵһ Newton |x||y| ϴѡʽ */
+static CalcDD dd_atan2(CalcDD y,CalcDD x){
+    CalcDD r, xx, yy, z, sz, cz;
+    if(x.hi==0.0 && y.hi==0.0) return dd_make(0.0,0.0);
+    if(x.hi==0.0) return y.hi>0? DD_PI2 : dd_neg(DD_PI2);
+    if(y.hi==0.0) return x.hi>0? dd_make(0.0,0.0) : DD_PI;
+    r=dd_sqrt(dd_add(dd_sqr(x),dd_sqr(y)));
+    xx=dd_div(x,r); yy=dd_div(y,r);
+    z=dd_make(atan2(y.hi,x.hi),0.0);
+    sz=dd_sin(z); cz=dd_cos(z);
+    if(fabs(xx.hi)>fabs(yy.hi)) z=dd_add(z,dd_div(dd_sub(yy,sz),cz));
+    else z=dd_sub(z,dd_div(dd_sub(xx,cz),sz));
+    return z;
+}
+
+static CalcDD dd_floor(CalcDD a){
+    double f=floor(a.hi);
+    return (f==a.hi)? dd_quick_two_sum(f,floor(a.lo)) : dd_make(f,0.0);
+}
+static int dd_less(CalcDD a,CalcDD b){ return a.hi<b.hi || (a.hi==b.hi && a.lo<b.lo); }
+/* sinh|x|<0.5  Taylor e^x-e^-x  exp */
+static CalcDD dd_sinh(CalcDD a){
+    CalcDD s, t, a2; int i;
+    if(fabs(a.hi)>=0.5){
+        CalcDD e=dd_exp(a);
+        return dd_ldexp(dd_sub(e,dd_div(dd_make(1.0,0.0),e)),-1);
+    }
+    s=a; t=a; a2=dd_sqr(a);
+    for(i=1;i<30 && a.hi!=0.0;++i){
+        t=dd_div_d(dd_mul(t,a2),(double)((2*i)*(2*i+1)));
+        s=dd_add(s,t);
+        if(fabs(t.hi)<=DD_EPS*1e-3*fabs(s.hi)) break;
+    }
+    return s;
+}
+static CalcDD dd_cosh(CalcDD a){
+    CalcDD e=dd_exp(a);
+    return dd_ldexp(dd_add(e,dd_div(dd_make(1.0,0.0),e)),-1);
+}
+
+/* ʮƴ -> ˫˫λۼӺ 10 ţs Ϊ strtod ѽܵı */
+static CalcDD dd_parse_local(const char* s,size_t len){
+    CalcDD v=dd_make(0.0,0.0); size_t i=0; long e10=0, ex=0; int esg=1, frac=0;
+    for(;i<len;++i){
+        if(s[i]=='.'){ frac=1; continue; }
+        if(s[i]<'0' || s[i]>'9') break;
+        v=dd_add_d(dd_mul_d(v,10.0),(double)(s[i]-'0'));
+        if(frac) e10--;
+    }
+    if(i<len && (s[i]=='e' || s[i]=='E')){
+        i++;
+        if(i<len && (s[i]=='+' || s[i]=='-')){ if(s[i]=='-') esg=-1; i++; }
+        for(;i<len && s[i]>='0' && s[i]<='9';++i) if(ex<10000) ex=ex*10+(s[i]-'0');
+    }
+    e10+=esg*ex;
+    if(e10>0) v=dd_mul(v,dd_powi(dd_make(10.0,0.0),e10));
+    else if(e10<0) v=dd_div(v,dd_powi(dd_make(10.0,0.0),-e10));
+    return v;
+}
+/* ˫˫ -> ʮƣsig λЧ֣ʽͬ %.{sig}gȥĩβ 0 */
+static void dd_format_local(CalcDD a,int sig,char* out,size_t n){
+    char dg[48], body[64]; int e10, i, k, neg=0, nd;   /* sig<=40d[]  42 λ */
+    CalcDD r;
+    if(a.hi!=a.hi){ snprintf(out,n,"nan"); return; }
+    if(a.hi==0.0){ snprintf(out,n,"0"); return; }
+    if(a.hi>DBL_MAX || a.hi<-DBL_MAX){ snprintf(out,n,a.hi>0? "inf" : "-inf"); return; }
+    if(sig>40) sig=40;
+    if(a.hi<0){ neg=1; a=dd_neg(a); }
+    e10=(int)floor(log10(a.hi));
+    r=(e10>=0)? dd_div(a,dd_powi(dd_make(10.0,0.0),e10)) : dd_mul(a,dd_powi(dd_make(10.0,0.0),-e10));
+    if(r.hi>=10.0){ r=dd_div_d(r,10.0); e10++; }
+    if(r.hi<1.0){ r=dd_mul_d(r,10.0); e10--; }
+    /* ȡλһλλΪ 0 ʱƣһλ룩λֵܶԽ磬ͳһλ */
+    nd=sig+2;
+    {
+        int d[48];
+        for(i=0;i<nd;++i){
+            d[i]=(int)floor(r.hi);
+            r=dd_mul_d(dd_add_d(r,(double)-d[i]),10.0);
+        }
+        for(i=nd-1;i>0;--i){
+            while(d[i]<0){ d[i]+=10; d[i-1]--; }
+            while(d[i]>9){ d[i]-=10; d[i-1]++; }
+        }
+        if(d[0]==0){ for(i=0;i<nd-1;++i) d[i]=d[i+1]; e10--; }
+        nd=sig+1;
+        if(d[nd-1]>=5){
+            d[nd-2]++;
+            for(i=nd-2;i>0 && d[i]>9;--i){ d[i]-=10; d[i-1]++; }
+        }
+        if(d[0]>9){ d[0]=1; for(i=1;i<sig;++i) d[i]=0; e10++; }
+        for(i=0;i<sig;++i) dg[i]=(char)('0'+d[i]);
+    }
+    k=sig; while(k>1 && dg[k-1]=='0') k--;
+    dg[k]='\0';
+    if(e10<-5 || e10>=sig){
+        if(k>1) snprintf(body,sizeof(body),"%c.%se%+d",dg[0],dg+1,e10);
+        else snprintf(body,sizeof(body),"%ce%+d",dg[0],e10);
+    }else if(e10>=0){
+        if(k>e10+1) snprintf(body,sizeof(body),"%.*s.%s",e10+1,dg,dg+e10+1);
+        else{
+            snprintf(body,sizeof(body),"%s",dg);
+            for(i=k;i<=e10;++i) body[i]='0';
+            body[e10+1]='\0';
+        }
+    }else{
+        size_t p=0;
+        body[p++]='0'; body[p++]='.';
+        for(i=0;i<-e10-1;++i) body[p++]='0';
+        snprintf(body+p,sizeof(body)-p,"%s",dg);
+    }
+    snprintf(out,n,"%s%s",neg? "-" : "",body);
+}
+
+/* ------------ /exact ------------
+ * ΪС 32 λ limb ľֵ飬n=0 ʾ 0 BIG_MAX_LIMBS  limb
+ *  num/den λden>0ǿֻڹģϴԼʱ
+ * һ gcdԼ֣ĸΪ 1 ĸͬļӼֱڷɡ
+ * gcd ڶ limb ʱ Lehmer 㷨ǰ 32 λģŷò裬ۼƵ 2x2
+ * һõȫ 64 λںö gcd
+ * ʧܣ޻ڴ治㣩ʱ 0÷ͳһȷ󡱡 */
+#define BIG_MAX_LIMBS   131072 /* Լ 126 λʮ */
+#define BIG_HARD_LIMBS  (2*BIG_MAX_LIMBS+8)   /* Barrett мԼΪ */
+#define RAT_LAZY_SLACK  4      /* С limb Լ */
+typedef struct { calc_u32* d; int n, cap; } CalcBig;
+typedef struct { int neg; CalcBig num, den; int nred; } CalcRat;   /* nredϴԼֺ num.n+den.n */
+
+static void big_init(CalcBig* a){ a->d=NULL; a->n=0; a->cap=0; }
+static void big_free(CalcBig* a){ calc_free(a->d); big_init(a); }
+static int big_reserve(CalcBig* a,int n){
+    calc_u32* p; int c;
+    if(n<=a->cap) return 1;
+    if(n>BIG_HARD_LIMBS) return 0;
+    c=a->cap? a->cap : 4;
+    while(c<n) c*=2;
+    p=(calc_u32*)calc_realloc(MEM_BIGNUM,a->d,sizeof(calc_u32)*(size_t)c);
+    if(!p) return 0;
+    a->d=p; a->cap=c; return 1;
+}
+static void big_trim(CalcBig* a){ while(a->n>0 && a->d[a->n-1]==0) a->n--; }
+static int big_set_u64(CalcBig* a,calc_u64 v){
+    if(!big_reserve(a,2)) return 0;
+    a->d[0]=(calc_u32)v; a->d[1]=(calc_u32)(v>>32); a->n=2; big_trim(a);
+    return 1;
+}
+static int big_copy(CalcBig* r,const CalcBig* a){
+    if(r==a) return 1;
+    if(!big_reserve(r,a->n)) return 0;
+    if(a->n) memcpy(r->d,a->d,sizeof(calc_u32)*(size_t)a->n);
+    r->n=a->n; return 1;
+}
+static void big_swap(CalcBig* a,CalcBig* b){ CalcBig t=*a; *a=*b; *b=t; }
+static int big_is_one(const CalcBig* a){ return a->n==1 && a->d[0]==1; }
+static calc_u64 big_low64(const CalcBig* a){
+    return (a->n>1)? CALC_U64(a->d[1],a->d[0]) : (a->n? (calc_u64)a->d[0] : 0);
+}
+static int big_cmp(const CalcBig* a,const CalcBig* b){
+    int i;
+    if(a->n!=b->n) return (a->n<b->n)? -1 : 1;
+    for(i=a->n-1;i>=0;--i) if(a->d[i]!=b->d[i]) return (a->d[i]<b->d[i])? -1 : 1;
+    return 0;
+}
+static int big_bits(const CalcBig* a){
+    int b=0; calc_u32 t;
+    if(a->n==0) return 0;
+    for(t=a->d[a->n-1];t;t>>=1) b++;
+    return (a->n-1)*32+b;
+}
+static int big_ctz(const CalcBig* a){
+    int i=0, b=0; calc_u32 t;
+    if(a->n==0) return 0;
+    while(a->d[i]==0) i++;
+    for(t=a->d[i];!(t&1);t>>=1) b++;
+    return i*32+b;
+}
+/*  sh λ 32 λ */
+static calc_u32 big_extract32(const CalcBig* a,int sh){
+    int w=sh/32, b=sh%32;
+    calc_u64 lo=(w<a->n)? a->d[w] : 0, hi=(w+1<a->n)? a->d[w+1] : 0;
+    return (calc_u32)(((hi<<32)|lo)>>b);
+}
+/* r=a+br  ab ͬ */
+static int big_add(CalcBig* r,const CalcBig* a,const CalcBig* b){
+    int i, n; calc_u64 c=0;
+    if(a->n<b->n){ const CalcBig* t=a; a=b; b=t; }
+    n=a->n;
+    if(!big_reserve(r,n+1)) return 0;
+    for(i=0;i<n;++i){
+        c+=(calc_u64)a->d[i]+(i<b->n? b->d[i] : 0);
+        r->d[i]=(calc_u32)c; c>>=32;
+    }
+    r->d[n]=(calc_u32)c; r->n=n+1; big_trim(r);
+    return 1;
+}
+/* r=a-bҪ a>=br  ab ͬ */
+static int big_sub(CalcBig* r,const CalcBig* a,const CalcBig* b){
+    int i, n=a->n; calc_u64 br=0;
+    if(!big_reserve(r,n)) return 0;
+    for(i=0;i<n;++i){
+        calc_u64 t=(calc_u64)a->d[i]-(i<b->n? b->d[i] : 0)-br;
+        r->d[i]=(calc_u32)t; br=(t>>63)&1;
+    }
+    r->n=n; big_trim(r);
+    return 1;
+}
+/* a=a*m+c */
+static int big_mul_small(CalcBig* a,calc_u32 m,calc_u32 c){
+    int i; calc_u64 t=c;
+    if(!big_reserve(a,a->n+1)) return 0;
+    for(i=0;i<a->n;++i){
+        t+=(calc_u64)a->d[i]*m;
+        a->d[i]=(calc_u32)t; t>>=32;
+    }
+    a->d[a->n++]=(calc_u32)t; big_trim(a);
+    return 1;
+}
+/* a=a/m */
+static calc_u32 big_div_small(CalcBig* a,calc_u32 m){
+    calc_u64 r=0; int i;
+    for(i=a->n-1;i>=0;--i){
+        r=(r<<32)|a->d[i];
+        a->d[i]=(calc_u32)(r/m); r%=m;
+    }
+    big_trim(a);
+    return (calc_u32)r;
+}
+/* ---- ˷̿˷ + Karatsuba ----
+ *  KARA_THRESH  limb ʱ (a1+a0)(b1+b0) 룬
+ * м (a0+a1)(b0+b1)-a0b0-a1b1 õεݹĴΣӶ O(n^1.585)
+ * ʱѳһ̵ĳȷֿ飬 Karatsuba ٴλۼӡ */
+#define KARA_THRESH 32
+/* r[0..na+nb) = a*bÿ˴ a λr Ķд룬λɲ */
+static void limb_mul_school(calc_u32* r,const calc_u32* a,int na,const calc_u32* b,int nb){
+    int i=0, j;
+    memset(r,0,sizeof(calc_u32)*(size_t)(na+nb));
+    for(;i+1<na;i+=2){
+        calc_u64 a0=a[i], a1=a[i+1], c0=0, c1=0, t0, t1, bp=0;
+        for(j=0;j<nb;++j){
+            t0=a0*b[j]+r[i+j]+c0; c0=t0>>32;
+            t1=a1*bp+(calc_u32)t0+c1; c1=t1>>32;
+            r[i+j]=(calc_u32)t1; bp=b[j];
+        }
+        t1=a1*bp+c0+c1;
+        r[i+nb]=(calc_u32)t1; r[i+nb+1]=(calc_u32)(t1>>32);
+    }
+    if(i<na){
+        calc_u64 c=0, ai=a[i];
+        for(j=0;j<nb;++j){
+            c+=ai*b[j]+r[i+j];
+            r[i+j]=(calc_u32)c; c>>=32;
+        }
+        r[i+nb]=(calc_u32)c;
+    }
+}
+/* r[0..na] = a+bna>=nb */
+static void limb_add(calc_u32* r,const calc_u32* a,int na,const calc_u32* b,int nb){
+    calc_u64 c=0; int i;
+    for(i=0;i<nb;++i){ c+=(calc_u64)a[i]+b[i]; r[i]=(calc_u32)c; c>>=32; }
+    for(;i<na;++i){ c+=a[i]; r[i]=(calc_u32)c; c>>=32; }
+    r[na]=(calc_u32)c;
+}
+/* z[0..nz) += s[0..ns) / -= s[0..ns)ns<=nz÷֤ nz  limb ҷǸ */
+static void limb_add_in(calc_u32* z,int nz,const calc_u32* s,int ns){
+    calc_u64 c=0; int i;
+    for(i=0;i<ns;++i){ c+=(calc_u64)z[i]+s[i]; z[i]=(calc_u32)c; c>>=32; }
+    for(;c && i<nz;++i){ c+=z[i]; z[i]=(calc_u32)c; c>>=32; }
+}
+static void limb_sub_in(calc_u32* z,int nz,const calc_u32* s,int ns){
+    calc_u64 br=0; int i;
+    for(i=0;i<ns;++i){ calc_u64 d=(calc_u64)z[i]-s[i]-br; z[i]=(calc_u32)d; br=(d>>63)&1; }
+    for(;br && i<nz;++i) br=(z[i]--==0);
+}
+/* r[0..2n) = a*b n  limbt Ϊʱ 4n+256  limb */
+static void limb_mul_kara(calc_u32* r,const calc_u32* a,const calc_u32* b,int n,calc_u32* t){
+    int h=n/2, m=n-h;
+    calc_u32 *sa=t, *sb=t+(m+1), *z1=t+2*(m+1), *tt=t+4*(m+1);
+    if(n<KARA_THRESH){ limb_mul_school(r,a,n,b,n); return; }
+    limb_mul_kara(r,a,b,h,tt);                 /* a0*b0 -> r[0..2h) */
+    limb_mul_kara(r+2*h,a+h,b+h,m,tt);         /* a1*b1 -> r[2h..2n) */
+    limb_add(sa,a+h,m,a,h);
+    limb_add(sb,b+h,m,b,h);
+    limb_mul_kara(z1,sa,sb,m+1,tt);            /* (a0+a1)(b0+b1)2m+2  limb */
+    limb_sub_in(z1,2*m+2,r,2*h);
+    limb_sub_in(z1,2*m+2,r+2*h,2*m);
+    limb_add_in(r+h,2*n-h,z1,2*m+2);
+}
+/* r=a*br  ab ͬ */
+static int big_mul(CalcBig* r,const CalcBig* a,const CalcBig* b){
+    CalcBig t; int na, nb;
+    if(a->n==0 || b->n==0){ r->n=0; return 1; }
+    if(a->n<b->n){ const CalcBig* x=a; a=b; b=x; }
+    na=a->n; nb=b->n;
+    big_init(&t);
+    if(!big_reserve(&t,na+nb)) return 0;
+    if(nb<KARA_THRESH) limb_mul_school(t.d,a->d,na,b->d,nb);
+    else{
+        calc_u32* w=(calc_u32*)calc_malloc(MEM_BIGNUM,sizeof(calc_u32)*(size_t)(7*nb+256));
+        calc_u32 *prod=w, *blk=w+2*nb, *tmp=w+3*nb;
+        int off;
+        if(!w){ big_free(&t); return 0; }
+        memset(t.d,0,sizeof(calc_u32)*(size_t)(na+nb));
+        for(off=0;off<na;off+=nb){
+            int len=(na-off<nb)? na-off : nb;
+            if(len==nb) limb_mul_kara(prod,a->d+off,b->d,nb,tmp);
+            else if(len<KARA_THRESH) limb_mul_school(prod,b->d,nb,a->d+off,len);
+            else{   /* ĩ鲻 nb Karatsuba */
+                memcpy(blk,a->d+off,sizeof(calc_u32)*(size_t)len);
+                memset(blk+len,0,sizeof(calc_u32)*(size_t)(nb-len));
+                limb_mul_kara(prod,blk,b->d,nb,tmp);
+            }
+            limb_add_in(t.d+off,na+nb-off,prod,len+nb);
+        }
+        calc_free(w);
+    }
+    t.n=na+nb; big_trim(&t);
+    big_swap(r,&t); big_free(&t);
+    return 1;
+}
+static int big_shl(CalcBig* a,int s){
+    int w=s/32, b=s%32, i;
+    if(a->n==0 || s==0) return 1;
+    if(!big_reserve(a,a->n+w+1)) return 0;
+    a->d[a->n+w]=0;
+    for(i=a->n-1;i>=0;--i){
+        calc_u32 v=a->d[i];
+        if(b){ a->d[i+w+1]|=v>>(32-b); a->d[i+w]=v<<b; }
+        else a->d[i+w]=v;
+    }
+    for(i=0;i<w;++i) a->d[i]=0;
+    a->n+=w+1; big_trim(a);
+    return 1;
+}
+static void big_shr(CalcBig* a,int s){
+    int w=s/32, b=s%32, i;
+    if(w>=a->n){ a->n=0; return; }
+    for(i=0;i<a->n-w;++i){
+        calc_u32 lo=a->d[i+w], hi=(i+w+1<a->n)? a->d[i+w+1] : 0;
+        a->d[i]=b? (lo>>b)|(hi<<(32-b)) : lo;
+    }
+    a->n-=w; big_trim(a);
+}
+/* q=a/b, r=a%bKnuth 㷨 Dqr Ϊ NULLҲ ab ͬb Ϊ 0 */
+static int big_divmod(CalcBig* q,CalcBig* r,const CalcBig* a,const CalcBig* b){
+    CalcBig u, v, qq; int m, n=b->n, j, i, s=0, ok=1; calc_u32 t;
+    if(big_cmp(a,b)<0){
+        if(r && !big_copy(r,a)) return 0;
+        if(q) q->n=0;
+        return 1;
+    }
+    big_init(&u); big_init(&v); big_init(&qq);
+    if(n==1){
+        calc_u32 rem;
+        ok=big_copy(&qq,a);
+        if(ok){
+            rem=big_div_small(&qq,b->d[0]);
+            if(r) ok=big_set_u64(r,rem);
+            if(q) big_swap(q,&qq);
+        }
+        big_free(&qq);
+        return ok;
+    }
+    m=a->n-n;
+    for(t=b->d[n-1];!(t&0x80000000u);t<<=1) s++;
+    ok=big_copy(&u,a) && big_copy(&v,b) && big_shl(&u,s) && big_shl(&v,s)
+       && big_reserve(&u,a->n+1) && big_reserve(&qq,m+1);
+    if(ok){
+        while(u.n<a->n+1) u.d[u.n++]=0;
+        for(j=m;j>=0;--j){
+            calc_u64 num=CALC_U64(u.d[j+n],u.d[j+n-1]), qh=num/v.d[n-1], rh=num%v.d[n-1];
+            calc_u64 c=0, br=0, d;
+            while(qh>0xFFFFFFFFu || qh*v.d[n-2]>((rh<<32)|u.d[j+n-2])){
+                qh--; rh+=v.d[n-1];
+                if(rh>0xFFFFFFFFu) break;
+            }
+            for(i=0;i<n;++i){
+                calc_u64 p=qh*v.d[i]+c;
+                c=p>>32;
+                d=(calc_u64)u.d[i+j]-(calc_u32)p-br;
+                u.d[i+j]=(calc_u32)d; br=(d>>63)&1;
+            }
+            d=(calc_u64)u.d[j+n]-c-br;
+            u.d[j+n]=(calc_u32)d; br=(d>>63)&1;
+            if(br){   /* qh  1ӻһ */
+                c=0; qh--;
+                for(i=0;i<n;++i){ c+=(calc_u64)u.d[i+j]+v.d[i]; u.d[i+j]=(calc_u32)c; c>>=32; }
+                u.d[j+n]+=(calc_u32)c;
+            }
+            qq.d[j]=(calc_u32)qh;
+        }
+        qq.n=m+1; big_trim(&qq);
+        if(r){ u.n=n; big_trim(&u); big_shr(&u,s); big_swap(r,&u); }
+        if(q) big_swap(q,&qq);
+    }
+    big_free(&u); big_free(&v); big_free(&qq);
+    return ok;
+}
+/* r=p*P-q*Q÷֤Ǹ */
+static int big_mulsub2(CalcBig* r,const CalcBig* P,calc_u32 p,const CalcBig* Q,calc_u32 q){
+    int n=(P->n>Q->n)? P->n : Q->n, i; calc_u64 c1=0, c2=0, br=0; CalcBig t;
+    big_init(&t);
+    if(!big_reserve(&t,n+1)) return 0;
+    for(i=0;i<n;++i){
+        calc_u64 x, y, d;
+        c1+=(calc_u64)p*(i<P->n? P->d[i] : 0); x=(calc_u32)c1; c1>>=32;
+        c2+=(calc_u64)q*(i<Q->n? Q->d[i] : 0); y=(calc_u32)c2; c2>>=32;
+        d=x-y-br; t.d[i]=(calc_u32)d; br=(d>>63)&1;
+    }
+    t.d[n]=(calc_u32)(c1-c2-br);
+    t.n=n+1; big_trim(&t);
+    big_swap(r,&t); big_free(&t);
+    return 1;
+}
+static calc_u64 gcd_u64_local(calc_u64 a,calc_u64 b){
+    int k=0; calc_u64 t;
+    if(a==0) return b;
+    if(b==0) return a;
+    while(((a|b)&1)==0){ a>>=1; b>>=1; k++; }
+    while((a&1)==0) a>>=1;
+    do{
+        while((b&1)==0) b>>=1;
+        if(a>b){ t=a; a=b; b=t; }
+        b-=a;
+    }while(b);
+    return a<<k;
+}
+/* g=gcd(a,b)LehmerKnuth 4.5.2 㷨 L32 λǰλ+  gcd */
+static int big_gcd(CalcBig* g,const CalcBig* a,const CalcBig* b){
+    CalcBig u, v, t, w; int ok;
+    big_init(&u); big_init(&v); big_init(&t); big_init(&w);
+    ok=big_copy(&u,a) && big_copy(&v,b);
+    if(ok && big_cmp(&u,&v)<0) big_swap(&u,&v);
+    while(ok && v.n>2){
+        int sh=big_bits(&u)-32;
+        calc_s64 uh=big_extract32(&u,sh), vh=big_extract32(&v,sh);
+        calc_s64 A=1, B=0, C=0, D=1, q, nc, nd;
+        while(vh+C!=0 && vh+D!=0){
+            q=(uh+A)/(vh+C);
+            if(q!=(uh+B)/(vh+D)) break;
+            nc=A-q*C; nd=B-q*D;
+            if(nc>(calc_s64)0xFFFFFFFFu || -nc>(calc_s64)0xFFFFFFFFu || nd>(calc_s64)0xFFFFFFFFu || -nd>(calc_s64)0xFFFFFFFFu) break;
+            A=C; C=nc; B=D; D=nd;
+            nc=uh-q*vh; uh=vh; vh=nc;
+        }
+        if(B==0){
+            ok=big_divmod(NULL,&t,&u,&v);
+            if(ok){ big_swap(&u,&v); big_swap(&v,&t); }
+        }else{
+            /* (A,B)(C,D) ţϽǸ */
+            ok=(B<=0)? big_mulsub2(&t,&u,(calc_u32)A,&v,(calc_u32)-B)
+                     : big_mulsub2(&t,&v,(calc_u32)B,&u,(calc_u32)-A);
+            if(ok) ok=(D<=0)? big_mulsub2(&w,&u,(calc_u32)C,&v,(calc_u32)-D)
+                            : big_mulsub2(&w,&v,(calc_u32)D,&u,(calc_u32)-C);
+            if(ok){ big_swap(&u,&t); big_swap(&v,&w); }
+        }
+    }
+    if(ok && v.n==0) big_swap(g,&u);
+    else{
+        if(ok && u.n>2) ok=big_divmod(NULL,&u,&u,&v);
+        if(ok) ok=big_set_u64(g,gcd_u64_local(big_low64(&u),big_low64(&v)));
+    }
+    big_free(&u); big_free(&v); big_free(&t); big_free(&w);
+    return ok;
+}
+/* Vfloor(2^(2n)/D)n=bits(D)Сģֱӳģȶ D ĸ hn/2 λݹ Vh
+ * һţٵ X1=X0+X0*(2^(2n)-D*X0)/2^(2n)X0=Vh*2^(n-h)ȷ
+ * X0 λȫΪ 0Ҳֻ豣λγ˷ֻа볤ܲλ
+ *  big_divmod_pre ա */
+#define RECIP_BASE_LIMBS 48
+static int big_recip(CalcBig* V,const CalcBig* D){
+    int n=big_bits(D), h, s, ok, over=0;
+    CalcBig X, T, E;
+    big_init(&X); big_init(&T); big_init(&E);
+    if(D->n<=RECIP_BASE_LIMBS){
+        ok=big_set_u64(&E,1) && big_shl(&E,2*n) && big_divmod(V,NULL,&E,D);
+        big_free(&E);
+        return ok;
+    }
+    h=n/2+32;   /* λֶ 32 λλ */
+    ok=big_copy(&T,D);
+    if(ok){ big_shr(&T,n-h); ok=big_recip(&X,&T); }
+    ok=ok && big_mul(&T,D,&X) && big_shl(&T,n-h) && big_set_u64(&E,1) && big_shl(&E,2*n);
+    if(ok){
+        over=(big_cmp(&T,&E)>0);
+        ok=over? big_sub(&E,&T,&E) : big_sub(&E,&E,&T);   /* E=|2^(2n)-D*X0| */
+    }
+    if(ok){
+        s=big_bits(&E)-(n-h)-32;   /* ֻԼ n-h λЧE ͬλټӱλ */
+        if(s<0) s=0;
+        big_shr(&E,s);
+        ok=big_mul(&T,&X,&E);
+    }
+    if(ok){
+        big_shr(&T,n+h-s);
+        ok=big_shl(&X,n-h) && (over? big_sub(&X,&X,&T) : big_add(&X,&X,&T));
+    }
+    if(ok) big_swap(V,&X);
+    big_free(&X); big_free(&T); big_free(&E);
+    return ok;
+}
+/* q=a/D, r=a%DBarrettҪ a<2^(2n)V=big_recip(D)qr  a ͬ
+ * ̹ƫͨ 2 8 ˵׼˻س֤ȷ */
+static int big_divmod_pre(CalcBig* q,CalcBig* r,const CalcBig* a,const CalcBig* D,const CalcBig* V){
+    int n=big_bits(D), k, ok, fixed=0;
+    CalcBig Q, P, one;
+    big_init(&Q); big_init(&P); big_init(&one);
+    ok=big_copy(&Q,a) && big_set_u64(&one,1);
+    if(ok){ big_shr(&Q,n-1); ok=big_mul(&Q,&Q,V); }
+    if(ok){ big_shr(&Q,n+1); ok=big_mul(&P,&Q,D); }
+    for(k=0;ok && k<8 && big_cmp(&P,a)>0;++k) ok=big_sub(&Q,&Q,&one) && big_sub(&P,&P,D);
+    if(ok && big_cmp(&P,a)<=0){
+        ok=big_sub(&P,a,&P);
+        for(k=0;ok && k<8 && big_cmp(&P,D)>=0;++k) ok=big_sub(&P,&P,D) && big_add(&Q,&Q,&one);
+        fixed=ok && big_cmp(&P,D)<0;
+    }
+    if(fixed){
+        if(r) big_swap(r,&P);
+        if(q) big_swap(q,&Q);
+    }else if(ok) ok=big_divmod(q,r,a,D);
+    big_free(&Q); big_free(&P); big_free(&one);
+    return ok;
+}
+
+/* ---- λĽת ----
+ * 2 ݽưλֱз֣O(n)ƷΣȡ P_k=(b^c)^(2^k)b^c Ϊ 32 λ
+ * ݣx<P_k^2 ʱ x=q*P_k+rr ǡò c*2^k λqr  k-1 ݹ飻
+ * Ԥõ Barrett  O(M(n)log n)P_k 䵹ƻ棬
+ * øã RADIX_SMALL_LIMBS ʱ˻̳ */
+#define RADIX_SMALL_LIMBS 40
+#define RADIX_MAX_LEVEL   28
+typedef struct {
+    int base, chunk; calc_u32 bc;
+    int npw, ninv;
+    CalcBig pw[RADIX_MAX_LEVEL], inv[RADIX_MAX_LEVEL];
+} RadixCache;
+static RadixCache g_radix;
+static const char g_digits36[]="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static void radix_reset_local(int base){
+    int i;
+    calc_u64 p=(calc_u64)base;
+    for(i=0;i<g_radix.npw;++i) big_free(&g_radix.pw[i]);
+    for(i=0;i<g_radix.ninv;++i) big_free(&g_radix.inv[i]);
+    g_radix.base=base; g_radix.chunk=1; g_radix.npw=0; g_radix.ninv=0;
+    while(p*(calc_u64)base<=0xFFFFFFFFu){ p*=(calc_u64)base; g_radix.chunk++; }
+    g_radix.bc=(calc_u32)p;
+}
+/* ֤ P_0..P_k ѻ */
+static int radix_level_local(int k){
+    if(k>=RADIX_MAX_LEVEL) return 0;
+    while(g_radix.npw<=k){
+        CalcBig* p=&g_radix.pw[g_radix.npw];
+        big_init(p);
+        if(g_radix.npw==0){ if(!big_set_u64(p,g_radix.bc)) return 0; }
+        else if(!big_mul(p,&g_radix.pw[g_radix.npw-1],&g_radix.pw[g_radix.npw-1])){ big_free(p); return 0; }
+        calc_mem_retag(p->d,MEM_CACHE);
+        g_radix.npw++;
+    }
+    return 1;
+}
+static int radix_inv_local(int k){
+    while(g_radix.ninv<=k){
+        CalcBig* v=&g_radix.inv[g_radix.ninv];
+        big_init(v);
+        if(!big_recip(v,&g_radix.pw[g_radix.ninv])){ big_free(v); return 0; }
+        calc_mem_retag(v->d,MEM_CACHE);
+        g_radix.ninv++;
+    }
+    return 1;
+}
+/*  x дǡ w λ 0 out[0..w)÷֤ x<base^w  x<P_k^2 */
+static int radix_put_local(const CalcBig* x,int k,char* out,long w){
+    int ok=1;
+    while(k>=0 && big_cmp(x,&g_radix.pw[k])<0) k--;   /* Ϊ 0ֱӽ */
+    if(k<0 || x->n<=RADIX_SMALL_LIMBS){
+        CalcBig t; long p=w; int j, b=g_radix.base;
+        big_init(&t);
+        if(!big_copy(&t,x)) return 0;
+        while(p>0){
+            calc_u32 c=t.n? big_div_small(&t,g_radix.bc) : 0;
+            for(j=0;j<g_radix.chunk && p>0;++j){ out[--p]=g_digits36[c%(calc_u32)b]; c/=(calc_u32)b; }
+        }
+        big_free(&t);
+    }else{
+        long wr=(long)g_radix.chunk<<k;
+        CalcBig q, r;
+        big_init(&q); big_init(&r);
+        ok=radix_inv_local(k) && big_divmod_pre(&q,&r,x,&g_radix.pw[k],&g_radix.inv[k])
+           && radix_put_local(&q,k-1,out,w-wr) && radix_put_local(&r,k-1,out+w-wr,wr);
+        big_free(&q); big_free(&r);
+    }
+    return ok;
+}
+/* x  base ƣ2..36ִǰ׺malloc÷ free */
+static char* big_to_base(const CalcBig* x,int base){
+    char* s; long L, i; int lg=0, k=0, ok=1, nb=big_bits(x);
+    while((1<<lg)<base) lg++;
+    if(x->n==0 || (1<<lg)==base){
+        L=x->n? (nb+lg-1)/lg : 1;
+        s=(char*)calc_malloc(MEM_BIGNUM,(size_t)L+1);
+        if(!s) return NULL;
+        for(i=0;i<L;++i) s[L-1-i]=g_digits36[x->n? big_extract32(x,(int)(i*lg))&(calc_u32)(base-1) : 0];
+        s[L]='\0';
+        return s;
+    }
+    L=(long)((double)nb*log(2.0)/log((double)base))+2;
+    s=(char*)calc_malloc(MEM_BIGNUM,(size_t)L+1);
+    if(!s) return NULL;
+    if(g_radix.base!=base) radix_reset_local(base);
+    /* ȡС k ʹ P_k^2 Ȼ x2*(bits(P_k)-1)>=bits(x) */
+    while((ok=radix_level_local(k))!=0 && 2*(big_bits(&g_radix.pw[k])-1)<nb) k++;
+    ok=ok && radix_put_local(x,k,s,L);
+    if(!ok){ calc_free(s); return NULL; }
+    for(i=0;i<L-1 && s[i]=='0';++i) ;
+    memmove(s,s+i,(size_t)(L-i));
+    s[L-i]='\0';
+    return s;
+}
+/* ʮƴmalloc÷ free */
+static char* big_to_dec(const CalcBig* a){ return big_to_base(a,10); }
+
+static void rat_init(CalcRat* q){ q->neg=0; big_init(&q->num); big_init(&q->den); q->nred=0; }
+static void rat_free(CalcRat* q){ big_free(&q->num); big_free(&q->den); q->neg=0; q->nred=0; }
+static int rat_set_u64(CalcRat* q,calc_u64 v,int neg){
+    q->neg=(v!=0) && neg;
+    if(!big_set_u64(&q->num,v) || !big_set_u64(&q->den,1)) return 0;
+    q->nred=q->num.n+1;
+    return 1;
+}
+static int rat_copy(CalcRat* r,const CalcRat* a){
+    if(r==a) return 1;
+    r->neg=a->neg; r->nred=a->nred;
+    return big_copy(&r->num,&a->num) && big_copy(&r->den,&a->den);
+}
+static int rat_is_int(const CalcRat* q){ return big_is_one(&q->den); }
+/* Լȥ 2 ӣٳ Lehmer gcd */
+static int rat_reduce(CalcRat* q){
+    CalcBig g; int ok=1, z;
+    if(q->num.n==0){ q->neg=0; q->nred=1; return big_set_u64(&q->den,1); }
+    if(!rat_is_int(q)){
+        z=big_ctz(&q->num); if(big_ctz(&q->den)<z) z=big_ctz(&q->den);
+        if(z){ big_shr(&q->num,z); big_shr(&q->den,z); }
+        big_init(&g);
+        ok=big_gcd(&g,&q->num,&q->den);
+        if(ok && !big_is_one(&g)) ok=big_divmod(&q->num,NULL,&q->num,&g) && big_divmod(&q->den,NULL,&q->den,&g);
+        big_free(&g);
+    }
+    q->nred=q->num.n+q->den.n;
+    return ok;
+}
+static int rat_lazy_local(CalcRat* q){
+    if(q->num.n+q->den.n>2*q->nred+RAT_LAZY_SLACK) return rat_reduce(q);
+    return 1;
+}
+/* r=absub  0 Ϊr  ab ͬ */
+static int rat_add(CalcRat* r,const CalcRat* a,const CalcRat* b,int sub){
+    CalcBig x, y, d; int bneg=b->neg^(sub && b->num.n), ok, nr;
+    big_init(&x); big_init(&y); big_init(&d);
+    if(big_cmp(&a->den,&b->den)==0)
+        ok=big_copy(&x,&a->num) && big_copy(&y,&b->num) && big_copy(&d,&a->den);
+    else if(rat_is_int(b))
+        ok=big_copy(&x,&a->num) && big_mul(&y,&b->num,&a->den) && big_copy(&d,&a->den);
+    else if(rat_is_int(a))
+        ok=big_mul(&x,&a->num,&b->den) && big_copy(&y,&b->num) && big_copy(&d,&b->den);
+    else
+        ok=big_mul(&x,&a->num,&b->den) && big_mul(&y,&b->num,&a->den) && big_mul(&d,&a->den,&b->den);
+    nr=(a->nred>b->nred)? a->nred : b->nred;
+    if(ok){
+        if(a->neg==bneg){ ok=big_add(&x,&x,&y); r->neg=a->neg; }
+        else if(big_cmp(&x,&y)>=0){ ok=big_sub(&x,&x,&y); r->neg=a->neg; }
+        else{ ok=big_sub(&x,&y,&x); r->neg=bneg; }
+    }
+    if(ok){
+        big_swap(&r->num,&x); big_swap(&r->den,&d);
+        if(r->num.n==0) r->neg=0;
+        r->nred=nr;
+        ok=rat_lazy_local(r);
+    }
+    big_free(&x); big_free(&y); big_free(&d);
+    return ok;
+}
+/* r=a*b  a/bdiv  0÷ȼ 0 */
+static int rat_mul(CalcRat* r,const CalcRat* a,const CalcRat* b,int div){
+    CalcBig x, d; int ok, neg=a->neg^b->neg, nr=a->nred+b->nred;
+    big_init(&x); big_init(&d);
+    ok=big_mul(&x,&a->num,div? &b->den : &b->num) && big_mul(&d,&a->den,div? &b->num : &b->den);
+    if(ok){
+        big_swap(&r->num,&x); big_swap(&r->den,&d);
+        r->neg=(r->num.n!=0) && neg;
+        r->nred=nr;
+        ok=rat_lazy_local(r);
+    }
+    big_free(&x); big_free(&d);
+    return ok;
+}
+/* r=a^nԼ֣ӷĸԶƳ˷صԻأ */
+static int rat_pow(CalcRat* r,const CalcRat* a,long n){
+    CalcRat b; CalcBig pn, pd; int ok, neg; unsigned long e=(n<0)? 0UL-(unsigned long)n : (unsigned long)n;
+    rat_init(&b); big_init(&pn); big_init(&pd);
+    ok=rat_copy(&b,a) && rat_reduce(&b);
+    if(ok && ((double)(big_bits(&b.num)-1)*(double)e>32.0*BIG_MAX_LIMBS
+              || (double)(big_bits(&b.den)-1)*(double)e>32.0*BIG_MAX_LIMBS)) ok=0;
+    if(ok) ok=big_set_u64(&pn,1) && big_set_u64(&pd,1);
+    neg=b.neg && (e&1);
+    while(ok && e){
+        if(e&1) ok=big_mul(&pn,&pn,&b.num) && big_mul(&pd,&pd,&b.den);
+        e>>=1;
+        if(ok && e) ok=big_mul(&b.num,&b.num,&b.num) && big_mul(&b.den,&b.den,&b.den);
+    }
+    if(ok){
+        if(n<0) big_swap(&pn,&pd);
+        big_swap(&r->num,&pn); big_swap(&r->den,&pd);
+        r->neg=neg; r->nred=r->num.n+r->den.n;
+    }
+    rat_free(&b); big_free(&pn); big_free(&pd);
+    return ok;
+}
+/*  a  b Ƚϵķ */
+static int rat_cmp(const CalcRat* a,const CalcRat* b,int* res){
+    CalcBig x, y; int ok;
+    if(a->neg!=b->neg){ *res=a->neg? -1 : 1; return 1; }
+    big_init(&x); big_init(&y);
+    ok=big_mul(&x,&a->num,&b->den) && big_mul(&y,&b->num,&a->den);
+    if(ok){ *res=big_cmp(&x,&y); if(a->neg) *res=-*res; }
+    big_free(&x); big_free(&y);
+    return ok;
+}
+/* r=floor(a) */
+static int rat_floor(CalcRat* r,const CalcRat* a){
+    CalcBig q, m; int ok, neg=a->neg;
+    if(rat_is_int(a)) return rat_copy(r,a);
+    big_init(&q); big_init(&m);
+    ok=big_divmod(&q,&m,&a->num,&a->den);
+    if(ok && neg && m.n){ CalcBig one; big_init(&one); ok=big_set_u64(&one,1) && big_add(&q,&q,&one); big_free(&one); }
+    if(ok){
+        big_swap(&r->num,&q);
+        ok=big_set_u64(&r->den,1);
+        r->neg=neg && r->num.n;
+        r->nred=r->num.n+1;
+    }
+    big_free(&q); big_free(&m);
+    return ok;
+}
+/*  -> doubleȡ 65 λʣλ뵽 53 λͽż ldexp */
+static double rat_to_double(const CalcRat* a){
+    CalcBig n, d, q, m; int s, ok, nb; calc_u64 hi; double v;
+    if(a->num.n==0) return 0.0;
+    big_init(&n); big_init(&d); big_init(&q); big_init(&m);
+    s=65-(big_bits(&a->num)-big_bits(&a->den));
+    ok=big_copy(&n,&a->num) && big_copy(&d,&a->den);
+    if(ok) ok=(s>=0)? big_shl(&n,s) : big_shl(&d,-s);
+    if(ok) ok=big_divmod(&q,&m,&n,&d);
+    if(!ok){ v=0.0; }
+    else{
+        int sticky=(m.n!=0);
+        nb=big_bits(&q);   /* 65  66 */
+        while(nb>64){ sticky|=(int)(q.d[0]&1); big_shr(&q,1); s--; nb--; }
+        hi=big_low64(&q);
+        /* 64 λ -> 53 λ 11 λ */
+        {
+            calc_u64 low=hi&0x7FF, mant=hi>>11;
+            if(low>0x400 || (low==0x400 && (sticky || (mant&1)))) mant++;
+            v=ldexp((double)mant,11-s);
+        }
+    }
+    big_free(&n); big_free(&d); big_free(&q); big_free(&m);
+    return a->neg? -v : v;
+}
+/* doubleޣȷתΪ */
+static int rat_from_double(CalcRat* q,double x){
+    int e, z; double f=frexp(fabs(x),&e);
+    calc_u64 m=(calc_u64)ldexp(f,53);
+    e-=53;
+    if(!rat_set_u64(q,m,x<0)) return 0;
+    if(m==0) return 1;
+    z=0; while(!(m&1) && e<0){ m>>=1; e++; z++; }
+    if(z) big_shr(&q->num,z);
+    if(e>0) return big_shl(&q->num,e);
+    if(e<0) return big_shl(&q->den,-e);
+    return 1;
+}
+/* ʮdigits[.digits][e[+-]digits]ľȷֵд -1󷵻 0 */
+static int rat_parse_dec(CalcRat* q,const char* s,size_t len){
+    size_t i=0; long k=0, ex=0; int dot=0, esg=1, chunk=0, ok=1; calc_u32 acc=0, pw; CalcBig p, b5;
+    if(!rat_set_u64(q,0,0)) return 0;
+    for(;i<len && (isdigit((unsigned char)s[i]) || s[i]=='.');++i){
+        if(s[i]=='.'){ if(dot) return -1; dot=1; continue; }
+        if(dot) k--;
+        acc=acc*10+(calc_u32)(s[i]-'0');
+        if(++chunk==9){ if(!big_mul_small(&q->num,1000000000u,acc)) return 0; acc=0; chunk=0; }
+    }
+    for(pw=1;chunk>0;--chunk) pw*=10;
+    if(!big_mul_small(&q->num,pw,acc)) return 0;
+    if(i<len && (s[i]=='e' || s[i]=='E')){
+        i++;
+        if(i<len && (s[i]=='+' || s[i]=='-')){ if(s[i]=='-') esg=-1; i++; }
+        for(;i<len && isdigit((unsigned char)s[i]);++i) if(ex<10000000L) ex=ex*10+(s[i]-'0');
+    }
+    if(i!=len) return -1;
+    k+=esg*ex;
+    if(q->num.n==0) return 1;
+    if(k>32L*BIG_MAX_LIMBS/4 || k<-32L*BIG_MAX_LIMBS/4) return 0;
+    /* 10^|k|=5^|k|*2^|k|5^|k| ƽ- */
+    big_init(&p); big_init(&b5);
+    ok=big_set_u64(&p,1) && big_set_u64(&b5,5);
+    for(ex=(k<0)? -k : k;ok && ex>0;ex>>=1){
+        if(ex&1) ok=big_mul(&p,&p,&b5);
+        if(ok && ex>1) ok=big_mul(&b5,&b5,&b5);
+    }
+    big_free(&b5);
+    if(ok) ok=big_shl(&p,(int)((k<0)? -k : k));
+    if(ok) ok=(k>=0)? big_mul(&q->num,&q->num,&p) : big_copy(&q->den,&p);
+    big_free(&p);
+    return ok && rat_reduce(q);
+}
+/* ʮ 0x...д -1󷵻 0 */
+static int rat_parse_hex(CalcRat* q,const char* s,size_t len){
+    size_t i;
+    if(len<3 || s[0]!='0' || (s[1]!='x' && s[1]!='X')) return -1;
+    for(i=2;i<len;++i) if(!isxdigit((unsigned char)s[i])) return -1;
+    if(!rat_set_u64(q,0,0) || !big_reserve(&q->num,(int)((len-2+7)/8))) return 0;
+    memset(q->num.d,0,sizeof(calc_u32)*((len-2+7)/8));
+    for(i=0;i<len-2;++i){
+        int c=s[len-1-i], v=isdigit(c)? c-'0' : toupper(c)-'A'+10;
+        q->num.d[i/8]|=(calc_u32)v<<(4*(i%8));
+    }
+    q->num.n=(int)((len-2+7)/8); big_trim(&q->num);
+    return 1;
+}
+/* ʮ "[-]num[/den]"malloc÷ free */
+static char* rat_to_str(const CalcRat* q){
+    char *a=big_to_dec(&q->num), *b=NULL, *s;
+    if(!a) return NULL;
+    if(!rat_is_int(q) && !(b=big_to_dec(&q->den))){ calc_free(a); return NULL; }
+    s=(char*)calc_malloc(MEM_BIGNUM,strlen(a)+(b? strlen(b) : 0)+3);
+    if(s) sprintf(s,"%s%s%s%s",q->neg? "-" : "",a,b? "/" : "",b? b : "");
+    calc_free(a); calc_free(b);
+    return s;
+}
+
 /* ------------ ʷ/﷨ǰ׺ͻ ------------ */
 typedef enum {
     CALC_T_NUMBER, CALC_T_OPERATOR, CALC_T_LPAREN, CALC_T_RPAREN,
-    CALC_T_FUNC, CALC_T_COMMA, CALC_T_IDENT /* / */
+    CALC_T_FUNC, CALC_T_COMMA, CALC_T_IDENT, /* / */
+    CALC_T_SLOT  /* Ԥİ󶨱arity Ϊۺ */
 } CalcTokType;
 
 typedef enum {
@@ -178,23 +1617,47 @@ typedef enum {
 typedef struct {
     CalcTokType type;
     double  value;
+    double  lo;             /* ˫˫λ/prec dd ڲ㣬Ϊ 0 */
+    int     src, srclen;    /* Դеλã/exact ԭľȷ */
     OpKind  op;
     char    name[NAME_LEN]; /* ʶ */
     int     arity;          /* Ԫ */
+    int     fn;             /* ţCalcFuncId */
 } CalcToken;
 
 typedef struct { CalcToken items[MAX_TOKENS]; int count; } CalcTokenList;
 
 static int is_func_char_local(int c){ return isalpha(c) || c=='_'; }
-static int is_func_name_local(const char* s,int* ar){
+
+/* ʷ׶βõţֵʱŷɣֵã */
+typedef enum {
+    FN_SIN, FN_COS, FN_TAN, FN_ASIN, FN_ACOS, FN_ATAN,
+    FN_SQRT, FN_LN, FN_LOG, FN_ABS, FN_EXP, FN_POW,
+    FN_RAND, FN_RANDN,
+    FN_GAMMA, FN_LGAMMA, FN_BETA, FN_ERF, FN_ERFC, FN_ERFINV, FN_BESSELJ, FN_BESSELY, FN_ZETA,
+    FN_SINH, FN_COSH, FN_TANH, FN_ATAN2, FN_HYPOT, FN_FLOOR, FN_CEIL, FN_ROUND, FN_MIN, FN_MAX
+} CalcFuncId;
+typedef struct { const char* name; int arity; } CalcFuncInfo;   /* arity<0Σ 1  */
+static const CalcFuncInfo g_funcs[] = {
+    {"sin",1},{"cos",1},{"tan",1},{"asin",1},{"acos",1},{"atan",1},
+    {"sqrt",1},{"ln",1},{"log",1},{"abs",1},{"exp",1},{"pow",2},
+    {"rand",0},{"randn",0},
+    {"gamma",1},{"lgamma",1},{"beta",2},{"erf",1},{"erfc",1},{"erfinv",1},
+    {"besselj",2},{"bessely",2},{"zeta",1},
+    {"sinh",1},{"cosh",1},{"tanh",1},{"atan2",2},{"hypot",-1},
+    {"floor",1},{"ceil",1},{"round",1},{"min",-1},{"max",-1},
+    {NULL,0}
+};
+static int is_func_name_local(const char* s,int* ar,int* fn){
+    int i;
     if(!s) return 0;
-    if(strcmp(s,"sin")==0 || strcmp(s,"cos")==0 || strcmp(s,"tan")==0 ||
-       strcmp(s,"sqrt")==0|| strcmp(s,"ln")==0  || strcmp(s,"log")==0 ||
-       strcmp(s,"abs")==0 || strcmp(s,"exp")==0 ||
-       strcmp(s,"asin")==0|| strcmp(s,"acos")==0|| strcmp(s,"atan")==0){
-        if(ar) *ar=1; return 1;
+    for(i=0;g_funcs[i].name;++i){
+        if(strcmp(s,g_funcs[i].name)==0){
+            if(ar) *ar=g_funcs[i].arity;
+            if(fn) *fn=i;
+            return 1;
+        }
     }
-    if(strcmp(s,"pow")==0){ if(ar) *ar=2; return 1; }
     return 0;
 }
 static int precedence_local(OpKind op){
@@ -214,19 +1677,22 @@ static int is_postfix_local(OpKind op){ return (op==OP_FACT || op==OP_PERCENT);
 static double round_local(double x){ return (x>=0.0)? floor(x+0.5) : ceil(x-0.5); }
 static int nearly_integer_local(double x){ return fabs(x-round_local(x)) < 1e-9; }
 
-/* ׳ˣ lgammaC89 ã㻷 lgammaɸĳСΧѭ棩 */
+/* ׳ˣˣn<=22 ʱȷ x! = gamma(x+1)Ϊ */
+static double gamma_local(double x);
 static int factorial_ok_local(double x){
-    if(!nearly_integer_local(x)) return 0;
-    if(x<0.0 || x>170.0) return 0;
-    return 1;
+    if(nearly_integer_local(x)) return (x>-0.5 && x<=170.5);
+    return x<171.6;
 }
 static double factorial_val_local(double x){
-    double n=round_local(x);
-    return exp(lgamma(n+1.0));
+    double n, r=1.0, k;
+    if(!nearly_integer_local(x)) return gamma_local(x+1.0);
+    n=round_local(x);
+    for(k=2.0;k<=n;k+=1.0) r*=k;
+    return r;
 }
 
 /* ʷ///// */
-static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_t emlen){
+static int tokenize_raw_local(const char* s, CalcTokenList* out, char* errmsg, size_t emlen){
     size_t i=0, n=strlen(s);
     CalcTokType prev=CALC_T_OPERATOR;
     out->count=0;
@@ -235,6 +1701,7 @@ static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_
         char c=s[i];
 
         if((unsigned char)c <= ' '){ i++; continue; }
+        if(out->count>=MAX_TOKENS){ snprintf(errmsg,emlen,"ʽ %d Ǻţ",MAX_TOKENS); return 0; }
 
         if((c>='0' && c<='9') || c=='.'){
             char* endp=NULL; double v;
@@ -243,6 +1710,9 @@ static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_
             if(errno==ERANGE){ snprintf(errmsg,emlen,"Խ"); return 0; }
             out->items[out->count].type=CALC_T_NUMBER;
             out->items[out->count].value=v;
+            out->items[out->count].src=(int)i;
+            out->items[out->count].srclen=(int)(endp-(s+i));
+            out->items[out->count].lo=0.0;   /* ˫˫λ dd_literals_local 貹 */
             out->count++;
             i=(size_t)(endp-s);
             prev=CALC_T_NUMBER;
@@ -250,24 +1720,24 @@ static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_
         }
 
         if(is_func_char_local((unsigned char)c)){
-            char buf[NAME_LEN]; int j=0, ar=0, isf=0;
-            while(i<n && is_func_char_local((unsigned char)s[i]) && j<NAME_LEN-1){
+            char buf[NAME_LEN]; int j=0, ar=0, fn=0, isf=0;
+            /* ַΪĸ/»ߣɺ֣atan2x1 ȣ */
+            while(i<n && (is_func_char_local((unsigned char)s[i]) || isdigit((unsigned char)s[i])) && j<NAME_LEN-1){
                 buf[j++]=(char)tolower((unsigned char)s[i]); i++;
             }
             buf[j]='\0';
-            isf = is_func_name_local(buf,&ar);
+            isf = is_func_name_local(buf,&ar,&fn);
             if(isf){
                 out->items[out->count].type=CALC_T_FUNC;
-                strncpy(out->items[out->count].name,buf,NAME_LEN-1);
-                out->items[out->count].name[NAME_LEN-1]='\0';
+                memcpy(out->items[out->count].name,buf,(size_t)j+1);
                 out->items[out->count].arity=ar;
+                out->items[out->count].fn=fn;
                 out->count++;
                 prev=CALC_T_FUNC;
             }else{
                 /* Ϊʶ/ */
                 out->items[out->count].type=CALC_T_IDENT;
-                strncpy(out->items[out->count].name,buf,NAME_LEN-1);
-                out->items[out->count].name[NAME_LEN-1]='\0';
+                memcpy(out->items[out->count].name,buf,(size_t)j+1);
                 out->count++;
                 prev=CALC_T_IDENT;
             }
@@ -301,8 +1771,9 @@ static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_
 }
 
 /* Shunting Yard׺->RPN */
-static int to_rpn_local(const CalcTokenList* in, CalcTokenList* out, char* errmsg, size_t emlen){
+static int to_rpn_raw_local(const CalcTokenList* in, CalcTokenList* out, char* errmsg, size_t emlen){
     CalcToken opstack[MAX_STACK]; int top=0, i;
+    int nargs[MAX_STACK];   /* ÿ '(' ѼںԪ */
     out->count=0;
     for(i=0;i<in->count;++i){
         CalcToken tk=in->items[i];
@@ -321,6 +1792,7 @@ static int to_rpn_local(const CalcTokenList* in, CalcTokenList* out, char* errms
             }
             opstack[top++]=tk;
         }else if(tk.type==CALC_T_LPAREN){
+            nargs[top]=(i+1<in->count && in->items[i+1].type==CALC_T_RPAREN)? 0 : 1;
             opstack[top++]=tk;
         }else if(tk.type==CALC_T_COMMA){
             int found=0;
@@ -329,14 +1801,21 @@ static int to_rpn_local(const CalcTokenList* in, CalcTokenList* out, char* errms
                 out->items[out->count++]=opstack[--top];
             }
             if(!found){ snprintf(errmsg,emlen,"λûŲƥ"); return 0; }
+            nargs[top-1]++;
         }else if(tk.type==CALC_T_RPAREN){
             while(top>0 && opstack[top-1].type!=CALC_T_LPAREN){
                 out->items[out->count++]=opstack[--top];
             }
             if(top==0){ snprintf(errmsg,emlen,"Ųƥ"); return 0; }
             --top; /* pop '(' */
-            if(top>0 && opstack[top-1].type==CALC_T_FUNC)
-                out->items[out->count++]=opstack[--top];
+            if(top>0 && opstack[top-1].type==CALC_T_FUNC){
+                CalcToken f=opstack[--top]; int na=nargs[top+1];
+                if(g_funcs[f.fn].arity<0){
+                    if(na<1 || na>MAX_FUNC_ARGS){ snprintf(errmsg,emlen,"%s Ҫ 1..%d ",f.name,MAX_FUNC_ARGS); return 0; }
+                    f.arity=na;
+                }else if(na!=f.arity){ snprintf(errmsg,emlen,"%s Ҫ%d",f.name,f.arity); return 0; }
+                out->items[out->count++]=f;
+            }
         }
     }
     while(top>0){
@@ -345,9 +1824,389 @@ static int to_rpn_local(const CalcTokenList* in, CalcTokenList* out, char* errms
         }
         out->items[out->count++]=opstack[--top];
     }
+    for(i=0;i<out->count;++i)
+        if(out->items[i].type==CALC_T_FUNC && out->items[i].arity<0){
+            snprintf(errmsg,emlen,"%s Ĳд",out->items[i].name); return 0;
+        }
+    return 1;
+}
+/*  /timing ʱ --trace-out ׷ٵ */
+static int tokenize_local(const char* s, CalcTokenList* out, char* errmsg, size_t emlen){
+    double t0; int ok;
+    if(!(g_timing|g_trace.detail)) return tokenize_raw_local(s,out,errmsg,emlen);
+    t0=calc_now(); ok=tokenize_raw_local(s,out,errmsg,emlen);
+    if(g_timing) timing_add_local(TM_TOKENIZE,calc_now()-t0);
+    if(g_trace.detail) trace_event_local("tokenize","parse",t0,out->count);
+    return ok;
+}
+static int to_rpn_local(const CalcTokenList* in, CalcTokenList* out, char* errmsg, size_t emlen){
+    double t0; int ok;
+    if(!(g_timing|g_trace.detail)) return to_rpn_raw_local(in,out,errmsg,emlen);
+    t0=calc_now(); ok=to_rpn_raw_local(in,out,errmsg,emlen);
+    if(g_timing) timing_add_local(TM_RPN,calc_now()-t0);
+    if(g_trace.detail) trace_event_local("to_rpn","parse",t0,in->count);
+    return ok;
+}
+
+/* ------------ xoshiro256++  ziggurat ̬ ------------
+ * ״̬ splitmix64 չjump() ǰ 2^128 гص */
+#define RNG_DEFAULT_SEED 20240501UL
+typedef struct { calc_u64 s[4]; } CalcRng;
+static CalcRng  g_rng;
+static CalcRng* g_rng_active = &g_rng;   /* rand()/randn() ǰʹõ */
+
+static calc_u64 rng_rotl(calc_u64 x,int k){ return (x<<k) | (x>>(64-k)); }
+static calc_u64 rng_next(CalcRng* r){
+    calc_u64 res = rng_rotl(r->s[0]+r->s[3],23) + r->s[0];
+    calc_u64 t = r->s[1]<<17;
+    r->s[2]^=r->s[0]; r->s[3]^=r->s[1];
+    r->s[1]^=r->s[2]; r->s[0]^=r->s[3];
+    r->s[2]^=t;
+    r->s[3]=rng_rotl(r->s[3],45);
+    return res;
+}
+static void rng_seed(CalcRng* r,calc_u64 seed){
+    int i;
+    for(i=0;i<4;++i){
+        calc_u64 z = (seed += CALC_U64(0x9E3779B9,0x7F4A7C15));
+        z = (z ^ (z>>30)) * CALC_U64(0xBF58476D,0x1CE4E5B9);
+        z = (z ^ (z>>27)) * CALC_U64(0x94D049BB,0x133111EB);
+        r->s[i] = z ^ (z>>31);
+    }
+}
+static void rng_jump(CalcRng* r){
+    static const unsigned long J[8] = {  /*  32 λ,  32 λ */
+        0x180ec6d3UL,0x3cfd0abaUL, 0xd5a61266UL,0xf0c9392cUL,
+        0xa9582618UL,0xe03fc9aaUL, 0x39abdc45UL,0x29b1661cUL
+    };
+    calc_u64 t[4]={0,0,0,0}; int i,b;
+    for(i=0;i<4;++i){
+        calc_u64 jw = CALC_U64(J[2*i],J[2*i+1]);
+        for(b=0;b<64;++b){
+            if(jw & ((calc_u64)1<<b)){ t[0]^=r->s[0]; t[1]^=r->s[1]; t[2]^=r->s[2]; t[3]^=r->s[3]; }
+            rng_next(r);
+        }
+    }
+    for(i=0;i<4;++i) r->s[i]=t[i];
+}
+/* [0,1)  53 λȷֲrng_u01_open ȡ (0,1)  log ʹ */
+#define RNG_2POW53_INV (1.0/9007199254740992.0)
+static double rng_u01(CalcRng* r){ return (double)(rng_next(r)>>11) * RNG_2POW53_INV; }
+static double rng_u01_open(CalcRng* r){ return ((double)(rng_next(r)>>11)+0.5) * RNG_2POW53_INV; }
+
+/* Ziggurat128 㣬MarsagliaCTsang/Doornik 죩״ʹʱ */
+#define ZIG_C 128
+#define ZIG_R 3.442619855899
+#define ZIG_V 9.91256303526217e-3
+static double g_zig_x[ZIG_C+1], g_zig_ratio[ZIG_C];
+static int    g_zig_ready = 0;
+static void zig_init(void){
+    double f=exp(-0.5*ZIG_R*ZIG_R); int i;
+    g_zig_x[0]=ZIG_V/f; g_zig_x[1]=ZIG_R; g_zig_x[ZIG_C]=0.0;
+    for(i=2;i<ZIG_C;++i){
+        g_zig_x[i]=sqrt(-2.0*log(ZIG_V/g_zig_x[i-1]+f));
+        f=exp(-0.5*g_zig_x[i]*g_zig_x[i]);
+    }
+    for(i=0;i<ZIG_C;++i) g_zig_ratio[i]=g_zig_x[i+1]/g_zig_x[i];
+    g_zig_ready=1;
+}
+static double rng_normal(CalcRng* r){
+    if(!g_zig_ready) zig_init();
+    for(;;){
+        calc_u64 b=rng_next(r);
+        int i=(int)(b & 0x7F);
+        double u=2.0*(double)(b>>11)*RNG_2POW53_INV-1.0, x, f0, f1;
+        if(fabs(u)<g_zig_ratio[i]) return u*g_zig_x[i];   /* Լ 99%  */
+        if(i==0){   /* β |x|>R */
+            double y;
+            do{ x=log(rng_u01_open(r))/ZIG_R; y=log(rng_u01_open(r)); }while(-2.0*y<x*x);
+            return (u<0.0)? x-ZIG_R : ZIG_R-x;
+        }
+        x=u*g_zig_x[i];
+        f0=exp(-0.5*(g_zig_x[i]*g_zig_x[i]-x*x));
+        f1=exp(-0.5*(g_zig_x[i+1]*g_zig_x[i+1]-x*x));
+        if(f1+rng_u01(r)*(f0-f1)<1.0) return x;
+    }
+}
+static void rng_fill_u01(CalcRng* r,double* y,int n){ int i; for(i=0;i<n;++i) y[i]=(double)(rng_next(r)>>11)*RNG_2POW53_INV; }
+static void rng_fill_normal(CalcRng* r,double* y,int n){ int i; for(i=0;i<n;++i) y[i]=rng_normal(r); }
+
+/* ------------ ⺯ ------------
+ * ȣ doubleֵ
+ *   gamma     Lanczos(g=7,n=9) + 乫ʽx>10 ʱȵƵ [1,2)~5e-15˸
+ *   lgamma    C  lgamma
+ *   erf/erfc  |x|<2.5 ޵ʽLentz~1e-15erfc βΪԾ
+ *   erfinv    Giles ֵ + 3  Newton~1e-15
+ *   besselj/y ףMiller  + Neumann Y0/Y1 ƣx>50  x>n^2/2 ʱ Hankel չ
+ *              ~1e-15
+ *   zeta      Borwein n=40s<0 ụ́s ӽ 1 ʱ ~eps/|s-1| */
+#define EULER_GAMMA 0.57721566490153286061
+
+static double sinpi_local(double x){   /* sin(pi*x)Ȱ 2 Լ */
+    double r=x-2.0*floor(0.5*x);
+    if(r==0.0 || r==1.0) return 0.0;
+    return sin(M_PI*r);
+}
+static double gamma_local(double x){
+    static const double p[9]={
+        0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+        771.32342877765313, -176.61502916214059, 12.507343278686905,
+        -0.13857109526572012, 9.9843695780195716e-6, 1.5056327351493116e-7
+    };
+    double a, t, h; int i;
+    if(x==floor(x)){
+        if(x<=0.0) return NAN;                 /*  */
+        if(x>171.0) return HUGE_VAL;
+        for(a=1.0,t=2.0;t<x;t+=1.0) a*=t;      /* (x-1)! */
+        return a;
+    }
+    if(x<0.5) return M_PI/(sinpi_local(x)*gamma_local(1.0-x));
+    if(x>171.7) return HUGE_VAL;
+    if(x>10.0){
+        /* ƽ [1,2) x-j ȷֻԳ˷ pow Ŵ t 룩 */
+        for(a=1.0,t=x-1.0;t>=1.0;t-=1.0) a*=t;
+        return a*gamma_local(t+1.0);
+    }
+    x-=1.0; a=p[0];
+    for(i=1;i<9;++i) a+=p[i]/(x+i);
+    t=x+7.5;
+    h=pow(t,0.5*(x+0.5));                      /* м */
+    return sqrt(2.0*M_PI)*h*exp(-t)*a*h;
+}
+static double gamma_sign_local(double x){
+    return (x>0.0 || ((long)floor(x))%2==0)? 1.0 : -1.0;
+}
+static int beta_local(double a,double b,double* y){
+    if((a<=0 && a==floor(a)) || (b<=0 && b==floor(b))) return 0;
+    if(a>0 && b>0 && a+b<171.0){ *y=gamma_local(a)*gamma_local(b)/gamma_local(a+b); return 1; }
+    if(a+b<=0 && a+b==floor(a+b)){ *y=0.0; return 1; }
+    *y=gamma_sign_local(a)*gamma_sign_local(b)*gamma_sign_local(a+b)*exp(lgamma(a)+lgamma(b)-lgamma(a+b));
+    return 1;
+}
+
+/* erfc ʽx>0erfc(x)=exp(-x^2)/sqrt(pi) / (x+ (1/2)/(x+ 1/(x+ (3/2)/(x+ ...)))) */
+static double erfc_cf_local(double x){
+    double f=x, C=x, D=0.0, delta; int k;
+    for(k=1;k<500;++k){
+        double a=0.5*k;
+        D=x+a*D; if(D==0.0) D=1e-300; D=1.0/D;
+        C=x+a/C; if(C==0.0) C=1e-300;
+        delta=C*D; f*=delta;
+        if(fabs(delta-1.0)<1e-16) break;
+    }
+    return exp(-x*x)/(sqrt(M_PI)*f);
+}
+/* erf erf(x)=2/sqrt(pi)*exp(-x^2)*sum 2^n x^(2n+1)/(1*3*...*(2n+1)) */
+static double erf_series_local(double x){
+    double term=x, sum=x, x2=x*x; int n;
+    for(n=1;n<200;++n){
+        term*=2.0*x2/(2*n+1);
+        sum+=term;
+        if(fabs(term)<1e-17*fabs(sum)) break;
+    }
+    return 2.0/sqrt(M_PI)*exp(-x2)*sum;
+}
+static double erf_local(double x){
+    if(x<0) return -erf_local(-x);
+    if(x<2.5) return erf_series_local(x);
+    if(x>6.0) return 1.0;
+    return 1.0-erfc_cf_local(x);
+}
+static double erfc_local(double x){
+    if(x<0) return 2.0-erfc_local(-x);
+    if(x<1.5) return 1.0-erf_series_local(x);
+    if(x>27.3) return 0.0;
+    return erfc_cf_local(x);
+}
+static double erfinv_local(double y){
+    double w, p, x; int i;
+    if(y<=-1.0 || y>=1.0) return (y==1.0)? HUGE_VAL : ((y==-1.0)? -HUGE_VAL : NAN);
+    w=-log((1.0-y)*(1.0+y));
+    if(w<5.0){
+        w-=2.5;
+        p=2.81022636e-08; p=3.43273939e-07+p*w; p=-3.5233877e-06+p*w; p=-4.39150654e-06+p*w;
+        p=0.00021858087+p*w; p=-0.00125372503+p*w; p=-0.00417768164+p*w; p=0.246640727+p*w; p=1.50140941+p*w;
+    }else{
+        w=sqrt(w)-3.0;
+        p=-0.000200214257; p=0.000100950558+p*w; p=0.00134934322+p*w; p=-0.00367342844+p*w;
+        p=0.00573950773+p*w; p=-0.0076224613+p*w; p=0.00943887047+p*w; p=1.00167406+p*w; p=2.83297682+p*w;
+    }
+    x=p*y;
+    /* Newtonβ erfc Ծ */
+    for(i=0;i<3;++i){
+        double r=(fabs(y)<0.9)? erf_local(x)-y : ((y>0)? (1.0-y)-erfc_local(x) : erfc_local(-x)-(1.0+y));
+        x-=r/(2.0/sqrt(M_PI)*exp(-x*x));
+    }
+    return x;
+}
+
+/* Hankel չx ʱͬʱ J_n  Y_n */
+static void bessel_hankel_local(int n,double x,double* J,double* Y){
+    double mu=4.0*n*n, P=1.0, Q=0.0, term=1.0, w, s; int k;
+    for(k=1;k<60;++k){
+        double nt=term*(mu-(2.0*k-1)*(2.0*k-1))/(k*8.0*x);
+        if(fabs(nt)>fabs(term)) break;          /* ʼɢ */
+        term=nt;
+        if(k%4==1) Q+=term; else if(k%4==2) P-=term; else if(k%4==3) Q-=term; else P+=term;
+        if(fabs(term)<1e-17) break;
+    }
+    w=x-(0.5*n+0.25)*M_PI;
+    s=sqrt(2.0/(M_PI*x));
+    *J=s*(P*cos(w)-Q*sin(w));
+    *Y=s*(P*sin(w)+Q*cos(w));
+}
+/* Miller ƣj[0..m] Ϊ J_0..J_mѹһ mʧܷ -1 */
+static int bessel_miller_local(int n,double x,double** jout){
+    double big=(n>x? n:x), *j, norm=0.0, jp=0.0, jc=1e-30, t;
+    int m=2*(int)((big+15.0+sqrt(40.0*big))/2.0)+2, k;
+    j=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)(m+2));
+    if(!j) return -1;
+    j[m+1]=0.0;
+    for(k=m;k>=0;--k){
+        j[k]=jc;
+        t=(k>0)? 2.0*k/x*jc-jp : 0.0;
+        jp=jc; jc=t;
+        if(fabs(jc)>1e250){                     /* ر */
+            int q; for(q=k;q<=m;++q) j[q]*=1e-250;
+            jc*=1e-250; jp*=1e-250;
+        }
+    }
+    for(k=2;k<=m;k+=2) norm+=2.0*j[k];
+    norm+=j[0];
+    for(k=0;k<=m;++k) j[k]/=norm;
+    *jout=j;
+    return m;
+}
+static int besselj_local(double nd,double x,double* y){
+    int n, neg=0, m; double *j, Jh, Yh;
+    if(nd!=floor(nd) || fabs(nd)>1000){ return 0; }
+    n=(int)nd;
+    if(n<0){ n=-n; neg=(n&1); }
+    if(x<0){ x=-x; if(n&1) neg=!neg; }
+    if(x==0.0){ *y=(n==0)? 1.0 : 0.0; return 1; }
+    if(x>50.0 && x>0.5*n*n){ bessel_hankel_local(n,x,&Jh,&Yh); *y=neg? -Jh:Jh; return 1; }
+    m=bessel_miller_local(n,x,&j);
+    if(m<0) return 0;
+    *y=(n<=m)? j[n] : 0.0;
+    if(neg) *y=-*y;
+    calc_free(j);
+    return 1;
+}
+static int bessely_local(double nd,double x,double* y){
+    int n, neg=0, m, k; double *j, y0, y1, yk, Jh, Yh, lg, s;
+    if(nd!=floor(nd) || fabs(nd)>1000 || !(x>0)) return 0;
+    n=(int)nd;
+    if(n<0){ n=-n; neg=(n&1); }
+    if(x>50.0 && x>0.5*n*n){ bessel_hankel_local(n,x,&Jh,&Yh); *y=neg? -Yh:Yh; return 1; }
+    m=bessel_miller_local(1,x,&j);
+    if(m<0) return 0;
+    /* Neumann Y0=(2/pi)(ln(x/2)+)J0 - (4/pi)(-1)^k J_2k/kY1=-Y0' */
+    lg=log(0.5*x)+EULER_GAMMA;
+    s=0.0; for(k=1;2*k<=m;++k) s+=((k&1)? -1.0:1.0)*j[2*k]/k;
+    y0=2.0/M_PI*(lg*j[0]-2.0*s);
+    s=0.0; for(k=1;2*k+1<=m;++k) s+=((k&1)? -1.0:1.0)*(j[2*k-1]-j[2*k+1])/k;
+    y1=2.0/M_PI*(lg*j[1]-j[0]/x+s);
+    calc_free(j);
+    if(n==0) *y=y0;
+    else{
+        for(k=1;k<n;++k){ yk=2.0*k/x*y1-y0; y0=y1; y1=yk; if(!isfinite(y1)) break; }   /* Y ȶ */
+        *y=y1;
+    }
+    if(neg) *y=-*y;
+    return isfinite(*y);
+}
+static int zeta_local(double s,double* y){
+    enum { ZN=40 };
+    double d[ZN+1], t, eta=0.0; int i, k;
+    if(s==1.0) return 0;
+    if(s<0.0){
+        double r;
+        if(s==floor(s) && fmod(-s,2.0)==0.0){ *y=0.0; return 1; }   /* ƽ */
+        if(!zeta_local(1.0-s,&r)) return 0;
+        *y=pow(2.0,s)*pow(M_PI,s-1.0)*sinpi_local(0.5*s)*gamma_local(1.0-s)*r;
+        return isfinite(*y);
+    }
+    if(s>60.0){ *y=1.0+pow(2.0,-s); return 1; }
+    /* Borweind_k = n _{i<=k} (n+i-1)! 4^i / ((n-i)! (2i)!) */
+    t=1.0; d[0]=1.0;
+    for(i=1;i<=ZN;++i){
+        t*=4.0*(ZN+i-1)*(ZN-i+1)/((2.0*i)*(2.0*i-1));
+        d[i]=d[i-1]+t;
+    }
+    for(k=0;k<ZN;++k) eta+=((k&1)? -1.0:1.0)*(d[k]-d[ZN])/pow(k+1.0,s);
+    eta=-eta/d[ZN];
+    *y=eta/(1.0-pow(2.0,1.0-s));
     return 1;
 }
 
+/* ֵںˣa Ϊ˳е na 󷵻 0 */
+static int calc_func_local(int fn,const double* a,int na,double* y,char* errmsg,size_t emlen){
+    int i;
+    double x=(fn==FN_RAND||fn==FN_RANDN)? 0.0 : a[0];
+    switch(fn){
+        case FN_SIN:  *y=sin(to_radian(x)); return 1;
+        case FN_COS:  *y=cos(to_radian(x)); return 1;
+        case FN_TAN:  *y=tan(to_radian(x)); return 1;
+        case FN_ASIN: *y=from_radian(asin(x)); return 1;
+        case FN_ACOS: *y=from_radian(acos(x)); return 1;
+        case FN_ATAN: *y=from_radian(atan(x)); return 1;
+        case FN_SQRT: if(x<0.0){ snprintf(errmsg,emlen,"sqrt "); return 0;} *y=sqrt(x); return 1;
+        case FN_LN:   if(x<=0.0){ snprintf(errmsg,emlen,"ln "); return 0;} *y=log(x); return 1;
+        case FN_LOG:  if(x<=0.0){ snprintf(errmsg,emlen,"log10 "); return 0;} *y=log10(x); return 1;
+        case FN_ABS:  *y=fabs(x); return 1;
+        case FN_EXP:  *y=exp(x); return 1;
+        case FN_POW:
+            errno=0; *y=pow(a[0],a[1]);
+            if(errno==EDOM||errno==ERANGE){ snprintf(errmsg,emlen,"pow /Χ"); return 0; }
+            return 1;
+        case FN_RAND:  *y=rng_u01(g_rng_active); return 1;
+        case FN_RANDN: *y=rng_normal(g_rng_active); return 1;
+        case FN_GAMMA:
+            *y=gamma_local(x);
+            if(!isfinite(*y)){ snprintf(errmsg,emlen,"gamma ڷΪ"); return 0; }
+            return 1;
+        case FN_LGAMMA:
+            if(x<=0.0 && x==floor(x)){ snprintf(errmsg,emlen,"lgamma ڷΪ"); return 0; }
+            *y=lgamma(x); return 1;
+        case FN_BETA:
+            if(!beta_local(a[0],a[1],y) || !isfinite(*y)){ snprintf(errmsg,emlen,"beta ڼԽ"); return 0; }
+            return 1;
+        case FN_ERF:  *y=erf_local(x); return 1;
+        case FN_ERFC: *y=erfc_local(x); return 1;
+        case FN_ERFINV:
+            if(!(x>-1.0 && x<1.0)){ snprintf(errmsg,emlen,"erfinv Ϊ (-1,1)"); return 0; }
+            *y=erfinv_local(x); return 1;
+        case FN_BESSELJ:
+            if(!besselj_local(a[0],a[1],y)){ snprintf(errmsg,emlen,"besselj(n,x) Ҫ |n|<=1000"); return 0; }
+            return 1;
+        case FN_BESSELY:
+            if(!bessely_local(a[0],a[1],y)){ snprintf(errmsg,emlen,"bessely(n,x) Ҫ |n|<=1000  x>0"); return 0; }
+            return 1;
+        case FN_ZETA:
+            if(!zeta_local(x,y)){ snprintf(errmsg,emlen,"zeta  s=1 ΪԽ"); return 0; }
+            return 1;
+        case FN_SINH: *y=sinh(x); return 1;
+        case FN_COSH: *y=cosh(x); return 1;
+        case FN_TANH: *y=tanh(x); return 1;
+        case FN_ATAN2: *y=from_radian(atan2(a[0],a[1])); return 1;
+        case FN_HYPOT: {
+            double m=0.0, ss=0.0;
+            for(i=0;i<na;++i) if(fabs(a[i])>m) m=fabs(a[i]);
+            if(m==0.0 || !isfinite(m)){ *y=m; return 1; }
+            for(i=0;i<na;++i) ss+=(a[i]/m)*(a[i]/m);
+            *y=m*sqrt(ss); return 1;
+        }
+        case FN_FLOOR: *y=floor(x); return 1;
+        case FN_CEIL:  *y=ceil(x); return 1;
+        case FN_ROUND: *y=round_local(x); return 1;
+        case FN_MIN: *y=a[0]; for(i=1;i<na;++i) if(a[i]<*y) *y=a[i]; return 1;
+        case FN_MAX: *y=a[0]; for(i=1;i<na;++i) if(a[i]>*y) *y=a[i]; return 1;
+        default: break;
+    }
+    snprintf(errmsg,emlen,"δ֪");
+    return 0;
+}
+
 /*  RPNڴ˴ */
 static int eval_rpn_local(const CalcTokenList* rpn,double* outv,char* errmsg,size_t emlen){
     double st[MAX_STACK]; int sp=0, i;
@@ -368,7 +2227,7 @@ static int eval_rpn_local(const CalcTokenList* rpn,double* outv,char* errmsg,siz
                 if(sp<1){ snprintf(errmsg,emlen,"ȱٲ"); return 0; }
                 a=st[--sp];
                 if(tk.op==OP_FACT){
-                    if(!factorial_ok_local(a)){ snprintf(errmsg,emlen,"׳˲Ϊ[0..170]"); return 0; }
+                    if(!factorial_ok_local(a)){ snprintf(errmsg,emlen,"׳˲Ϊ <=170"); return 0; }
                     st[sp++]=factorial_val_local(a);
                 }else if(tk.op==OP_PERCENT){
                     st[sp++]=a*0.01;
@@ -397,34 +2256,11 @@ static int eval_rpn_local(const CalcTokenList* rpn,double* outv,char* errmsg,siz
                 }
             }
         }else if(tk.type==CALC_T_FUNC){
-            if(tk.arity==1){
-                double x,y=0.0;
-                if(sp<1){ snprintf(errmsg,emlen,""); return 0; }
-                x=st[--sp];
-                if(strcmp(tk.name,"sin")==0) y=sin(to_radian(x));
-                else if(strcmp(tk.name,"cos")==0) y=cos(to_radian(x));
-                else if(strcmp(tk.name,"tan")==0) y=tan(to_radian(x));
-                else if(strcmp(tk.name,"asin")==0) y=from_radian(asin(x));
-                else if(strcmp(tk.name,"acos")==0) y=from_radian(acos(x));
-                else if(strcmp(tk.name,"atan")==0) y=from_radian(atan(x));
-                else if(strcmp(tk.name,"sqrt")==0){ if(x<0.0){ snprintf(errmsg,emlen,"sqrt "); return 0;} y=sqrt(x); }
-                else if(strcmp(tk.name,"ln")==0){ if(x<=0.0){ snprintf(errmsg,emlen,"ln "); return 0;} y=log(x); }
-                else if(strcmp(tk.name,"log")==0){ if(x<=0.0){ snprintf(errmsg,emlen,"log10 "); return 0;} y=log10(x); }
-                else if(strcmp(tk.name,"abs")==0) y=fabs(x);
-                else if(strcmp(tk.name,"exp")==0) y=exp(x);
-                else { snprintf(errmsg,emlen,"δ֪"); return 0; }
-                st[sp++]=y;
-            }else if(tk.arity==2){
-                double a,b,y2;
-                if(strcmp(tk.name,"pow")!=0){ snprintf(errmsg,emlen,"δ֪κ"); return 0; }
-                if(sp<2){ snprintf(errmsg,emlen,"pow Ҫ2"); return 0; }
-                b=st[--sp]; a=st[--sp];
-                errno=0; y2=pow(a,b);
-                if(errno==EDOM||errno==ERANGE){ snprintf(errmsg,emlen,"pow /Χ"); return 0; }
-                st[sp++]=y2;
-            }else{
-                snprintf(errmsg,emlen,"Ԫ֧"); return 0;
-            }
+            double y;
+            if(sp<tk.arity){ snprintf(errmsg,emlen,"%s Ҫ%d",g_funcs[tk.fn].name,tk.arity); return 0; }
+            sp-=tk.arity;
+            if(!calc_func_local(tk.fn,st+sp,tk.arity,&y,errmsg,emlen)) return 0;
+            st[sp++]=y;
         }else{
             snprintf(errmsg,emlen,"RPN Ƿ token"); return 0;
         }
@@ -441,184 +2277,3375 @@ static int eval_expr_local(const char* expr,double* outv,char* errmsg,size_t eml
     return 1;
 }
 
-/*  var=val  expr */
-static int eval_with_var(const char* expr,const char* vname,double x,double* out,char* err,size_t emlen){
-    double old=0.0; int existed=var_get(vname,&old), ok;
-    var_set(vname,x);
-    ok=eval_expr_local(expr,out,err,emlen);
-    if(existed) var_set(vname,old); else var_del(vname);
-    return ok;
-}
+/* ------------ ˫˫ֵ/prec dd ------------ */
+/*  eval_rpn_local ͬsin cos tan asin acos atan atan2 sqrt ln log exp pow abs 
+ * sinh cosh tanh floor ceil round min max hypot ׳Ϊ˫˫ʵ֣ຯgammaerf
+ * Bessel ȣ hi ֵ double ںˣֻ double Ȳ g_dd_lossy
+ * ֻ doublepie ΪĬֵʱ˫˫ans ȡϴ˫˫ */
+typedef enum { PREC_DOUBLE=0, PREC_DD=1 } PrecMode;
+static PrecMode g_prec = PREC_DOUBLE;
+static CalcDD   g_last_dd = {0.0, 0.0};
+static int      g_dd_lossy = 0;   /* ֵõֻ double ȵĺ */
+static int      g_last_dd_lossy = 0;   /* g_last_dd ֻ double  */
 
-/* ------------ UI ------------ */
-static void render_panel(const char* last_msg){
-    clear_screen();
-    printf(" TUI Calculator Pro \n");
-    printf(" Angle: %-3s  | Memory: %-12.6g | Last(ans): %-14.8g                    \n",
-           (g_mode==MODE_DEG?"DEG":"RAD"), g_memory, g_last_result);
-    printf("\n");
-    printf(" ֱʽس'=' ظһΣ/let x=3.2/vars/del x             \n");
-    printf(" ߼/diff /solve /integ /plot     ƣ/hex /bin     ģʽ/deg /rad           \n");
-    printf(" ʷ/history /save <file>   ڴ棺/mc /mr /m+ [v] /m- [v]   /help         \n");
-    printf("\n");
-    if(last_msg && last_msg[0]){
-        printf(" ʾ Hint: %-70.70s \n", last_msg);
-        printf("\n");
+static CalcDD dd_to_radian(CalcDD x){ return (g_mode==MODE_DEG)? dd_mul(x,DD_PI_180) : x; }
+static CalcDD dd_from_radian(CalcDD x){ return (g_mode==MODE_DEG)? dd_div(x,DD_PI_180) : x; }
+
+static int calc_func_dd_local(int fn,const CalcDD* a,int na,CalcDD* y,char* errmsg,size_t emlen){
+    CalcDD x=a[0], one=dd_make(1.0,0.0);
+    switch(fn){
+        case FN_SIN: *y=dd_sin(dd_to_radian(x)); return 1;
+        case FN_COS: *y=dd_cos(dd_to_radian(x)); return 1;
+        case FN_TAN: {
+            CalcDD r=dd_to_radian(x), c=dd_cos(r);
+            if(c.hi==0.0){ snprintf(errmsg,emlen,"tan ڼ㴦޶"); return 0; }
+            *y=dd_div(dd_sin(r),c); return 1;
+        }
+        case FN_ASIN: case FN_ACOS: {
+            CalcDD c;
+            if(fabs(x.hi)>1.0 || (fabs(x.hi)==1.0 && x.lo*x.hi>0.0)){ snprintf(errmsg,emlen,"%s Ϊ [-1,1]",g_funcs[fn].name); return 0; }
+            c=dd_sqrt(dd_sub(one,dd_sqr(x)));
+            *y=dd_from_radian(fn==FN_ASIN? dd_atan2(x,c) : dd_atan2(c,x)); return 1;
+        }
+        case FN_ATAN:  *y=dd_from_radian(dd_atan2(x,one)); return 1;
+        case FN_ATAN2: *y=dd_from_radian(dd_atan2(a[0],a[1])); return 1;
+        case FN_SQRT: if(x.hi<0.0){ snprintf(errmsg,emlen,"sqrt "); return 0;} *y=dd_sqrt(x); return 1;
+        case FN_LN:   if(x.hi<=0.0){ snprintf(errmsg,emlen,"ln "); return 0;} *y=dd_log(x); return 1;
+        case FN_LOG:  if(x.hi<=0.0){ snprintf(errmsg,emlen,"log10 "); return 0;} *y=dd_div(dd_log(x),DD_LN10); return 1;
+        case FN_ABS:  *y=(x.hi<0.0)? dd_neg(x) : x; return 1;
+        case FN_EXP:  *y=dd_exp(x); return 1;
+        case FN_SINH: *y=dd_sinh(x); return 1;
+        case FN_COSH: *y=dd_cosh(x); return 1;
+        case FN_TANH:
+            if(fabs(x.hi)>40.0) *y=dd_make(x.hi>0? 1.0 : -1.0,0.0);
+            else *y=dd_div(dd_sinh(x),dd_cosh(x));
+            return 1;
+        case FN_FLOOR: *y=dd_floor(x); return 1;
+        case FN_CEIL:  *y=dd_neg(dd_floor(dd_neg(x))); return 1;
+        case FN_ROUND: *y=(x.hi>=0.0)? dd_floor(dd_add_d(x,0.5)) : dd_neg(dd_floor(dd_add_d(dd_neg(x),0.5))); return 1;
+        case FN_MIN: case FN_MAX: {
+            int i; *y=a[0];
+            for(i=1;i<na;++i) if(fn==FN_MIN? dd_less(a[i],*y) : dd_less(*y,a[i])) *y=a[i];
+            return 1;
+        }
+        case FN_HYPOT: {
+            CalcDD ss=dd_make(0.0,0.0); int i;
+            for(i=0;i<na;++i) ss=dd_add(ss,dd_sqr(a[i]));
+            *y=dd_sqrt(ss); return 1;
+        }
+        case FN_POW:  break;   /*  ^ ã dd_pow_local */
+        default: {
+            double d[MAX_FUNC_ARGS], v; int i;
+            for(i=0;i<na;++i) d[i]=a[i].hi;
+            if(!calc_func_local(fn,d,na,&v,errmsg,emlen)) return 0;
+            g_dd_lossy=1;
+            *y=dd_make(v,0.0); return 1;
+        }
     }
-    printf(" ʾ sin(30)+cos(60) [/deg] | pow(2,10) | 5!+20%% | ʹñ/let x=1.2;        \n");
-    printf("      /diff sin(x) x 0.5 1e-5  | /plot sin(x) x -3.14 3.14 70 20                   \n");
-    printf("\n");
+    return 0;
 }
-
-/* ------------  ------------ */
-static int is_cmd_local(const char* s,const char* cmd){ return strcmp(s,cmd)==0; }
-static void trim_spaces(char* s){
-    int i=0,j=(int)strlen(s)-1;
-    while(s[i] && (s[i]==' '||s[i]=='\t')) i++;
-    while(j>=i && (s[j]==' '||s[j]=='\t')) j--;
-    if(i>0) memmove(s,s+i,(size_t)(j-i+1));
-    s[j-i+1]='\0';
+static int dd_pow_local(CalcDD a,CalcDD b,CalcDD* y,char* errmsg,size_t emlen){
+    if(b.lo==0.0 && b.hi==floor(b.hi) && fabs(b.hi)<2147483647.0){
+        if(a.hi==0.0 && b.hi<0.0){ snprintf(errmsg,emlen,"Խ/"); return 0; }
+        *y=dd_powi(a,(long)b.hi);
+    }else if(a.hi>0.0){
+        *y=dd_exp(dd_mul(b,dd_log(a)));
+    }else if(a.hi==0.0 && b.hi>0.0){
+        *y=dd_make(0.0,0.0);
+    }else{ snprintf(errmsg,emlen,"Խ/"); return 0; }
+    if(!(fabs(y->hi)<=DBL_MAX)){ snprintf(errmsg,emlen,"Խ/"); return 0; }
+    return 1;
 }
-
-/* ֵ */
-static double diff_center(const char* expr,const char* v,double x,double h,char* er,size_t em){
-    double f1,f2;
-    if(!eval_with_var(expr,v,x+h, &f1,er,em)) return NAN;
-    if(!eval_with_var(expr,v,x-h, &f2,er,em)) return NAN;
-    return (f1-f2)/(2*h);
+static int factorial_dd_local(CalcDD a,CalcDD* y){
+    double n, k;
+    if(!factorial_ok_local(a.hi)) return 0;
+    if(!nearly_integer_local(a.hi)){ g_dd_lossy=1; *y=dd_make(factorial_val_local(a.hi),0.0); return 1; }
+    n=round_local(a.hi); *y=dd_make(1.0,0.0);
+    for(k=2.0;k<=n;k+=1.0) *y=dd_mul_d(*y,k);
+    return 1;
 }
-static int solve_newton(const char* expr,const char* v,double x0,int maxit,double tol,double* root,char* er,size_t em){
-    int k;
-    double x=x0;
-    for(k=0;k<maxit;++k){
-        double fx, dfx;
-        if(!eval_with_var(expr,v,x,&fx,er,em)) return 0;
-        dfx = diff_center(expr,v,x,1e-6,er,em);
-        if(!isfinite(dfx) || dfx==0.0){ snprintf(er,em,"Ϊ0/ at x=%.15g",x); return 0; }
-        x = x - fx/dfx;
-        if(fabs(fx) < tol){ *root=x; return 1; }
+/* ˫˫λֻ /prec dd ֵڰԭĲһΣdouble ·Ĵʷݴ */
+static void dd_literals_local(CalcTokenList* rpn,const char* src){
+    int i;
+    for(i=0;i<rpn->count;++i){
+        CalcToken* tk=&rpn->items[i];
+        if(tk->type==CALC_T_NUMBER && tk->srclen>0){
+            CalcDD d=dd_parse_local(src+tk->src,(size_t)tk->srclen);
+            double lo=(d.hi-tk->value)+d.lo;
+            /* ʮƵ strtod չд˫˫ */
+            tk->lo=(fabs(lo)<=fabs(tk->value)*1e-15)? lo : 0.0;
+        }
     }
-    snprintf(er,em,"δ(maxit=%d)",maxit);
-    return 0;
 }
-static int integ_simpson(const char* expr,const char* v,double a,double b,int n,double* out,char* er,size_t em){
-    int i;
-    double h, s=0.0, x, fx;
-    if(n<=0) n=200;
-    if(n%2) n++; /* Simpson Ҫż */
-    h=(b-a)/n;
-    if(!eval_with_var(expr,v,a,&fx,er,em)) return 0; s+=fx;
-    for(i=1;i<n;i++){
-        x=a+i*h;
-        if(!eval_with_var(expr,v,x,&fx,er,em)) return 0;
-        s += (i%2 ? 4.0*fx : 2.0*fx);
+/* bname ǿʱֱȡ˫˫ֵ bval/sum/integ /ֱ double  */
+static int eval_rpn_dd_local(const CalcTokenList* rpn,const char* bname,CalcDD bval,CalcDD* outv,char* errmsg,size_t emlen){
+    CalcDD st[MAX_STACK]; int sp=0, i;
+    g_dd_lossy=0;
+    for(i=0;i<rpn->count;++i){
+        const CalcToken* tk=&rpn->items[i];
+        if(tk->type==CALC_T_NUMBER){
+            if(sp>=MAX_STACK){ snprintf(errmsg,emlen,"ջ"); return 0; }
+            st[sp++]=dd_make(tk->value,tk->lo);
+        }else if(tk->type==CALC_T_IDENT){
+            double v; CalcDD d;
+            if(bname && strcmp(tk->name,bname)==0) d=bval;
+            else if(strcmp(tk->name,"ans")==0){
+                if(g_last_dd.hi==g_last_result){ d=g_last_dd; g_dd_lossy|=g_last_dd_lossy; }
+                else{ d=dd_make(g_last_result,0.0); g_dd_lossy=1; }
+            }
+            else if(!var_get(tk->name,&v)){ snprintf(errmsg,emlen,"δ: %s",tk->name); return 0; }
+            else if(strcmp(tk->name,"pi")==0 && v==DD_PI.hi) d=DD_PI;
+            else if(strcmp(tk->name,"e")==0 && v==DD_E.hi) d=DD_E;
+            else d=dd_make(v,0.0);
+            if(sp>=MAX_STACK){ snprintf(errmsg,emlen,"ջ"); return 0; }
+            st[sp++]=d;
+        }else if(tk->type==CALC_T_OPERATOR){
+            if(is_postfix_local(tk->op)){
+                if(sp<1){ snprintf(errmsg,emlen,"ȱٲ"); return 0; }
+                if(tk->op==OP_FACT){
+                    if(!factorial_dd_local(st[sp-1],&st[sp-1])){ snprintf(errmsg,emlen,"׳˲Ϊ <=170"); return 0; }
+                }else st[sp-1]=dd_div_d(st[sp-1],100.0);
+                continue;
+            }
+            if(tk->op==OP_UNARY_MINUS){
+                if(sp<1){ snprintf(errmsg,emlen,"һԪȱٲ"); return 0; }
+                st[sp-1]=dd_neg(st[sp-1]); continue;
+            }
+            if(sp<2){ snprintf(errmsg,emlen,"Ԫȱٲ"); return 0; }
+            else{
+                CalcDD b=st[--sp], a=st[--sp];
+                switch(tk->op){
+                    case OP_ADD: st[sp++]=dd_add(a,b); break;
+                    case OP_SUB: st[sp++]=dd_sub(a,b); break;
+                    case OP_MUL: st[sp++]=dd_mul(a,b); break;
+                    case OP_DIV:
+                        if(b.hi==0.0){ snprintf(errmsg,emlen,""); return 0; }
+                        st[sp++]=dd_div(a,b); break;
+                    case OP_POW:
+                        if(!dd_pow_local(a,b,&st[sp],errmsg,emlen)) return 0;
+                        sp++; break;
+                    default: snprintf(errmsg,emlen,"δ֪"); return 0;
+                }
+            }
+        }else if(tk->type==CALC_T_FUNC){
+            CalcDD y;
+            if(sp<tk->arity){ snprintf(errmsg,emlen,"%s Ҫ%d",g_funcs[tk->fn].name,tk->arity); return 0; }
+            sp-=tk->arity;
+            if(tk->fn==FN_POW){ if(!dd_pow_local(st[sp],st[sp+1],&y,errmsg,emlen)){ snprintf(errmsg,emlen,"pow /Χ"); return 0; } }
+            else if(!calc_func_dd_local(tk->fn,st+sp,tk->arity,&y,errmsg,emlen)) return 0;
+            st[sp++]=y;
+        }else{
+            snprintf(errmsg,emlen,"RPN Ƿ token"); return 0;
+        }
     }
-    if(!eval_with_var(expr,v,b,&fx,er,em)) return 0; s+=fx;
-    *out = s*h/3.0; return 1;
+    if(sp!=1){ snprintf(errmsg,emlen,"ʽ(ջʣ=%d)",sp); return 0; }
+    *outv=st[0]; return 1;
+}
+static int eval_expr_dd_local(const char* expr,CalcDD* outv,char* errmsg,size_t emlen){
+    CalcTokenList tl,rpn;
+    if(!tokenize_local(expr,&tl,errmsg,emlen)) return 0;
+    if(!to_rpn_local(&tl,&rpn,errmsg,emlen)) return 0;
+    dd_literals_local(&rpn,expr);
+    return eval_rpn_dd_local(&rpn,NULL,dd_make(0.0,0.0),outv,errmsg,emlen);
 }
 
-/* ASCII plot */
-static void plot_ascii(const char* expr,const char* v,double xmin,double xmax,int W,int H){
-    int i,j;
-    if(W<=0) W=60; if(W>120) W=120;
-    if(H<=0) H=20; if(H>40)  H=40;
+/* ------------ ȷֵ/exact ------------
+ * Դıȷת0.1  1/10+ - * / % ݡ׳
+ * abs floor ceil round min max ־ȷຯݰѲתΪ double
+ * Ӵ˰ double ΪǾȷֻ doubleֵΪȷ
+ * ans ȡϴξȷ */
+#define EXACT_FACT_MAX 5000
+static int     g_exact = 0;
+static CalcRat g_last_rat;          /* ϴξȷg_last_rat_ok  0 ʱЧ */
+static int     g_last_rat_ok = 0;
+typedef struct { int exact; CalcRat q; double v; } ExVal;
 
-    /*  ymin/ymax */
-    double ymin=1e300,ymax=-1e300, x, y;
-    char err[128];
-    for(i=0;i<W;++i){
-        x = xmin + (xmax-xmin)*i/(W-1.0);
-        if(!eval_with_var(expr,v,x,&y,err,sizeof(err))) continue;
-        if(isfinite(y)){ if(y<ymin) ymin=y; if(y>ymax) ymax=y; }
+static void ex_free_local(ExVal* x){ if(x->exact) rat_free(&x->q); }
+static void ex_to_double_local(ExVal* x){
+    if(!x->exact) return;
+    x->v=rat_to_double(&x->q); rat_free(&x->q); x->exact=0;
+}
+static int ex_too_big_local(char* errmsg,size_t emlen){
+    snprintf(errmsg,emlen,"ȷԼ %ld λڴ治",(long)BIG_MAX_LIMBS*32*3/10);
+    return 0;
+}
+/*  |v|<2^31 ʱ *n */
+static int rat_small_int_local(const CalcRat* q,long* n){
+    calc_u64 m;
+    if(!rat_is_int(q) || q->num.n>2) return 0;
+    m=big_low64(&q->num);
+    if(m>0x7FFFFFFFu) return 0;
+    *n=q->neg? -(long)m : (long)m;
+    return 1;
+}
+static int ex_literal_local(ExVal* x,const CalcToken* tk,const char* src,char* errmsg,size_t emlen){
+    int r=-1;
+    if(src && tk->srclen>0) r=rat_parse_dec(&x->q,src+tk->src,(size_t)tk->srclen);
+    if(r<0 && src && tk->srclen>0) r=rat_parse_hex(&x->q,src+tk->src,(size_t)tk->srclen);
+    if(r<0) r=rat_from_double(&x->q,tk->value);   /* ʮƸд double ֵȷת */
+    return r? 1 : ex_too_big_local(errmsg,emlen);
+}
+static int ex_ident_local(ExVal* x,const char* name,const char* bname,const CalcRat* bval,char* errmsg,size_t emlen){
+    double v;
+    if(bname && strcmp(name,bname)==0) return rat_copy(&x->q,bval)? 1 : ex_too_big_local(errmsg,emlen);
+    if(strcmp(name,"ans")==0){
+        if(g_last_rat_ok && rat_to_double(&g_last_rat)==g_last_result)
+            return rat_copy(&x->q,&g_last_rat)? 1 : ex_too_big_local(errmsg,emlen);
+        v=g_last_result;
+    }else if(!var_get(name,&v)){ snprintf(errmsg,emlen,"δ: %s",name); return 0; }
+    if(isfinite(v) && v==floor(v)) return rat_from_double(&x->q,v)? 1 : ex_too_big_local(errmsg,emlen);
+    rat_free(&x->q); x->exact=0; x->v=v;
+    return 1;
+}
+static int ex_factorial_local(ExVal* x,char* errmsg,size_t emlen){
+    long n, k;
+    if(x->exact && rat_small_int_local(&x->q,&n) && n>=0 && n<=EXACT_FACT_MAX){
+        if(!rat_set_u64(&x->q,1,0)) return ex_too_big_local(errmsg,emlen);
+        for(k=2;k<=n;++k) if(!big_mul_small(&x->q.num,(calc_u32)k,0)) return ex_too_big_local(errmsg,emlen);
+        x->q.nred=x->q.num.n+1;
+        return 1;
     }
-    if(!(isfinite(ymin)&&isfinite(ymax)) || ymin==ymax){ ymin-=1; ymax+=1; }
-
-    /*  */
-    {
-        char* grid = (char*)malloc((size_t)(W*H));
-        for(i=0;i<H;++i) for(j=0;j<W;++j) grid[i*W+j]=' ';
-        /* ᣺x=0,y=0 */
-        if(xmin<=0 && xmax>=0){
-            int col = (int)((0 - xmin)/(xmax-xmin)*(W-1));
-            if(col<0) col=0; if(col>=W) col=W-1;
-            for(i=0;i<H;++i) grid[i*W+col]='|';
+    ex_to_double_local(x);
+    if(!factorial_ok_local(x->v)){ snprintf(errmsg,emlen,"׳˲Ϊ <=170"); return 0; }
+    x->v=factorial_val_local(x->v);
+    return 1;
+}
+/* a=a op bb ɵ÷ͷ */
+static int ex_binop_local(OpKind op,ExVal* a,ExVal* b,char* errmsg,size_t emlen){
+    if(a->exact && b->exact){
+        long n; int ok=-1;
+        switch(op){
+            case OP_ADD: case OP_SUB: ok=rat_add(&a->q,&a->q,&b->q,op==OP_SUB); break;
+            case OP_MUL: ok=rat_mul(&a->q,&a->q,&b->q,0); break;
+            case OP_DIV:
+                if(b->q.num.n==0){ snprintf(errmsg,emlen,""); return 0; }
+                ok=rat_mul(&a->q,&a->q,&b->q,1); break;
+            case OP_POW:
+                if(!rat_small_int_local(&b->q,&n)) break;   /* ת double */
+                if(a->q.num.n==0 && n<0){ snprintf(errmsg,emlen,"Խ/"); return 0; }
+                ok=rat_pow(&a->q,&a->q,n); break;
+            default: snprintf(errmsg,emlen,"δ֪"); return 0;
+        }
+        if(ok>0 && a->q.num.n+a->q.den.n>BIG_MAX_LIMBS) ok=0;   /* ڲ԰ BIG_MAX_LIMBS  */
+        if(ok>=0) return ok? 1 : ex_too_big_local(errmsg,emlen);
+    }
+    ex_to_double_local(a); ex_to_double_local(b);
+    switch(op){
+        case OP_ADD: a->v+=b->v; break;
+        case OP_SUB: a->v-=b->v; break;
+        case OP_MUL: a->v*=b->v; break;
+        case OP_DIV:
+            if(b->v==0.0){ snprintf(errmsg,emlen,""); return 0; }
+            a->v/=b->v; break;
+        case OP_POW:
+            errno=0; a->v=pow(a->v,b->v);
+            if(errno==EDOM||errno==ERANGE){ snprintf(errmsg,emlen,"Խ/"); return 0; }
+            break;
+        default: snprintf(errmsg,emlen,"δ֪"); return 0;
+    }
+    return 1;
+}
+/* д a[0]ڴͷ */
+static int ex_func_local(int fn,ExVal* a,int na,char* errmsg,size_t emlen){
+    int i, allx=1, ok=1;
+    for(i=0;i<na;++i) allx=allx && a[i].exact;
+    if(fn==FN_POW && na==2){
+        ok=ex_binop_local(OP_POW,&a[0],&a[1],errmsg,emlen);
+        ex_free_local(&a[1]);
+        if(!ok) snprintf(errmsg,emlen,"pow /Χ");
+        return ok;
+    }
+    if(allx && (fn==FN_ABS || fn==FN_FLOOR || fn==FN_CEIL || fn==FN_ROUND) && na==1){
+        CalcRat* q=&a[0].q;
+        if(fn==FN_ABS) q->neg=0;
+        else if(fn==FN_FLOOR) ok=rat_floor(q,q);
+        else if(fn==FN_CEIL){ q->neg=!q->neg && q->num.n; ok=rat_floor(q,q); q->neg=!q->neg && q->num.n; }
+        else{   /* 룬.5 Զ 0 double ·һ */
+            CalcRat h; int neg=q->neg;
+            rat_init(&h);
+            q->neg=0;
+            ok=rat_set_u64(&h,1,0) && big_set_u64(&h.den,2) && rat_add(q,q,&h,0) && rat_floor(q,q);
+            q->neg=neg && q->num.n;
+            rat_free(&h);
         }
-        if(ymin<=0 && ymax>=0){
-            int row = (int)((ymax - 0)/(ymax-ymin)*(H-1));
-            if(row<0) row=0; if(row>=H) row=H-1;
-            for(j=0;j<W;++j) grid[row*W+j]='-';
+        return ok? 1 : ex_too_big_local(errmsg,emlen);
+    }
+    if(allx && (fn==FN_MIN || fn==FN_MAX)){
+        int c;
+        for(i=1;i<na && ok;++i){
+            ok=rat_cmp(&a[i].q,&a[0].q,&c);
+            if(ok && (fn==FN_MIN? c<0 : c>0)){ CalcRat t=a[0].q; a[0].q=a[i].q; a[i].q=t; }
         }
-        /*  */
-        for(j=0;j<W;++j){
-            x = xmin + (xmax-xmin)*j/(W-1.0);
-            if(eval_with_var(expr,v,x,&y,err,sizeof(err)) && isfinite(y)){
-                int row = (int)((ymax - y)/(ymax-ymin)*(H-1));
-                if(row>=0 && row<H) grid[row*W+j]='*';
+        for(i=1;i<na;++i) ex_free_local(&a[i]);
+        return ok? 1 : ex_too_big_local(errmsg,emlen);
+    }
+    {
+        double d[MAX_FUNC_ARGS], y;
+        for(i=0;i<na;++i){ ex_to_double_local(&a[i]); d[i]=a[i].v; }
+        if(!calc_func_local(fn,d,na,&y,errmsg,emlen)) return 0;
+        a[0].v=y;
+    }
+    return 1;
+}
+/* bname ǿʱֱȡȷֵ bval/sum ͱ */
+static int eval_rpn_exact_local(const CalcTokenList* rpn,const char* src,const char* bname,const CalcRat* bval,
+                                ExVal* outv,char* errmsg,size_t emlen){
+    static ExVal st[MAX_STACK];
+    int sp=0, i, ok=1;
+    for(i=0;i<rpn->count && ok;++i){
+        const CalcToken* tk=&rpn->items[i];
+        if(tk->type==CALC_T_NUMBER || tk->type==CALC_T_IDENT){
+            if(sp>=MAX_STACK){ snprintf(errmsg,emlen,"ջ"); ok=0; break; }
+            st[sp].exact=1; st[sp].v=0.0; rat_init(&st[sp].q);
+            ok=(tk->type==CALC_T_NUMBER)? ex_literal_local(&st[sp],tk,src,errmsg,emlen)
+                                        : ex_ident_local(&st[sp],tk->name,bname,bval,errmsg,emlen);
+            sp++;
+        }else if(tk->type==CALC_T_OPERATOR){
+            if(is_postfix_local(tk->op)){
+                if(sp<1){ snprintf(errmsg,emlen,"ȱٲ"); ok=0; break; }
+                if(tk->op==OP_FACT) ok=ex_factorial_local(&st[sp-1],errmsg,emlen);
+                else if(st[sp-1].exact){
+                    CalcRat h; rat_init(&h);
+                    ok=rat_set_u64(&h,100,0) && rat_mul(&st[sp-1].q,&st[sp-1].q,&h,1);
+                    rat_free(&h);
+                    if(!ok) ex_too_big_local(errmsg,emlen);
+                }else st[sp-1].v*=0.01;
+            }else if(tk->op==OP_UNARY_MINUS){
+                if(sp<1){ snprintf(errmsg,emlen,"һԪȱٲ"); ok=0; break; }
+                if(st[sp-1].exact) st[sp-1].q.neg=!st[sp-1].q.neg && st[sp-1].q.num.n;
+                else st[sp-1].v=-st[sp-1].v;
+            }else{
+                if(sp<2){ snprintf(errmsg,emlen,"Ԫȱٲ"); ok=0; break; }
+                ok=ex_binop_local(tk->op,&st[sp-2],&st[sp-1],errmsg,emlen);
+                ex_free_local(&st[--sp]);
             }
+        }else if(tk->type==CALC_T_FUNC){
+            if(sp<tk->arity){ snprintf(errmsg,emlen,"%s Ҫ%d",g_funcs[tk->fn].name,tk->arity); ok=0; break; }
+            sp-=tk->arity;
+            ok=ex_func_local(tk->fn,st+sp,tk->arity,errmsg,emlen);
+            sp++;
+        }else{
+            snprintf(errmsg,emlen,"RPN Ƿ token"); ok=0;
         }
-        /*  */
-        printf("\n y in [%.6g, %.6g]  x in [%.6g, %.6g]\n",ymin,ymax,xmin,xmax);
-        for(i=0;i<H;++i){
-            putchar(' ');
-            for(j=0;j<W;++j) putchar(grid[i*W+j]);
-            putchar('\n');
-        }
-        free(grid);
     }
+    if(ok && sp!=1){ snprintf(errmsg,emlen,"ʽ(ջʣ=%d)",sp); ok=0; }
+    if(ok){
+        *outv=st[0];
+        if(outv->exact && !rat_reduce(&outv->q)){ ex_free_local(outv); ok=ex_too_big_local(errmsg,emlen); }
+        if(ok && !outv->exact && !isfinite(outv->v)){ snprintf(errmsg,emlen,"޶"); ex_free_local(outv); ok=0; }
+    }else{
+        for(i=0;i<sp;++i) ex_free_local(&st[i]);
+    }
+    return ok;
 }
-
-/*  */
-static void print_bin(unsigned long v){
-    int i, started=0;
-    for(i=(int)(sizeof(unsigned long)*8-1); i>=0; --i){
-        int bit = (v>>i)&1U;
-        if(bit) started=1;
-        if(started) putchar(bit?'1':'0');
+static int eval_expr_exact_local(const char* expr,ExVal* outv,char* errmsg,size_t emlen){
+    CalcTokenList tl,rpn;
+    if(!tokenize_local(expr,&tl,errmsg,emlen)) return 0;
+    if(!to_rpn_local(&tl,&rpn,errmsg,emlen)) return 0;
+    return eval_rpn_exact_local(&rpn,expr,NULL,NULL,outv,errmsg,emlen);
+}
+/* ȷʾУ̵ĸȫģĸλ double  */
+static void rat_result_msg_local(const char* prefix,const CalcRat* q,char* msg,size_t msglen){
+    char* s=rat_to_str(q); double v=rat_to_double(q);
+    if(!s){ snprintf(msg,msglen,"%s(޷ʾ)  %.15g",prefix,v); return; }
+    if(strlen(s)<=40){
+        if(rat_is_int(q)) snprintf(msg,msglen,"%s%s",prefix,s);
+        else snprintf(msg,msglen,"%s%s  %.15g",prefix,s,v);
+    }else{
+        char* d=strchr(s,'/'); int nn=(int)((d? (size_t)(d-s) : strlen(s))-(q->neg? 1 : 0));
+        if(d) snprintf(msg,msglen,"%s %d λ/ĸ %d λ  %.15g (/exact show)",prefix,nn,(int)strlen(d+1),v);
+        else snprintf(msg,msglen,"%s%d λ  %.15g (/exact show)",prefix,nn,v);
     }
-    if(!started) putchar('0');
+    calc_free(s);
 }
 
-/*  1 ʾѴ */
-static int handle_command_local(char* line,char* msg,size_t msglen){
-    char *cmd,*arg;
+/* ------------ Աģʽ/progֵ ------------
+ *  double ·Ĵʷ/﷨C ȼ ~ - * / % + - << >> & ^ |
+ * ֧ 0x 0o 0b ǰ׺ _ ָ rotl rotr popcount clz ctz
+ * ʽȱ RPN ָ calc_u64 ջֵֵͳһΪλģʽ
+ * ޷Žص bits λзٷչ 64 λ wrap ȡģ checked  */
+typedef enum {
+    PG_NUM, PG_NEG, PG_NOT, PG_MUL, PG_DIV, PG_MOD, PG_ADD, PG_SUB,
+    PG_SHL, PG_SHR, PG_AND, PG_XOR, PG_OR, PG_ROTL, PG_ROTR, PG_POPCNT, PG_CLZ, PG_CTZ
+} ProgOp;
+typedef struct { ProgOp op; calc_u64 v; } ProgIns;
+typedef struct { ProgIns ins[MAX_TOKENS]; int n; } ProgCode;
+typedef struct { int on, bits, sgn, checked, base; } ProgMode;
+static ProgMode g_prog = {0, 64, 1, 0, 16};
+static calc_u64 g_last_prog = 0;      /* ϴνλģʽ/prog µ ans */
+static int      g_last_prog_ok = 0;
 
-    if(line[0] != '/') return 0;
-    cmd = strtok(line," \t\r\n");
-    arg = strtok(NULL,"");
+static calc_u64 prog_mask_local(void){ return (g_prog.bits>=64)? ~(calc_u64)0 : (((calc_u64)1<<g_prog.bits)-1); }
+static calc_u64 prog_norm_local(calc_u64 x){
+    calc_u64 m=prog_mask_local();
+    x&=m;
+    if(g_prog.sgn && g_prog.bits<64 && (x>>(g_prog.bits-1)&1)) x|=~m;
+    return x;
+}
+static int prog_neg_local(calc_u64 x){ return g_prog.sgn && (x>>63); }
+/* ʱ |x| λģʽзʱ x Ϊ룩 */
+static calc_u64 prog_abs_local(calc_u64 x){ return prog_neg_local(x)? (calc_u64)0-x : x; }
+/* ѧϵĽ (neg, mag) ŻλΧ 0 */
+static int prog_fit_local(int neg,calc_u64 mag,calc_u64* r){
+    calc_u64 lim;
+    if(!g_prog.sgn){ *r=(neg? (calc_u64)0-mag : mag)&prog_mask_local(); return (!neg || mag==0) && mag<=prog_mask_local(); }
+    lim=(calc_u64)1<<(g_prog.bits-1);   /* |min| */
+    *r=prog_norm_local(neg? (calc_u64)0-mag : mag);
+    return neg? mag<=lim : mag<lim;
+}
+static double prog_to_double_local(calc_u64 x){ return g_prog.sgn? (double)(calc_s64)x : (double)x; }
+/* ƣx Ϊչλģʽ */
+static calc_u64 prog_sar_local(calc_u64 x,unsigned n){ return (x>>63)? ~((~x)>>n) : x>>n; }
+static calc_u64 prog_popcount_local(calc_u64 x){
+    x=x-((x>>1)&CALC_U64(0x55555555,0x55555555));
+    x=(x&CALC_U64(0x33333333,0x33333333))+((x>>2)&CALC_U64(0x33333333,0x33333333));
+    x=(x+(x>>4))&CALC_U64(0x0F0F0F0F,0x0F0F0F0F);
+    return (x*CALC_U64(0x01010101,0x01010101))>>56;
+}
+static int prog_clz_local(calc_u64 x){
+    int n=0;
+    if(x==0) return 64;
+    if(!(x>>32)){ n+=32; x<<=32; }
+    if(!(x>>48)){ n+=16; x<<=16; }
+    if(!(x>>56)){ n+=8; x<<=8; }
+    if(!(x>>60)){ n+=4; x<<=4; }
+    if(!(x>>62)){ n+=2; x<<=2; }
+    if(!(x>>63)) n+=1;
+    return n;
+}
 
-    if(is_cmd_local(cmd,"/help")){
-        snprintf(msg,msglen,": /deg /rad /mc /mr /m+ [v] /m- [v] /history /save f /let x=expr /vars /del x /diff e v x0 [h] /solve e v x0 [maxit tol] /integ e v a b [n] /plot e v xmin xmax [w h] /hex n /bin n /quit");
-        return 1;
+/* ---- 룺ݹ½ֱӲ RPN ---- */
+typedef struct { const char* s; size_t i; ProgCode* c; char* er; size_t em; int depth; } ProgParser;
+static void prog_skip_local(ProgParser* p){ while(p->s[p->i] && (unsigned char)p->s[p->i]<=' ') p->i++; }
+static int prog_emit_local(ProgParser* p,ProgOp op,calc_u64 v){
+    if(p->c->n>=MAX_TOKENS){ snprintf(p->er,p->em,"ʽ"); return 0; }
+    p->c->ins[p->c->n].op=op; p->c->ins[p->c->n].v=v; p->c->n++;
+    return 1;
+}
+/* ʮƻ 0x/0o/0bɺ _neg Ϊǰĸ */
+static int prog_number_local(ProgParser* p,int neg){
+    const char* s=p->s; size_t i=p->i; unsigned base=10; calc_u64 v=0; int nd=0, over=0;
+    if(s[i]=='0' && (s[i+1]=='x'||s[i+1]=='X')){ base=16; i+=2; }
+    else if(s[i]=='0' && (s[i+1]=='o'||s[i+1]=='O')){ base=8; i+=2; }
+    else if(s[i]=='0' && (s[i+1]=='b'||s[i+1]=='B')){ base=2; i+=2; }
+    for(;;++i){
+        int c=(unsigned char)s[i], d;
+        if(c=='_') continue;
+        if(isdigit(c)) d=c-'0';
+        else if(base==16 && isxdigit(c)) d=tolower(c)-'a'+10;
+        else break;
+        if((unsigned)d>=base){ snprintf(p->er,p->em,"Ƿ %u : %c",base,c); return 0; }
+        if(v>(~(calc_u64)0-(calc_u64)d)/base) over=1;
+        v=v*base+(calc_u64)d; nd++;
     }
-    if(is_cmd_local(cmd,"/deg")){ g_mode=MODE_DEG; snprintf(msg,msglen,"л DEG"); return 1; }
-    if(is_cmd_local(cmd,"/rad")){ g_mode=MODE_RAD; snprintf(msg,msglen,"л RAD"); return 1; }
-
-    if(is_cmd_local(cmd,"/mc")){ g_memory=0.0; snprintf(msg,msglen,"Memory cleared"); return 1; }
-    if(is_cmd_local(cmd,"/mr")){ snprintf(msg,msglen,"MR = %.15g",g_memory); g_last_result=g_memory; var_set("ans",g_last_result); return 1; }
-    if(is_cmd_local(cmd,"/m+")){
-        double v=g_last_result; if(arg) v=atof(arg);
-        g_memory += v; snprintf(msg,msglen,"M += %.15g -> %.15g",v,g_memory); return 1;
+    if(nd==0 || isalnum((unsigned char)s[i]) || s[i]=='.'){ snprintf(p->er,p->em,"Ƿ֣/prog ֻ"); return 0; }
+    p->i=i;
+    /* ʮưֵ鷶Χưλģʽ bits λ */
+    if(base==10){
+        calc_u64 r;
+        /* wrap ģʽ޷ŵĸƣ C ͬ */
+        if(over || (!prog_fit_local(neg,v,&r) && (g_prog.checked || g_prog.sgn || !neg || v>prog_mask_local()))){ snprintf(p->er,p->em," %s%d Χ",g_prog.sgn? "int" : "uint",g_prog.bits); return 0; }
+        return prog_emit_local(p,PG_NUM,r);
     }
-    if(is_cmd_local(cmd,"/m-")){
-        double v=g_last_result; if(arg) v=atof(arg);
-        g_memory -= v; snprintf(msg,msglen,"M -= %.15g -> %.15g",v,g_memory); return 1;
+    if(over || v>prog_mask_local()){ snprintf(p->er,p->em," %d λ",g_prog.bits); return 0; }
+    if(!prog_emit_local(p,PG_NUM,prog_norm_local(v))) return 0;
+    return neg? prog_emit_local(p,PG_NEG,0) : 1;
+}
+static int prog_expr_local(ProgParser* p,int level);
+static int prog_ident_local(ProgParser* p){
+    char name[NAME_LEN]; int j=0, na=0, want;
+    static const char* fns[]={"rotl","rotr","popcount","clz","ctz"};
+    static const ProgOp fop[]={PG_ROTL,PG_ROTR,PG_POPCNT,PG_CLZ,PG_CTZ};
+    static const int far[]={2,2,1,1,1};
+    int k;
+    while((isalnum((unsigned char)p->s[p->i]) || p->s[p->i]=='_') && j<NAME_LEN-1) name[j++]=(char)tolower((unsigned char)p->s[p->i++]);
+    name[j]='\0';
+    prog_skip_local(p);
+    for(k=0;k<5;++k) if(strcmp(name,fns[k])==0) break;
+    if(k<5){
+        if(p->s[p->i]!='('){ snprintf(p->er,p->em,"%s ȱ (",name); return 0; }
+        p->i++; want=far[k];
+        prog_skip_local(p);
+        if(p->s[p->i]!=')'){
+            for(;;){
+                if(!prog_expr_local(p,0)) return 0;
+                na++;
+                prog_skip_local(p);
+                if(p->s[p->i]==','){ p->i++; continue; }
+                break;
+            }
+        }
+        if(p->s[p->i]!=')'){ snprintf(p->er,p->em,"Ųƥ"); return 0; }
+        p->i++;
+        if(na!=want){ snprintf(p->er,p->em,"%s Ҫ%d",name,want); return 0; }
+        return prog_emit_local(p,fop[k],0);
     }
-    if(is_cmd_local(cmd,"/history")){
-        clear_screen(); history_print(); printf("\nس..."); getchar();
-        msg[0]='\0'; return 1;
+    {
+        double v; calc_u64 r;
+        if(strcmp(name,"ans")==0){
+            if(g_last_prog_ok && prog_to_double_local(g_last_prog)==g_last_result) return prog_emit_local(p,PG_NUM,prog_norm_local(g_last_prog));
+            v=g_last_result;
+        }else if(!var_get(name,&v)){ snprintf(p->er,p->em,"δ: %s",name); return 0; }
+        if(v!=floor(v) || !(fabs(v)<9.2233720368547758e18)){ snprintf(p->er,p->em," %s  64 λ",name); return 0; }
+        if(!prog_fit_local(v<0,(calc_u64)fabs(v),&r) && g_prog.checked){ snprintf(p->er,p->em," %s  %d λΧ",name,g_prog.bits); return 0; }
+        return prog_emit_local(p,PG_NUM,r);
     }
-    if(is_cmd_local(cmd,"/save")){
-        char* f = arg; if(!f || !*f){ snprintf(msg,msglen,"÷: /save <file>"); return 1; }
-        trim_spaces(f);
-        if(history_save(f)==0) snprintf(msg,msglen,"ʷѱ: %s",f);
-        else snprintf(msg,msglen,"ʧ");
-        return 1;
+}
+static int prog_unary_local(ProgParser* p){
+    char c;
+    prog_skip_local(p);
+    c=p->s[p->i];
+    if(++p->depth>200){ snprintf(p->er,p->em,"Ƕ׹"); return 0; }
+    if(c=='-' && isdigit((unsigned char)p->s[p->i+1])){ p->i++; if(!prog_number_local(p,1)) return 0; }
+    else if(c=='-' || c=='~'){
+        p->i++;
+        if(!prog_unary_local(p) || !prog_emit_local(p,c=='-'? PG_NEG : PG_NOT,0)) return 0;
+    }else if(c=='+'){ p->i++; if(!prog_unary_local(p)) return 0; }
+    else if(c=='('){
+        p->i++;
+        if(!prog_expr_local(p,0)) return 0;
+        prog_skip_local(p);
+        if(p->s[p->i]!=')'){ snprintf(p->er,p->em,"Ųƥ"); return 0; }
+        p->i++;
+    }else if(isdigit((unsigned char)c)){ if(!prog_number_local(p,0)) return 0; }
+    else if(isalpha((unsigned char)c) || c=='_'){ if(!prog_ident_local(p)) return 0; }
+    else if(c){ snprintf(p->er,p->em,"Ƿַ: %c",c); return 0; }
+    else{ snprintf(p->er,p->em,"ʽ"); return 0; }
+    p->depth--;
+    return 1;
+}
+/* level 0..5| ^ & λ Ӽ ˳ģ */
+static int prog_expr_local(ProgParser* p,int level){
+    if(level>5) return prog_unary_local(p);
+    if(!prog_expr_local(p,level+1)) return 0;
+    for(;;){
+        const char* s; ProgOp op;
+        prog_skip_local(p);
+        s=p->s+p->i;
+        if(level==0 && s[0]=='|') op=PG_OR;
+        else if(level==1 && s[0]=='^') op=PG_XOR;
+        else if(level==2 && s[0]=='&') op=PG_AND;
+        else if(level==3 && s[0]=='<' && s[1]=='<') op=PG_SHL;
+        else if(level==3 && s[0]=='>' && s[1]=='>') op=PG_SHR;
+        else if(level==4 && (s[0]=='+' || s[0]=='-')) op=(s[0]=='+')? PG_ADD : PG_SUB;
+        else if(level==5 && (s[0]=='*' || s[0]=='/' || s[0]=='%')) op=(s[0]=='*')? PG_MUL : (s[0]=='/')? PG_DIV : PG_MOD;
+        else return 1;
+        p->i+=(op==PG_SHL || op==PG_SHR)? 2 : 1;
+        if(!prog_expr_local(p,level+1) || !prog_emit_local(p,op,0)) return 0;
     }
-    if(is_cmd_local(cmd,"/vars")){ clear_screen(); var_list(); printf("\nس..."); getchar(); msg[0]='\0'; return 1; }
-    if(is_cmd_local(cmd,"/del")){
-        char* name = arg; if(!name){ snprintf(msg,msglen,"÷: /del <name>"); return 1; }
-        trim_spaces(name); if(var_del(name)) snprintf(msg,msglen,"ɾ: %s",name); else snprintf(msg,msglen,"ڱ: %s",name);
-        return 1;
+}
+static int prog_compile(const char* s,ProgCode* c,char* er,size_t em){
+    ProgParser p;
+    p.s=s; p.i=0; p.c=c; p.er=er; p.em=em; p.depth=0; c->n=0;
+    if(!prog_expr_local(&p,0)) return 0;
+    prog_skip_local(&p);
+    if(s[p.i]){ snprintf(er,em,s[p.i]==')'? "Ųƥ" : "޷: %.20s",s+p.i); return 0; }
+    return 1;
+}
+
+/* ---- ֵ ---- */
+static int prog_overflow_local(const char* what,char* er,size_t em){
+    snprintf(er,em,"%s  %s%dchecked",what,g_prog.sgn? "int" : "uint",g_prog.bits);
+    return 0;
+}
+static int prog_run(const ProgCode* c,calc_u64* out,char* er,size_t em){
+    calc_u64 st[MAX_STACK], a, b, r, m=prog_mask_local(); int sp=0, i, w=g_prog.bits;
+    for(i=0;i<c->n;++i){
+        ProgOp op=c->ins[i].op;
+        if(op==PG_NUM){
+            if(sp>=MAX_STACK){ snprintf(er,em,"ջ"); return 0; }
+            st[sp++]=c->ins[i].v; continue;
+        }
+        if(op==PG_NEG || op==PG_NOT || op==PG_POPCNT || op==PG_CLZ || op==PG_CTZ){
+            a=st[sp-1];
+            switch(op){
+                case PG_NEG:
+                    if(g_prog.checked && !prog_fit_local(!prog_neg_local(a),prog_abs_local(a),&r)) return prog_overflow_local("ȡ",er,em);
+                    r=prog_norm_local((calc_u64)0-a); break;
+                case PG_NOT: r=prog_norm_local(~a); break;
+                case PG_POPCNT: r=prog_popcount_local(a&m); break;
+                case PG_CLZ: r=(calc_u64)(prog_clz_local(a&m)-(64-w)); break;
+                default: r=(a&m)? prog_popcount_local(((a&m)&((calc_u64)0-(a&m)))-1) : (calc_u64)w; break;
+            }
+            st[sp-1]=r; continue;
+        }
+        b=st[--sp]; a=st[sp-1];
+        switch(op){
+            case PG_ADD: case PG_SUB: {   /* checked+ֵֵжϷΧ */
+                int na=prog_neg_local(a), nb=prog_neg_local(b)^(op==PG_SUB), neg, wrap=0;
+                calc_u64 ma=prog_abs_local(a), mb=prog_abs_local(b), mag;
+                if(na==nb){ mag=ma+mb; neg=na; wrap=(mag<ma); }
+                else if(ma>=mb){ mag=ma-mb; neg=na; }
+                else{ mag=mb-ma; neg=nb; }
+                if(g_prog.checked && (wrap || !prog_fit_local(neg,mag,&mag))) return prog_overflow_local(op==PG_ADD? "ӷ" : "",er,em);
+                r=prog_norm_local(op==PG_ADD? a+b : a-b);
+                break;
+            }
+            case PG_MUL: {
+                calc_u64 ma=prog_abs_local(a), mb=prog_abs_local(b);
+                r=prog_norm_local(a*b);
+                if(g_prog.checked && ma && mb){
+                    calc_u64 t;
+                    if((((ma|mb)>>32) && ma>~(calc_u64)0/mb) || !prog_fit_local(prog_neg_local(a)^prog_neg_local(b),ma*mb,&t))
+                        return prog_overflow_local("˷",er,em);
+                }
+                break;
+            }
+            case PG_DIV: case PG_MOD: {
+                calc_u64 ma=prog_abs_local(a), mb=prog_abs_local(b), q;
+                if((b&m)==0){ snprintf(er,em,op==PG_DIV? "" : "ģ"); return 0; }
+                q=ma/mb;
+                if(op==PG_DIV){   /* ض */
+                    if(g_prog.checked && !prog_fit_local(prog_neg_local(a)^prog_neg_local(b),q,&r)) return prog_overflow_local("",er,em);
+                    r=prog_norm_local((prog_neg_local(a)^prog_neg_local(b))? (calc_u64)0-q : q);
+                }else{            /* 뱻ͬ */
+                    r=prog_norm_local(prog_neg_local(a)? (calc_u64)0-(ma-q*mb) : ma-q*mb);
+                }
+                break;
+            }
+            case PG_SHL: case PG_SHR: {
+                calc_u64 n=b&m;
+                if(prog_neg_local(b) || n>=(calc_u64)w){ snprintf(er,em,"λλ 0..%d",w-1); return 0; }
+                if(op==PG_SHL){   /* checkedƻȥòԭֵ */
+                    r=prog_norm_local(a<<n);
+                    if(g_prog.checked && (g_prog.sgn? prog_sar_local(r,(unsigned)n)!=a : ((r&m)>>n)!=(a&m)))
+                        return prog_overflow_local("",er,em);
+                }else r=g_prog.sgn? prog_sar_local(a,(unsigned)n) : (a&m)>>n;
+                break;
+            }
+            case PG_AND: r=a&b; break;
+            case PG_XOR: r=a^b; break;
+            case PG_OR:  r=a|b; break;
+            case PG_ROTL: case PG_ROTR: {
+                /* λΪ 2 ݣ n  -n (mod w) */
+                unsigned k=(unsigned)(((op==PG_ROTL)? b : (calc_u64)0-b)&(calc_u64)(w-1));
+                calc_u64 x=a&m;
+                r=prog_norm_local(k? (x<<k)|(x>>(w-k)) : x);
+                break;
+            }
+            default: snprintf(er,em,"δ֪"); return 0;
+        }
+        st[sp-1]=r;
+    }
+    if(sp!=1){ snprintf(er,em,"ʽ(ջʣ=%d)",sp); return 0; }
+    *out=st[0];
+    return 1;
+}
+
+static int eval_prog_local(const char* expr,calc_u64* out,char* er,size_t em){
+    static ProgCode code;
+    return prog_compile(expr,&code,er,em) && prog_run(&code,out,er,em);
+}
+/* λģʽ base2/8/10/16ʮưǰ/޷Ž */
+static void prog_format_local(calc_u64 x,int base,char* out,size_t n){
+    char buf[72]; int p=71, neg=0; calc_u64 u;
+    const char* pre=(base==16)? "0x" : (base==8)? "0o" : (base==2)? "0b" : "";
+    buf[p]='\0';
+    if(base==10){ neg=prog_neg_local(x); u=neg? (calc_u64)0-x : x; }
+    else u=x&prog_mask_local();
+    do{ buf[--p]="0123456789ABCDEF"[u%(calc_u64)base]; u/=(calc_u64)base; }while(u);
+    snprintf(out,n,"%s%s%s",neg? "-" : "",pre,buf+p);
+}
+static void prog_result_msg_local(calc_u64 x,char* msg,size_t msglen){
+    char a[80], b[80];
+    prog_format_local(x,g_prog.base,a,sizeof(a));
+    prog_format_local(x,g_prog.base==10? 16 : 10,b,sizeof(b));
+    if(strlen(a)+strlen(b)<=58) snprintf(msg,msglen," = %s = %s",a,b);
+    else snprintf(msg,msglen," = %s",a);
+}
+
+/*  var=val  expr */
+static int eval_with_var(const char* expr,const char* vname,double x,double* out,char* err,size_t emlen){
+    double old=0.0; int existed=var_get(vname,&old), ok;
+    var_set(vname,x);
+    ok=eval_expr_local(expr,out,err,emlen);
+    if(existed) var_set(vname,old); else var_del(vname);
+    return ok;
+}
+
+/* ------------ Ԥֵ ------------ */
+/* ʽֻһδʷ + RPN󶨱Ϊۺţ/ans ̻Ϊ
+ * ֮ÿ CALC_LANES Ϊһ token 㣻ֵʧܵĵΪ NaN */
+#define CALC_LANES 64
+typedef struct {
+    CalcTokenList rpn;
+    int     nslots;
+    int     depth;   /* ջ */
+    int     fast;    /*  0 ʱ sin/cos/exp/ln/pow ߿ٽں */
+    int     f32;     /*  0 ʱ calc_eval_batch  float · */
+    double* stack;   /* depth*CALC_LANES Ĺ */
+    float*  fstack;  /* float ·ĹСͬ */
+} CalcProgram;
+/* plot/sweep/montecarlo ֵѡ */
+#define CALC_OPT_FAST 1
+#define CALC_OPT_F32  2
+
+static int calc_compile(const char* expr,const char* const* names,int nnames,CalcProgram* prog,char* err,size_t em){
+    CalcTokenList tl; int i,k,sp=0,need;
+    prog->stack=NULL; prog->fstack=NULL; prog->nslots=nnames; prog->depth=0; prog->fast=0; prog->f32=0;
+    if(nnames>MAX_BIND){ snprintf(err,em,"󶨱(>%d)",MAX_BIND); return 0; }
+    if(!tokenize_local(expr,&tl,err,em)) return 0;
+    if(!to_rpn_local(&tl,&prog->rpn,err,em)) return 0;
+    for(i=0;i<prog->rpn.count;++i){
+        CalcToken* tk=&prog->rpn.items[i];
+        if(tk->type==CALC_T_IDENT){
+            for(k=0;k<nnames;++k) if(strcmp(tk->name,names[k])==0) break;
+            if(k<nnames){ tk->type=CALC_T_SLOT; tk->arity=k; }
+            else{
+                double v;
+                if(strcmp(tk->name,"ans")==0) v=g_last_result;
+                else if(!var_get(tk->name,&v)){ snprintf(err,em,"δ: %s",tk->name); return 0; }
+                tk->type=CALC_T_NUMBER; tk->value=v; tk->lo=0.0; tk->srclen=0;
+            }
+        }
+        /* ģջ˳ṹ */
+        if(tk->type==CALC_T_NUMBER || tk->type==CALC_T_SLOT) need=0;
+        else if(tk->type==CALC_T_OPERATOR) need=(is_postfix_local(tk->op)||tk->op==OP_UNARY_MINUS)? 1 : 2;
+        else if(tk->type==CALC_T_FUNC) need=tk->arity;
+        else { snprintf(err,em,"RPN Ƿ token"); return 0; }
+        if(sp<need){ snprintf(err,em,"ȱٲ"); return 0; }
+        sp=sp-need+1;
+        if(sp>prog->depth) prog->depth=sp;
+    }
+    if(sp!=1){ snprintf(err,em,"ʽ(ջʣ=%d)",sp); return 0; }
+    prog->stack=(double*)calc_pool_alloc(MEM_CODE,sizeof(double)*(size_t)prog->depth*CALC_LANES);
+    prog->fstack=(float*)calc_pool_alloc(MEM_CODE,sizeof(float)*(size_t)prog->depth*CALC_LANES);
+    if(!prog->stack || !prog->fstack){
+        calc_pool_free(prog->stack); calc_pool_free(prog->fstack); prog->stack=NULL; prog->fstack=NULL;
+        snprintf(err,em,"ڴ治"); return 0;
+    }
+    return 1;
+}
+static void calc_program_free(CalcProgram* prog){
+    calc_pool_free(prog->stack);
+    calc_pool_free(prog->fstack);
+    prog->stack=NULL; prog->fstack=NULL;
+}
+
+/* ٽںˣ/fastһ lane ԭؼ㣬ѭ޷֧ libm á޲
+ * ÷Χ lane ѭ libm뾫ȷģʽͬ NaN ʾ
+ *  libmʵ README
+ *   exp      Cody-Waite Լ |r|<=ln2/27  Taylor             ~7e-9
+ *   ln       λָʹ m[1/2,2)atanh  s^9          ~2e-9
+ *   sin/cos  Լ |r|<=/4/żʽ r^9 / r^10           ~2e-9|x|<=1e5
+ *   pow      a>0 ʱ exp(bln a) libm                     ~1e-8max(1,|bln a|) */
+typedef union { double d; calc_u64 u; } CalcF64Bits;
+#define FAST_SHIFT   6755399441055744.0   /* 1.5*2^52ϺβλΪͽȡ */
+#define FAST_LN2_HI  6.93147180369123816490e-01
+#define FAST_LN2_LO  1.90821492927058770002e-10
+#define FAST_PIO2_HI 1.57079632673412561417e+00
+#define FAST_PIO2_LO 6.07710050650619224932e-11
+#define FAST_SQRTH_BITS CALC_U64(0x3fe6a09eUL,0x667f3bcdUL)   /* 1/2 λģʽ */
+
+static void fast_exp_batch(double* a,int m){
+    double y[CALC_LANES]; int l;
+    for(l=0;l<m;++l){
+        double x=a[l], k, r, p; CalcF64Bits t;
+        t.d=x*1.44269504088896338700+FAST_SHIFT; k=t.d-FAST_SHIFT;
+        r=(x-k*FAST_LN2_HI)-k*FAST_LN2_LO;
+        p=1.0+r*(1.0+r*(1.0/2+r*(1.0/6+r*(1.0/24+r*(1.0/120+r*(1.0/720+r*(1.0/5040)))))));
+        t.u=(t.u+1023)<<52;   /* 2^k */
+        y[l]=p*t.d;
+    }
+    for(l=0;l<m;++l) a[l]=(a[l]>-708.0 && a[l]<709.0)? y[l] : exp(a[l]);
+}
+static void fast_log_batch(double* a,int m){
+    double y[CALC_LANES]; int l;
+    for(l=0;l<m;++l){
+        double e, f, s, z; CalcF64Bits b;
+        b.d=a[l];
+        b.u+=CALC_U64(0x3ff00000UL,0)-FAST_SQRTH_BITS;   /* ָ 1/2 λ */
+        e=(double)(long)(b.u>>52)-1023.0;
+        b.u=(b.u&CALC_U64(0x000fffffUL,0xffffffffUL))+FAST_SQRTH_BITS;
+        f=b.d;
+        s=(f-1.0)/(f+1.0); z=s*s;
+        y[l]=e*FAST_LN2_HI+(2.0*s*(1.0+z*(1.0/3+z*(1.0/5+z*(1.0/7+z*(1.0/9)))))+e*FAST_LN2_LO);
+    }
+    for(l=0;l<m;++l) a[l]=(a[l]>=DBL_MIN && a[l]<=DBL_MAX)? y[l] : (a[l]>0.0)? log(a[l]) : NAN;
+}
+/* cosq=0  sincosq=1  cosƽһ񣩣밴ǰǶģʽ */
+static void fast_sincos_batch(double* a,int m,int cosq){
+    double y[CALC_LANES], sc=(g_mode==MODE_DEG)? M_PI/180.0 : 1.0; int l;
+    for(l=0;l<m;++l){
+        double x=a[l]*sc, q, r, z, sv, cv, w, sg; CalcF64Bits t; int n;
+        a[l]=x;
+        t.d=x*0.63661977236758134308+FAST_SHIFT; q=t.d-FAST_SHIFT;
+        r=(x-q*FAST_PIO2_HI)-q*FAST_PIO2_LO;
+        z=r*r;
+        sv=r+r*z*(-1.0/6+z*(1.0/120+z*(-1.0/5040+z*(1.0/362880))));
+        cv=1.0-0.5*z+z*z*(1.0/24+z*(-1.0/720+z*(1.0/40320+z*(-1.0/3628800))));
+        n=(int)((t.u+(calc_u64)cosq)&3);
+        w=(double)(n&1); sg=1.0-(double)(n&2);
+        y[l]=sg*(sv+w*(cv-sv));
+    }
+    for(l=0;l<m;++l) a[l]=(fabs(a[l])<=1e5)? y[l] : cosq? cos(a[l]) : sin(a[l]);
+}
+static void fast_pow_batch(double* a,const double* b,int m){
+    double t[CALC_LANES], u[CALC_LANES]; int l, n;
+    /*  x^2x^3 ȣָڸ lane ͬöƳ˷ ulp */
+    for(l=1;l<m && b[l]==b[0];++l) ;
+    if(m>0 && l==m && b[0]==floor(b[0]) && fabs(b[0])<=16.0){
+        n=(int)fabs(b[0]);
+        for(l=0;l<m;++l){ t[l]=a[l]; u[l]=1.0; }
+        for(;n;n>>=1){
+            if(n&1) for(l=0;l<m;++l) u[l]*=t[l];
+            if(n>1) for(l=0;l<m;++l) t[l]*=t[l];
+        }
+        for(l=0;l<m;++l){
+            double y=(b[0]<0.0)? 1.0/u[l] : u[l];
+            a[l]=(isfinite(y) || !isfinite(a[l]))? y : NAN;   /*  0 ĸͬȷģʽΪ NaN */
+        }
+        return;
+    }
+    memcpy(t,a,sizeof(double)*(size_t)m);
+    fast_log_batch(t,m);
+    for(l=0;l<m;++l){ t[l]*=b[l]; u[l]=t[l]; }
+    fast_exp_batch(t,m);
+    for(l=0;l<m;++l){
+        if(a[l]>0.0 && u[l]>-708.0 && u[l]<709.0) a[l]=t[l];
+        else{ errno=0; a[l]=pow(a[l],b[l]); if(errno==EDOM||errno==ERANGE) a[l]=NAN; }
+    }
+}
+/* a/b Ϊһ/ m  laneд aֵ֧ĺ 0ͨں˴ */
+static int fast_func_batch(int fn,double* a,const double* b,int m){
+    switch(fn){
+        case FN_SIN: fast_sincos_batch(a,m,0); return 1;
+        case FN_COS: fast_sincos_batch(a,m,1); return 1;
+        case FN_EXP: fast_exp_batch(a,m); return 1;
+        case FN_LN:  fast_log_batch(a,m); return 1;
+        case FN_POW: fast_pow_batch(a,b,m); return 1;
+    }
+    return 0;
+}
+
+/* ------------ float32 ·--f32 ------------ */
+/* ջΪ floatͬ 64  lane һ飬ݴ롣
+ * exp/ln/sin/cos  float ʽsin/cos Լ double ȣ
+ * pow  double ں˺ضϣຯ lane ת double ͨںˡ
+ *  double · --bench-f32 棬Ϊ 1~2  float ulp~1e-7 */
+typedef union { float f; calc_u32 u; } CalcF32Bits;
+#define FAST_SHIFT_F 12582912.0f   /* 1.5*2^23 */
+
+static void f32_exp_batch(float* a,int m){
+    float y[CALC_LANES]; int l;
+    for(l=0;l<m;++l){
+        float x=a[l], k, r, p; CalcF32Bits t;
+        t.f=x*1.44269504f+FAST_SHIFT_F; k=t.f-FAST_SHIFT_F;
+        r=(x-k*0.693145751953125f)-k*1.42860677e-6f;
+        p=1.0f+r*(1.0f+r*(0.5f+r*(1.0f/6+r*(1.0f/24+r*(1.0f/120+r*(1.0f/720))))));
+        t.u=((t.u+127u)<<23)&0x7fffffffu;   /* 2^k */
+        y[l]=p*t.f;
+    }
+    for(l=0;l<m;++l) a[l]=(a[l]>-87.0f && a[l]<88.0f)? y[l] : (float)exp((double)a[l]);
+}
+static void f32_log_batch(float* a,int m){
+    float y[CALC_LANES]; int l;
+    for(l=0;l<m;++l){
+        float e, f, s, z; CalcF32Bits b;
+        b.f=a[l];
+        b.u+=0x3f800000u-0x3f3504f3u;   /* 0x3f3504f3 Ϊ 1/2 */
+        e=(float)(int)((b.u>>23)&0x1ff)-127.0f;
+        b.u=(b.u&0x007fffffu)+0x3f3504f3u;
+        f=b.f;
+        s=(f-1.0f)/(f+1.0f); z=s*s;
+        y[l]=e*0.693145751953125f+(2.0f*s*(1.0f+z*(1.0f/3+z*(1.0f/5+z*(1.0f/7+z*(1.0f/9)))))+e*1.42860677e-6f);
+    }
+    for(l=0;l<m;++l) a[l]=(a[l]>=FLT_MIN && a[l]<=FLT_MAX)? y[l] : (a[l]>0.0f)? (float)log((double)a[l]) : (float)NAN;
+}
+static void f32_sincos_batch(float* a,int m,int cosq){
+    float y[CALC_LANES]; double sc=(g_mode==MODE_DEG)? M_PI/180.0 : 1.0; int l;
+    for(l=0;l<m;++l){
+        double x=a[l]*sc; float r, z, sv, cv, w, sg; CalcF64Bits t; int n;
+        t.d=x*0.63661977236758134308+FAST_SHIFT;
+        r=(float)((x-(t.d-FAST_SHIFT)*FAST_PIO2_HI)-(t.d-FAST_SHIFT)*FAST_PIO2_LO);
+        z=r*r;
+        sv=r+r*z*(-1.0f/6+z*(1.0f/120+z*(-1.0f/5040+z*(1.0f/362880))));
+        cv=1.0f-0.5f*z+z*z*(1.0f/24+z*(-1.0f/720+z*(1.0f/40320)));
+        n=(int)((t.u+(calc_u64)cosq)&3);
+        w=(float)(n&1); sg=1.0f-(float)(n&2);
+        y[l]=sg*(sv+w*(cv-sv));
+    }
+    for(l=0;l<m;++l){
+        double x=a[l]*sc;
+        a[l]=(fabs(x)<=1e5)? y[l] : (float)(cosq? cos(x) : sin(x));
+    }
+}
+
+/* in[k] Ϊ k  n  float ȡֵout д n  float  */
+static void calc_eval_batch_f32(CalcProgram* prog,const float* const* in,int n,float* out){
+    float* st=prog->fstack;
+    double da[CALC_LANES], db[CALC_LANES];
+    int base,m,i,l,k,sp;
+    char er[128];
+#define FST_(d) (st+(size_t)(d)*CALC_LANES)
+    for(base=0;base<n;base+=CALC_LANES){
+        m=n-base; if(m>CALC_LANES) m=CALC_LANES;
+        sp=0;
+        for(i=0;i<prog->rpn.count;++i){
+            const CalcToken* tk=&prog->rpn.items[i];
+            float *a,*b;
+            if(tk->type==CALC_T_NUMBER){
+                float v=(float)tk->value;
+                a=FST_(sp++); for(l=0;l<m;++l) a[l]=v;
+            }else if(tk->type==CALC_T_SLOT){
+                a=FST_(sp++); memcpy(a,in[tk->arity]+base,sizeof(float)*(size_t)m);
+            }else if(tk->type==CALC_T_OPERATOR){
+                a=FST_(sp-1);
+                if(tk->op==OP_UNARY_MINUS){ for(l=0;l<m;++l) a[l]=-a[l]; continue; }
+                if(tk->op==OP_PERCENT){ for(l=0;l<m;++l) a[l]*=0.01f; continue; }
+                if(tk->op==OP_FACT){
+                    for(l=0;l<m;++l) a[l]=factorial_ok_local(a[l])? (float)factorial_val_local(a[l]) : (float)NAN;
+                    continue;
+                }
+                b=a; a=FST_(sp-2); sp--;
+                switch(tk->op){
+                    case OP_ADD: for(l=0;l<m;++l) a[l]+=b[l]; break;
+                    case OP_SUB: for(l=0;l<m;++l) a[l]-=b[l]; break;
+                    case OP_MUL: for(l=0;l<m;++l) a[l]*=b[l]; break;
+                    case OP_DIV: for(l=0;l<m;++l) a[l]=(b[l]==0.0f)? (float)NAN : a[l]/b[l]; break;
+                    case OP_POW:
+                        for(l=0;l<m;++l){ da[l]=a[l]; db[l]=b[l]; }
+                        fast_pow_batch(da,db,m);
+                        for(l=0;l<m;++l) a[l]=(float)da[l];
+                        break;
+                    default: for(l=0;l<m;++l) a[l]=(float)NAN; break;
+                }
+            }else{ /* CALC_T_FUNC */
+                double args[MAX_FUNC_ARGS], y;
+                sp-=tk->arity;
+                a=FST_(sp);
+                switch(tk->fn){
+                    case FN_SIN:  f32_sincos_batch(a,m,0); break;
+                    case FN_COS:  f32_sincos_batch(a,m,1); break;
+                    case FN_EXP:  f32_exp_batch(a,m); break;
+                    case FN_LN:   f32_log_batch(a,m); break;
+                    case FN_SQRT: for(l=0;l<m;++l) a[l]=(a[l]>=0.0f)? (float)sqrt(a[l]) : (float)NAN; break;
+                    case FN_ABS:  for(l=0;l<m;++l) a[l]=(a[l]<0.0f)? -a[l] : a[l]; break;
+                    case FN_POW:
+                        b=FST_(sp+1);
+                        for(l=0;l<m;++l){ da[l]=a[l]; db[l]=b[l]; }
+                        fast_pow_batch(da,db,m);
+                        for(l=0;l<m;++l) a[l]=(float)da[l];
+                        break;
+                    case FN_RAND:  rng_fill_u01(g_rng_active,da,m);    for(l=0;l<m;++l) a[l]=(float)da[l]; break;
+                    case FN_RANDN: rng_fill_normal(g_rng_active,da,m); for(l=0;l<m;++l) a[l]=(float)da[l]; break;
+                    default:
+                        for(l=0;l<m;++l){
+                            for(k=0;k<tk->arity;++k) args[k]=FST_(sp+k)[l];
+                            a[l]=calc_func_local(tk->fn,args,tk->arity,&y,er,sizeof(er))? (float)y : (float)NAN;
+                        }
+                        break;
+                }
+                sp++;
+            }
+        }
+        memcpy(out+base,FST_(0),sizeof(float)*(size_t)m);
+    }
+#undef FST_
+}
+
+/* in[k] Ϊ k  n ȡֵout д n  */
+static void calc_eval_batch_raw(CalcProgram* prog,const double* const* in,int n,double* out){
+    double* st=prog->stack;
+    int base,m,i,l,k,sp;
+    char er[128];
+    if(prog->f32){
+        /* double ӿϵ float ·ת */
+        float fin[MAX_BIND][CALC_LANES], fout[CALC_LANES]; const float* fp[MAX_BIND];
+        for(k=0;k<prog->nslots;++k) fp[k]=fin[k];
+        for(base=0;base<n;base+=CALC_LANES){
+            m=n-base; if(m>CALC_LANES) m=CALC_LANES;
+            for(k=0;k<prog->nslots;++k) for(l=0;l<m;++l) fin[k][l]=(float)in[k][base+l];
+            calc_eval_batch_f32(prog,fp,m,fout);
+            for(l=0;l<m;++l) out[base+l]=fout[l];
+        }
+        return;
+    }
+#define ST_(d) (st+(size_t)(d)*CALC_LANES)
+    for(base=0;base<n;base+=CALC_LANES){
+        m=n-base; if(m>CALC_LANES) m=CALC_LANES;
+        sp=0;
+        for(i=0;i<prog->rpn.count;++i){
+            const CalcToken* tk=&prog->rpn.items[i];
+            double *a,*b;
+            if(tk->type==CALC_T_NUMBER){
+                a=ST_(sp++); for(l=0;l<m;++l) a[l]=tk->value;
+            }else if(tk->type==CALC_T_SLOT){
+                a=ST_(sp++); memcpy(a,in[tk->arity]+base,sizeof(double)*(size_t)m);
+            }else if(tk->type==CALC_T_OPERATOR){
+                a=ST_(sp-1);
+                if(tk->op==OP_UNARY_MINUS){ for(l=0;l<m;++l) a[l]=-a[l]; continue; }
+                if(tk->op==OP_PERCENT){ for(l=0;l<m;++l) a[l]*=0.01; continue; }
+                if(tk->op==OP_FACT){
+                    for(l=0;l<m;++l) a[l]=factorial_ok_local(a[l])? factorial_val_local(a[l]) : NAN;
+                    continue;
+                }
+                b=a; a=ST_(sp-2); sp--;
+                switch(tk->op){
+                    case OP_ADD: for(l=0;l<m;++l) a[l]+=b[l]; break;
+                    case OP_SUB: for(l=0;l<m;++l) a[l]-=b[l]; break;
+                    case OP_MUL: for(l=0;l<m;++l) a[l]*=b[l]; break;
+                    case OP_DIV: for(l=0;l<m;++l) a[l]=(b[l]==0.0)? NAN : a[l]/b[l]; break;
+                    case OP_POW:
+                        if(prog->fast){ fast_pow_batch(a,b,m); break; }
+                        for(l=0;l<m;++l){
+                            errno=0; a[l]=pow(a[l],b[l]);
+                            if(errno==EDOM||errno==ERANGE) a[l]=NAN;
+                        }
+                        break;
+                    default: for(l=0;l<m;++l) a[l]=NAN; break;
+                }
+            }else{ /* CALC_T_FUNC */
+                double args[MAX_FUNC_ARGS], y;
+                sp-=tk->arity;
+                a=ST_(sp);
+                if(tk->fn==FN_RAND){ rng_fill_u01(g_rng_active,a,m); sp++; continue; }
+                if(tk->fn==FN_RANDN){ rng_fill_normal(g_rng_active,a,m); sp++; continue; }
+                if(prog->fast && fast_func_batch(tk->fn,a,ST_(sp+1),m)){ sp++; continue; }
+                for(l=0;l<m;++l){
+                    for(k=0;k<tk->arity;++k) args[k]=ST_(sp+k)[l];
+                    a[l]=calc_func_local(tk->fn,args,tk->arity,&y,er,sizeof(er))? y : NAN;
+                }
+                sp++;
+            }
+        }
+        memcpy(out+base,ST_(0),sizeof(double)*(size_t)m);
+    }
+#undef ST_
+}
+static void calc_eval_batch(CalcProgram* prog,const double* const* in,int n,double* out){
+    double t0;
+    if(!g_trace.detail){ calc_eval_batch_raw(prog,in,n,out); return; }
+    t0=calc_now(); calc_eval_batch_raw(prog,in,n,out);
+    trace_event_local("eval_batch","eval",t0,n);
+}
+/* ֵvals[k] Ӧ k׷٣ */
+static double calc_eval_point(CalcProgram* prog,const double* vals){
+    const double* in[MAX_BIND]; double y; int k;
+    for(k=0;k<prog->nslots;++k) in[k]=vals+k;
+    calc_eval_batch_raw(prog,in,1,&y);
+    return y;
+}
+
+/* ------------ UI ------------ */
+static const char* prog_mode_name_local(void){
+    static char nm[8];
+    snprintf(nm,sizeof(nm),"%sINT%d",g_prog.sgn? "" : "U",g_prog.bits);
+    return nm;
+}
+/* ʾÿ 70 ֽڣGBK ¼ 70 Уز maxb Ҳ˫ַֽĳ */
+static size_t hint_cut_local(const char* s,size_t maxb){
+    size_t i=0, k;
+    while(s[i]){
+        k=((unsigned char)s[i]>=0x81 && s[i+1])? 2 : 1;
+        if(i+k>maxb) break;
+        i+=k;
+    }
+    return i;
+}
+/* ʾõıʽ/ļ 40 ֽʱضϲ "" βʹֵܷŽ 160 ֽڵʾ */
+static const char* msg_short_local(const char* s){
+    static char buf[48];
+    size_t k;
+    if(strlen(s)<=40) return s;
+    k=hint_cut_local(s,37);
+    memcpy(buf,s,k); strcpy(buf+k,"");
+    return buf;
+}
+static void render_panel(const char* last_msg){
+    clear_screen();
+    printf(" TUI Calculator Pro \n");
+    printf(" Angle: %-3s  | Math: %-7s | Memory: %-12.6g | Last(ans): %-14.8g    \n",
+           (g_mode==MODE_DEG?"DEG":"RAD"),
+           (g_prog.on? prog_mode_name_local() : g_exact? "EXACT" : g_prec==PREC_DD? (g_fast?"DD+FAST":"DD") : (g_fast?"FAST":"LIBM")), g_memory, g_last_result);
+    printf("\n");
+    printf(" ֱʽس'=' ظһΣ/let x=3.2/vars/del x             \n");
+    printf(" ߼/diff /solve /track /integ /integn /plot /plot2d /sweep /fft  /hex /bin     \n");
+    printf(" /sum e k a b|inf /prod e k a b /limit e x p  /montecarlo e x~N(0,1) N \n");
+    printf(" /mat A=[1,2;2,1]  /mat [A]  /eig A [w V]  /svd A [U S V]   ģʽ/deg /rad  \n");
+    printf(" ʷ/history /save <file>   ڴ棺/mc /mr /m+ [v] /m- [v]   /help         \n");
+    printf("\n");
+    if(last_msg && last_msg[0]){
+        const char* p=last_msg; int ln;
+        for(ln=0; *p && ln<3; ++ln){   /* ʾУ 3  */
+            size_t k=hint_cut_local(p,70);
+            printf(" %s%.*s%*s \n", ln? "           " : "ʾ Hint: ", (int)k, p, (int)(70-k), "");
+            p+=k;
+        }
+        printf("\n");
+    }
+    printf(" ʾ sin(30)+cos(60) [/deg] | pow(2,10) | 5!+20%% | ʹñ/let x=1.2;        \n");
+    printf("      /diff sin(x) x 0.5 1e-5  | /plot sin(x) x -3.14 3.14 70 20                   \n");
+    printf("\n");
+}
+
+/* ------------  ------------ */
+static int is_cmd_local(const char* s,const char* cmd){ return strcmp(s,cmd)==0; }
+static void trim_spaces(char* s){
+    int i=0,j=(int)strlen(s)-1;
+    while(s[i] && (s[i]==' '||s[i]=='\t')) i++;
+    while(j>=i && (s[j]==' '||s[j]=='\t')) j--;
+    if(i>0) memmove(s,s+i,(size_t)(j-i+1));
+    s[j-i+1]='\0';
+}
+/* ӲժĿأ --f32ҵ 1λò */
+static int take_flag_local(char* s,const char* flag){
+    size_t n=strlen(flag); char* p=s;
+    if(!s) return 0;
+    while((p=strstr(p,flag))!=NULL){
+        if((p==s || p[-1]==' ' || p[-1]=='\t') && (p[n]=='\0' || p[n]==' ' || p[n]=='\t')){
+            memset(p,' ',n); return 1;
+        }
+        p+=n;
+    }
+    return 0;
+}
+/* Ӳժ "<opt> ֵ" ֵƵ valҵ 1δַ 0ȱֵ -1 */
+static int take_opt_local(char* s,const char* opt,char* val,size_t vlen){
+    size_t n=strlen(opt), k; char *p=s, *q;
+    if(!s) return 0;
+    while((p=strstr(p,opt))!=NULL){
+        if((p==s || p[-1]==' ' || p[-1]=='\t') && (p[n]=='\0' || p[n]==' ' || p[n]=='\t')){
+            for(q=p+n; *q==' ' || *q=='\t'; ++q) ;
+            k=strcspn(q," \t\r\n");
+            if(k==0) return -1;
+            if(k>vlen-1) k=vlen-1;
+            memcpy(val,q,k); val[k]='\0';
+            memset(p,' ',(size_t)(q-p)+strcspn(q," \t\r\n"));
+            return 1;
+        }
+        p+=n;
+    }
+    return 0;
+}
+/* ֵѡȫ /fast  --f32 */
+static int batch_opts_local(char* arg){
+    int opts=g_fast? CALC_OPT_FAST : 0;
+    if(take_flag_local(arg,"--f32")) opts|=CALC_OPT_F32;
+    return opts;
+}
+
+/* ------------ ֵļ켣/diff /solve /integ ------------
+ * ʼʱ㣬ʱֵʱ
+ *  --trace f.csv ʱÿдһ iter,x,fx,step,errк淽 README */
+typedef struct { long nevals, iters; double t0; FILE* fp; } NumTrace;
+static NumTrace g_ntrace;
+
+static int ntrace_begin_local(const char* file){
+    g_ntrace.nevals=0; g_ntrace.iters=0; g_ntrace.fp=NULL;
+    if(file){
+        if(!(g_ntrace.fp=fopen(file,"w"))) return 0;
+        fprintf(g_ntrace.fp,"iter,x,fx,step,err\n");
+    }
+    g_ntrace.t0=calc_now();
+    return 1;
+}
+static void ntrace_field_local(double v,char sep){
+    if(isfinite(v)) fprintf(g_ntrace.fp,"%.17g",v);
+    fputc(sep,g_ntrace.fp);
+}
+static void ntrace_row_local(long it,double x,double fx,double step,double err){
+    if(!g_ntrace.fp) return;
+    fprintf(g_ntrace.fp,"%ld,",it);
+    ntrace_field_local(x,','); ntrace_field_local(fx,','); ntrace_field_local(step,','); ntrace_field_local(err,'\n');
+}
+/* رչ켣ļɽʾ׺ "[ֵ N   K T ms]"޵ķʾ */
+static void ntrace_end_local(char* buf,size_t blen){
+    double ms=1e3*(calc_now()-g_ntrace.t0);
+    if(g_ntrace.fp){ fclose(g_ntrace.fp); g_ntrace.fp=NULL; }
+    if(g_ntrace.iters>0) snprintf(buf,blen," [ֵ %ld   %ld %.3g ms]",g_ntrace.nevals,g_ntrace.iters,ms);
+    else snprintf(buf,blen," [ֵ %ld  %.3g ms]",g_ntrace.nevals,ms);
+}
+
+/* ֵ */
+static double diff_center(const char* expr,const char* v,double x,double h,char* er,size_t em){
+    double f1,f2;
+    g_ntrace.nevals+=2;
+    if(!eval_with_var(expr,v,x+h, &f1,er,em)) return NAN;
+    if(!eval_with_var(expr,v,x-h, &f2,er,em)) return NAN;
+    return (f1-f2)/(2*h);
+}
+/* ÿεһУx Ϊε㣬fx=f(x)step Ϊţٲ -f/f'err=|f(x)| */
+static int solve_newton(const char* expr,const char* v,double x0,int maxit,double tol,double* root,char* er,size_t em){
+    int k;
+    double x=x0;
+    for(k=0;k<maxit;++k){
+        double fx, dfx;
+        g_ntrace.nevals++; g_ntrace.iters=k+1;
+        if(!eval_with_var(expr,v,x,&fx,er,em)) return 0;
+        dfx = diff_center(expr,v,x,1e-6,er,em);
+        ntrace_row_local(k+1,x,fx,-fx/dfx,fabs(fx));
+        if(!isfinite(dfx) || dfx==0.0){ snprintf(er,em,"Ϊ0/ at x=%.15g",x); return 0; }
+        x = x - fx/dfx;
+        if(fabs(fx) < tol){ *root=x; return 1; }
+    }
+    snprintf(er,em,"δ(maxit=%d)",maxit);
+    return 0;
+}
+/*  Simpsonn Ϊ 4 ıʱͬһ n/2 εĽ Richardson  |S_n-S_{n/2}|/15
+ *  *errest Ϊ NaNÿڵһУxf(x)step=h */
+static int integ_simpson(const char* expr,const char* v,double a,double b,int n,double* out,double* errest,char* er,size_t em){
+    int i;
+    double h, s=0.0, s2=0.0, x, fx;
+    if(n<=0) n=200;
+    if(n%2) n++; /* Simpson Ҫż */
+    h=(b-a)/n;
+    for(i=0;i<=n;i++){
+        x=(i==n)? b : a+i*h;
+        g_ntrace.nevals++;
+        if(!eval_with_var(expr,v,x,&fx,er,em)) return 0;
+        ntrace_row_local(i,x,fx,h,NAN);
+        if(i==0 || i==n){ s+=fx; s2+=fx; }
+        else{
+            s += (i%2 ? 4.0*fx : 2.0*fx);
+            if(i%2==0) s2 += (i%4 ? 4.0*fx : 2.0*fx);
+        }
+    }
+    *out = s*h/3.0;
+    if(errest) *errest = (n%4==0)? fabs(*out-s2*2.0*h/3.0)/15.0 : NAN;
+    return 1;
+}
+
+/* ------------ 뼶 ------------ */
+/* Neumaier ͣ޹أܴСӰ */
+typedef struct { double s, c; } CalcKahan;
+static void kahan_add(CalcKahan* k,double x){
+    double t=k->s+x;
+    if(fabs(k->s)>=fabs(x)) k->c+=(k->s-t)+x;
+    else k->c+=(x-t)+k->s;
+    k->s=t;
+}
+static double kahan_value(const CalcKahan* k){ return k->s+k->c; }
+
+/* ------------ Ӧ GaussCKronrod/integ auto ʱʹã ------------
+ * G7/K15 QUADPACK ʽƣڰ
+ * ÿȡ INTEG_BATCH ֣빲 2*INTEG_BATCH*15 һֵ
+ * ȡĴֻɸ֡滻ӳ䡣
+ * ǵ̵߳ģϸһ߳Уûй̻߳ȡ */
+#define INTEG_BATCH     4
+#define INTEG_MAX_INTV  4000
+#define INTEG_RELTOL    1e-12
+#define INTEG_ABSTOL    1e-14
+
+static const double g_gk_x[8] = {
+    0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+    0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+    0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+    0.207784955007898467600689403773245, 0.0
+};
+static const double g_gk_wk[8] = {
+    0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+    0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+    0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+    0.204432940075298892414161999234649, 0.209482141084727828012999174891714
+};
+static const double g_gk_wg[4] = {   /* Ӧ g_gk_x[1],[3],[5],[7] */
+    0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+    0.381830050505118944950369775488975, 0.417959183673469387755102040816327
+};
+
+typedef struct { double a, b, val, err; } IntegIntv;
+typedef struct { int mode; double a, b; } IntegMap;   /* mode: 0  1 [a,inf) 2 (-inf,b] 3 (-inf,inf) */
+
+static double integ_map_x(const IntegMap* m,double t,double* w){
+    double d;
+    switch(m->mode){
+        case 1: d=1.0-t; *w=1.0/(d*d); return m->a+t/d;
+        case 2: d=1.0-t; *w=1.0/(d*d); return m->b-t/d;
+        case 3: d=1.0-t*t; *w=(1.0+t*t)/(d*d); return t/d;
+        default: *w=1.0; return t;
+    }
+}
+/*  [a,b]  15  Kronrod 㣨t 򣩣˳ġx[0..6] */
+static void gk_points(double a,double b,double* t){
+    double c=0.5*(a+b), h=0.5*(b-a); int j;
+    t[0]=c;
+    for(j=0;j<7;++j){ t[1+2*j]=c-h*g_gk_x[j]; t[2+2*j]=c+h*g_gk_x[j]; }
+}
+/*  15 Ȩֵ f QUADPACK qk15 ţ */
+static void gk_apply(IntegIntv* iv,const double* f){
+    double h=0.5*(iv->b-iv->a), rk, rg=0.0, rabs, rasc, mean, err;
+    int j;
+    rk=f[0]*g_gk_wk[7]; rabs=fabs(rk);
+    rg=f[0]*g_gk_wg[3];
+    for(j=0;j<7;++j){
+        double s=f[1+2*j]+f[2+2*j];
+        rk+=g_gk_wk[j]*s; rabs+=g_gk_wk[j]*(fabs(f[1+2*j])+fabs(f[2+2*j]));
+        if(j&1) rg+=g_gk_wg[j/2]*s;
+    }
+    mean=rk*0.5;
+    rasc=g_gk_wk[7]*fabs(f[0]-mean);
+    for(j=0;j<7;++j) rasc+=g_gk_wk[j]*(fabs(f[1+2*j]-mean)+fabs(f[2+2*j]-mean));
+    err=fabs((rk-rg)*h); rasc*=fabs(h); rabs*=fabs(h);
+    if(rasc!=0.0 && err!=0.0){
+        double r=pow(200.0*err/rasc,1.5);
+        err=rasc*(r<1.0? r:1.0);
+    }
+    if(rabs>1e-290 && err<50.0*DBL_EPSILON*rabs) err=50.0*DBL_EPSILON*rabs;
+    iv->val=rk*h; iv->err=err;
+}
+static void integ_heap_push(IntegIntv* hp,int* nh,const IntegIntv* v){
+    int i=(*nh)++;
+    while(i>0 && hp[(i-1)/2].err<v->err){ hp[i]=hp[(i-1)/2]; i=(i-1)/2; }
+    hp[i]=*v;
+}
+static void integ_heap_pop(IntegIntv* hp,int* nh,IntegIntv* top){
+    IntegIntv last; int i=0, c;
+    *top=hp[0]; last=hp[--(*nh)];
+    for(;;){
+        c=2*i+1; if(c>=*nh) break;
+        if(c+1<*nh && hp[c+1].err>hp[c].err) c++;
+        if(hp[c].err<=last.err) break;
+        hp[i]=hp[c]; i=c;
+    }
+    hp[i]=last;
+}
+/*  cnt ֵt  ts 15 һ飩 */
+static int integ_eval_intervals(CalcProgram* prog,const IntegMap* m,IntegIntv* iv,int cnt,double* ts,double* xs,double* ws,double* fs,long* nev,char* er,size_t em){
+    const double* in[1]; int i, n=cnt*15;
+    for(i=0;i<cnt;++i) gk_points(iv[i].a,iv[i].b,ts+15*i);
+    for(i=0;i<n;++i) xs[i]=integ_map_x(m,ts[i],&ws[i]);
+    in[0]=xs;
+    calc_eval_batch(prog,in,n,fs);
+    *nev+=n;
+    for(i=0;i<n;++i){
+        if(!isfinite(fs[i])){ snprintf(er,em," x=%.10g ֵʧ",xs[i]); return 0; }
+        fs[i]*=ws[i];
+    }
+    for(i=0;i<cnt;++i) gk_apply(&iv[i],fs+15*i);
+    return 1;
+}
+/* 켣ÿһУx Ϊһ׸е㣨ԭfx Ϊǰֹƣ
+ * step ΪȣʱΪ任 t ȣerr Ϊ */
+static int integ_adaptive(const char* expr,const char* v,double a,double b,double* out,double* errest,long* nevals,char* er,size_t em){
+    CalcProgram prog; IntegMap m; IntegIntv *hp, work[2*INTEG_BATCH], top;
+    double ts[2*INTEG_BATCH*15], xs[2*INTEG_BATCH*15], ws[2*INTEG_BATCH*15], fs[2*INTEG_BATCH*15];
+    double ta, tb, sign=1.0, wmid, wlen, wdummy; int nh=0, k, cnt; CalcKahan tv, te; ArenaMark mk;
+    *nevals=0;
+    if(a==b){ *out=0.0; *errest=0.0; return 1; }
+    if(a>b){ double t=a; a=b; b=t; sign=-1.0; }
+    m.a=a; m.b=b;
+    if(isfinite(a) && isfinite(b)){ m.mode=0; ta=a; tb=b; }
+    else if(isfinite(a)){ m.mode=1; ta=0.0; tb=1.0; }
+    else if(isfinite(b)){ m.mode=2; ta=0.0; tb=1.0; }
+    else { m.mode=3; ta=-1.0; tb=1.0; }
+    if(!calc_compile(expr,&v,1,&prog,er,em)) return 0;
+    mk=calc_arena_mark();
+    hp=(IntegIntv*)calc_arena_alloc(sizeof(IntegIntv)*(INTEG_MAX_INTV+2*INTEG_BATCH));
+    if(!hp){ calc_program_free(&prog); snprintf(er,em,"ڴ治"); return 0; }
+    work[0].a=ta; work[0].b=tb;
+    if(!integ_eval_intervals(&prog,&m,work,1,ts,xs,ws,fs,nevals,er,em)){ calc_arena_release(mk); calc_program_free(&prog); return 0; }
+    integ_heap_push(hp,&nh,&work[0]);
+    wmid=0.5*(ta+tb); wlen=tb-ta;
+    for(;;){
+        tv.s=tv.c=te.s=te.c=0.0;
+        for(k=0;k<nh;++k){ kahan_add(&tv,hp[k].val); kahan_add(&te,hp[k].err); }
+        g_ntrace.iters++;
+        ntrace_row_local(g_ntrace.iters,integ_map_x(&m,wmid,&wdummy),sign*kahan_value(&tv),wlen,kahan_value(&te));
+        if(kahan_value(&te)<=INTEG_RELTOL*fabs(kahan_value(&tv)) || kahan_value(&te)<=INTEG_ABSTOL) break;
+        if(nh+INTEG_BATCH>INTEG_MAX_INTV) break;
+        for(cnt=0;cnt<INTEG_BATCH && nh>0;){
+            double mid;
+            integ_heap_pop(hp,&nh,&top);
+            mid=0.5*(top.a+top.b);
+            if(cnt==0){ wmid=mid; wlen=top.b-top.a; }
+            if(!(mid>top.a && mid<top.b)){ integ_heap_push(hp,&nh,&top); break; }   /* Ѳٷ */
+            work[2*cnt].a=top.a; work[2*cnt].b=mid;
+            work[2*cnt+1].a=mid; work[2*cnt+1].b=top.b;
+            cnt++;
+            if(nh>0 && hp[0].err<1e-3*top.err) break;   /* Сöʱͬϸ */
+        }
+        if(cnt==0) break;
+        if(!integ_eval_intervals(&prog,&m,work,2*cnt,ts,xs,ws,fs,nevals,er,em)){ calc_arena_release(mk); calc_program_free(&prog); return 0; }
+        for(k=0;k<2*cnt;++k) integ_heap_push(hp,&nh,&work[k]);
+    }
+    *out=sign*kahan_value(&tv); *errest=kahan_value(&te);
+    g_ntrace.nevals+=*nevals;
+    calc_arena_release(mk); calc_program_free(&prog);
+    return 1;
+}
+
+#define SUM_ACCEL_TERMS 60     /* Levin / Wynn ʹõ */
+#define SUM_FIRST_TERMS 16     /* һֵ֮ÿ */
+#define SUM_SETTLE_TOL  1e-12  /* Ƶ |S| Ĵ˱ʱ */
+#define SUM_RICH_LEVELS 12     /* Richardsonֺ S_nn=42^jj<12 */
+#define SUM_RICH_TERMS  (4<<(SUM_RICH_LEVELS-1))
+
+/* /sum/prod  [a,b]ƣȡ a, a+1, ...a+i  2^53 Ǿȷģ
+ * ޾ֵ 2^53 double ֮ 1 maxterms ʱ */
+#define SUM_MAX_ABS        9007199254740992.0   /* 2^53 */
+#define SUM_MAX_TERMS      100000000L           /* ֵ·double */
+#define SUM_MAX_TERMS_SLOW 1000000L             /* ֵ·/prec dd/exact */
+typedef struct { double a; long n, i; } SumRange;
+static int sum_range_init(SumRange* r,double a,double b,long maxterms,char* er,size_t em){
+    if(!(fabs(a)<=SUM_MAX_ABS && fabs(b)<=SUM_MAX_ABS)){ snprintf(er,em,"޵ľֵ費 2^53"); return 0; }
+    if(b-a+1.0>(double)maxterms){ snprintf(er,em," %.0f  %ld",b-a+1.0,maxterms); return 0; }
+    r->a=a; r->n=(b<a)? 0 : (long)(b-a)+1; r->i=0;
+    return 1;
+}
+/* ȡһ max 㣬ظ0 ʾȡ */
+static int sum_range_next(SumRange* r,double* ks,int max){
+    int c;
+    for(c=0;c<max && r->i<r->n;++c,++r->i) ks[c]=r->a+(double)r->i;
+    return c;
+}
+
+/* ޺ _{v=a}^{b} exprԤÿ CALC_LANES ֵ */
+static int sum_finite(const char* expr,const char* v,double a,double b,double* out,char* er,size_t em){
+    CalcProgram prog; CalcKahan acc={0.0,0.0}; SumRange rg;
+    double ks[CALC_LANES], ys[CALC_LANES];
+    const double* in[1]; int i, cnt;
+    if(!sum_range_init(&rg,a,b,SUM_MAX_TERMS,er,em) || !calc_compile(expr,&v,1,&prog,er,em)) return 0;
+    in[0]=ks;
+    while((cnt=sum_range_next(&rg,ks,CALC_LANES))>0){
+        calc_eval_batch(&prog,in,cnt,ys);
+        for(i=0;i<cnt;++i){
+            if(!isfinite(ys[i])){ calc_program_free(&prog); snprintf(er,em,"%s=%.15g ֵʧ",v,ks[i]); return 0; }
+            kahan_add(&acc,ys[i]);
+        }
+    }
+    calc_program_free(&prog);
+    *out=kahan_value(&acc);
+    return 1;
+}
+
+/* /prec dd µ޺ͣÿ˫˫ֵۼ */
+static int sum_finite_dd(const char* expr,const char* v,double a,double b,CalcDD* out,char* er,size_t em){
+    static CalcTokenList tl, rpn;
+    CalcDD acc=dd_make(0.0,0.0), y; double k; int lossy=0; SumRange rg;
+    if(!sum_range_init(&rg,a,b,SUM_MAX_TERMS_SLOW,er,em)) return 0;
+    if(!tokenize_local(expr,&tl,er,em) || !to_rpn_local(&tl,&rpn,er,em)) return 0;
+    dd_literals_local(&rpn,expr);
+    while(sum_range_next(&rg,&k,1)){
+        if(!eval_rpn_dd_local(&rpn,v,dd_make(k,0.0),&y,er,em)) return 0;
+        if(!isfinite(y.hi)){ snprintf(er,em,"%s=%.15g ֵʧ",v,k); return 0; }
+        lossy|=g_dd_lossy;
+        acc=dd_add(acc,y);
+    }
+    g_dd_lossy=lossy;
+    *out=acc;
+    return 1;
+}
+
+/* /exact µ޺ͣǾȷֵʱۼӣԼ֣
+ * Ǿȷʱ *inexact=1  1ɵ÷ double/˫˫· */
+static int sum_finite_exact(const char* expr,const char* v,double a,double b,CalcRat* out,int* inexact,char* er,size_t em){
+    static CalcTokenList tl, rpn;
+    CalcRat acc, kq; ExVal y; double k; int ok=1; SumRange rg;
+    *inexact=0;
+    if(!sum_range_init(&rg,a,b,SUM_MAX_TERMS_SLOW,er,em)) return 0;
+    if(!tokenize_local(expr,&tl,er,em) || !to_rpn_local(&tl,&rpn,er,em)) return 0;
+    rat_init(&acc); rat_init(&kq);
+    if(!rat_set_u64(&acc,0,0)) ok=ex_too_big_local(er,em);
+    while(ok && sum_range_next(&rg,&k,1)){
+        if(!rat_from_double(&kq,k)){ ok=ex_too_big_local(er,em); break; }
+        if(!eval_rpn_exact_local(&rpn,expr,v,&kq,&y,er,em)){ ok=0; break; }
+        if(!y.exact){ *inexact=1; break; }
+        if(!rat_add(&acc,&acc,&y.q,0)) ok=ex_too_big_local(er,em);
+        rat_free(&y.q);
+    }
+    if(ok && !*inexact && !rat_reduce(&acc)) ok=ex_too_big_local(er,em);
+    if(ok && !*inexact){ rat_free(out); *out=acc; }
+    else rat_free(&acc);
+    rat_free(&kq);
+    return ok;
+}
+
+/* Levin u 任=1 S_0..S_k  _j=(j+1)t_j  L_k
+ * ϵ桢 k Ѹ󣬷Ӱ S_j-S_k ۼӣֻ L_k-S_k  */
+static double levin_u_local(const double* t,const double* S,int k){
+    double num=0.0, den=0.0, c=1.0; int j;
+    for(j=0;j<=k;++j){
+        double w=pow((1.0+j)/(1.0+k),k-1)/((1.0+j)*t[j]);
+        double term=((j&1)? -c : c)*w;
+        num+=term*(S[j]-S[k]); den+=term;
+        c=c*(k-j)/(j+1.0);   /* C(k,j+1) */
+    }
+    return S[k]+num/den;
+}
+
+/* Wynn ţ S[0..n) żΪ Shanks 任ƣȡڹ֮Сߡ
+ * ˵һѾȷ 0 ʾûпù */
+static int accel_wynn_local(const double* S,int n,double* best,double* besterr){
+    double *buf, *prev, *cur, *tmp; int j, col, found=0; ArenaMark mk=calc_arena_mark();
+    buf=(double*)calc_arena_alloc(sizeof(double)*(size_t)n*2);
+    if(!buf) return 0;
+    prev=buf; cur=buf+n;
+    for(j=0;j<n;++j){ prev[j]=0.0; cur[j]=S[j]; }
+    for(col=1;col<n;++col){
+        int len=n-col, degenerate=0;
+        for(j=0;j<len;++j){
+            double d=cur[j+1]-cur[j];
+            if(d==0.0){ degenerate=1; break; }
+            prev[j]=prev[j+1]+1.0/d;
+        }
+        if(degenerate) break;
+        tmp=prev; prev=cur; cur=tmp;
+        if(col%2==0 && len>=2 && fabs(cur[len-1])<1e250 && fabs(cur[len-2])<1e250){
+            double e=fabs(cur[len-1]-cur[len-2]);
+            if(!found || e<*besterr){ *best=cur[len-1]; *besterr=e; found=1; }
+        }
+    }
+    calc_arena_release(mk);
+    return found;
+}
+/* RichardsonS_j Ϊ h_j ĶʽNeville Ƶ h=0ȡ֮Ľϴߡ
+ * ߽Ƶ׿ǡȣȡ 8eps|| 0S ᱻд */
+static int accel_richardson_local(double* S,const double* h,int n,double* best,double* besterr){
+    double lk, lk1=S[n-1], lk2=0.0; int m, j, found=0;
+    for(m=1;m<n;++m){
+        for(j=0;j<n-m;++j) S[j]=(h[j]*S[j+1]-h[j+m]*S[j])/(h[j]-h[j+m]);
+        lk=S[n-1-m];
+        if(m>=2 && isfinite(lk)){
+            double e1=fabs(lk-lk1), e2=fabs(lk1-lk2), e=(e1>e2)? e1 : e2;
+            if(e<8.0*DBL_EPSILON*fabs(lk)) e=8.0*DBL_EPSILON*fabs(lk);
+            if(!found || e<*besterr){ *best=lk; *besterr=e; found=1; }
+        }
+        lk2=lk1; lk1=lk;
+    }
+    return found;
+}
+
+/*  _{v=a}^{}ֵһ 16 ֮ÿ 8192 ÿ֮Ƚֱ͡
+ * Levin u  Wynn ţֻǰ 60 Լ RichardsonS_n  n=42^j ϶ 1/n0 ƣĹƣ
+ * ȡƣ֮Сߣƽ |S|  SUM_SETTLE_TOL ¼ֹͣ */
+static int sum_infinite(const char* expr,const char* v,double a,double* out,double* errest,int* nterms,const char** method,char* er,size_t em){
+    CalcProgram prog; const double* in[1];
+    double *ks, *t, *S;   /* S[j]ǰ j+1 Ĳֺ */
+    double rs[SUM_RICH_LEVELS], rh[SUM_RICH_LEVELS], rw[SUM_RICH_LEVELS];
+    double best=0.0, besterr=HUGE_VAL, lk, lk1, lk2;
+    CalcKahan acc={0.0,0.0};
+    int n=0, cap=SUM_FIRST_TERMS, nacc=0, nlev=0, j, zero=0, done=0;
+    ArenaMark mk;
+    if(!calc_compile(expr,&v,1,&prog,er,em)) return 0;
+    mk=calc_arena_mark();
+    ks=(double*)calc_arena_alloc(sizeof(double)*SUM_RICH_TERMS);
+    t=(double*)calc_arena_alloc(sizeof(double)*SUM_RICH_TERMS);
+    S=(double*)calc_arena_alloc(sizeof(double)*SUM_RICH_TERMS);
+    if(!ks||!t||!S){ calc_arena_release(mk); calc_program_free(&prog); snprintf(er,em,"ڴ治"); return 0; }
+    *method="ֱ"; *nterms=0;
+    while(!done){
+        for(j=n;j<cap;++j) ks[j]=a+j;
+        in[0]=ks+n;
+        calc_eval_batch(&prog,in,cap-n,t+n);
+        for(j=n;j<cap && isfinite(t[j]);++j){
+            kahan_add(&acc,t[j]); S[j]=kahan_value(&acc);
+            if(j+1==(4<<nlev) && nlev<SUM_RICH_LEVELS){ rs[nlev]=S[j]; rh[nlev]=1.0/(j+1); nlev++; }
+        }
+        if(j<cap){
+            if(j<SUM_ACCEL_TERMS){ snprintf(er,em,"%s=%.15g ֵʧ",v,ks[j]); calc_arena_release(mk); calc_program_free(&prog); return 0; }
+            cap=j; done=1;   /* ֮޷ֵֻеĲֺ */
+        }
+        n=cap;
+        /* ֱӲֺ */
+        if(fabs(t[n-1])+fabs(t[n-2])<besterr){ best=S[n-1]; besterr=fabs(t[n-1])+fabs(t[n-2]); *method="ֱ"; *nterms=n; }
+        /* Levin u  Wynn ţʱ㣻Levin ߽ʱɢȡڽ֮С */
+        if(nacc<SUM_ACCEL_TERMS){
+            nacc=(n<SUM_ACCEL_TERMS)? n : SUM_ACCEL_TERMS;
+            for(j=0;j<nacc;++j) if(t[j]==0.0) zero=1;
+            if(!zero){
+                lk1=lk2=0.0;
+                for(j=1;j<nacc;++j){
+                    lk=levin_u_local(t,S,j);
+                    if(j>=3 && isfinite(lk)){
+                        double e1=fabs(lk-lk1), e2=fabs(lk1-lk2), e=(e1>e2)? e1 : e2;
+                        if(e<besterr){ best=lk; besterr=e; *method="Levin u"; *nterms=j+1; }
+                    }
+                    lk2=lk1; lk1=lk;
+                }
+            }
+            if(accel_wynn_local(S,nacc,&lk,&lk1) && lk1<besterr){ best=lk; besterr=lk1; *method="Wynn epsilon"; *nterms=nacc; }
+        }
+        /* RichardsonS_n Ϊ 1/n Ķʽƻд룬ø */
+        if(nlev>=3){
+            memcpy(rw,rs,sizeof(double)*(size_t)nlev);
+            if(accel_richardson_local(rw,rh,nlev,&lk,&lk1) && lk1<besterr){ best=lk; besterr=lk1; *method="Richardson"; *nterms=4<<(nlev-1); }
+        }
+        if(besterr<=SUM_SETTLE_TOL*fabs(best) || cap>=SUM_RICH_TERMS) done=1;
+        else cap*=2;
+    }
+    calc_arena_release(mk); calc_program_free(&prog);
+    /* ڽǡʱΪ 0ٰ */
+    if(besterr<8.0*DBL_EPSILON*fabs(best)) besterr=8.0*DBL_EPSILON*fabs(best);
+    *out=best; *errest=besterr;
+    return 1;
+}
+
+/* ˻ _{v=a}^{b} exprڶռۼ ln|f| ¼ţ;/硣
+ * ÿڿڲٰͣѿͲܺͣ 0 ʱ sign=0 */
+static int prod_finite(const char* expr,const char* v,double a,double b,double* logabs,int* sign,char* er,size_t em){
+    CalcProgram prog; CalcKahan acc={0.0,0.0}; SumRange rg;
+    double ks[CALC_LANES], ys[CALC_LANES];
+    const double* in[1]; int i, cnt, neg=0;
+    if(!sum_range_init(&rg,a,b,SUM_MAX_TERMS,er,em) || !calc_compile(expr,&v,1,&prog,er,em)) return 0;
+    in[0]=ks;
+    *sign=1;
+    while((cnt=sum_range_next(&rg,ks,CALC_LANES))>0){
+        CalcKahan blk={0.0,0.0};
+        calc_eval_batch(&prog,in,cnt,ys);
+        for(i=0;i<cnt;++i){
+            if(!isfinite(ys[i])){ calc_program_free(&prog); snprintf(er,em,"%s=%.15g ֵʧ",v,ks[i]); return 0; }
+            if(ys[i]==0.0){ *sign=0; continue; }
+            if(ys[i]<0.0) neg^=1;
+            kahan_add(&blk,log(fabs(ys[i])));
+        }
+        kahan_add(&acc,kahan_value(&blk));
+    }
+    calc_program_free(&prog);
+    if(*sign) *sign=neg? -1 : 1;
+    *logabs=kahan_value(&acc);
+    return 1;
+}
+
+/* ֵޣ pointh_jh_j=h0/2^j 1/h_jpoint Ϊ infȡ
+ * ÿ 12 㴰ڷֱ Richardson  Wynn  ƣֱȽϣȡС */
+#define LIMIT_LEVELS 40
+#define LIMIT_WINDOW 12
+static int limit_side(CalcProgram* prog,double point,int inf,int dir,double* val,double* errest,char* er,size_t em){
+    double xs[LIMIT_LEVELS], fs[LIMIT_LEVELS], hs[LIMIT_LEVELS], win[LIMIT_WINDOW];
+    double h=0.125, est, e;
+    const double* in[1]; int j, w0, first=0, found=0;
+    if(!inf && fabs(point)>1.0) h*=fabs(point);
+    for(j=0;j<LIMIT_LEVELS;++j){
+        hs[j]=h;
+        xs[j]= inf? inf/h : point+dir*h;
+        h*=0.5;
+    }
+    in[0]=xs;
+    calc_eval_batch(prog,in,LIMIT_LEVELS,fs);
+    /* ֻ޵һֵ */
+    for(j=0;j<LIMIT_LEVELS;++j) if(!isfinite(fs[j])) first=j+1;
+    if(LIMIT_LEVELS-first<4){ snprintf(er,em,"޵㸽ֵʧ"); return 0; }
+    /* ֲСҺֵƻġޡ */
+    if(fabs(fs[LIMIT_LEVELS-1]-fs[LIMIT_LEVELS-2]) > fabs(fs[first+1]-fs[first]) &&
+       fabs(fs[LIMIT_LEVELS-1]) > fabs(fs[first])){
+        snprintf(er,em,"ֵ޽Ϊ򲻴"); return 0;
+    }
+    for(j=first+1;j<LIMIT_LEVELS;++j){
+        e=fabs(fs[j]-fs[j-1]);
+        if(!found || e<*errest){ *val=fs[j]; *errest=e; found=1; }
+    }
+    for(w0=first; w0+LIMIT_WINDOW<=LIMIT_LEVELS; w0+=4){
+        memcpy(win,fs+w0,sizeof(win));
+        if(accel_richardson_local(win,hs+w0,LIMIT_WINDOW,&est,&e) && e<*errest){ *val=est; *errest=e; }
+        if(accel_wynn_local(fs+w0,LIMIT_WINDOW,&est,&e) && e<*errest){ *val=est; *errest=e; }
+    }
+    if(fabs(*val)<=*errest) *val=0.0;  /*  0  */
+    return 1;
+}
+
+/* /prec dd µ /integ˫˫ tanh-sinh˫ָ
+ * x = c  hw(1-tanh u)u=(/2)sinh t˵㸽ԱԾȣ
+ * t[-5,5]˵㴦 x-a Լ 1e-101x^-1/2 βҲѵ 1e-35ÿ㲽ֻ㣬֮ <1e-30|S| ʱֹͣ
+ * ˵죨 ln x1/sqrt(x)Ҳڶ˵ֵʧܵĽڵȨؿɺԣֱ */
+#define TS_TMAX 5.0
+#define TS_LEVELS 10
+static int integ_tanhsinh_dd(const char* expr,const char* v,double a,double b,CalcDD* out,double* errest,long* nevals,char* er,size_t em){
+    static CalcTokenList tl, rpn;
+    CalcDD A=dd_make(a,0.0), B=dd_make(b,0.0), hw, S=dd_make(0.0,0.0), prev;
+    double h=1.0, diff=HUGE_VAL; int lev, j, nskip=0, lossy=0; long ne=0;
+    if(!tokenize_local(expr,&tl,er,em) || !to_rpn_local(&tl,&rpn,er,em)) return 0;
+    dd_literals_local(&rpn,expr);
+    hw=dd_ldexp(dd_sub(B,A),-1);
+    for(lev=0;lev<=TS_LEVELS;++lev){
+        CalcDD part=dd_make(0.0,0.0);
+        int nt=(int)(TS_TMAX/h), step=(lev==0)? 1 : 2;
+        for(j=(lev==0)? 0 : 1; j<=nt; j+=step){
+            CalcDD t=dd_make(j*h,0.0), et, ch, sh, u, E, q, w, y, x; int side;
+            et=dd_exp(t);
+            ch=dd_ldexp(dd_add(et,dd_div(dd_make(1.0,0.0),et)),-1);
+            sh=dd_ldexp(dd_sub(et,dd_div(dd_make(1.0,0.0),et)),-1);
+            u=dd_mul(DD_PI2,sh);
+            E=dd_exp(dd_ldexp(u,1));
+            q=dd_div(dd_make(2.0,0.0),dd_add_d(E,1.0));                  /* 1-tanh u */
+            w=dd_div(dd_mul(dd_mul(DD_PI2,ch),dd_mul_d(E,4.0)),dd_sqr(dd_add_d(E,1.0)));   /* (/2)cosh tsech^2 u */
+            w=dd_mul(w,hw);
+            for(side=0;side<((j==0)? 1 : 2);++side){
+                x=(side==0)? dd_sub(B,dd_mul(hw,q)) : dd_add(A,dd_mul(hw,q));
+                if(j==0) x=dd_ldexp(dd_add(A,B),-1);
+                if((x.hi==a && x.lo==0.0) || (x.hi==b && x.lo==0.0)){ nskip++; continue; }
+                ne++;
+                if(!eval_rpn_dd_local(&rpn,v,x,&y,er,em) || !isfinite(y.hi)){ nskip++; continue; }
+                lossy|=g_dd_lossy;
+                part=dd_add(part,dd_mul(w,y));
+            }
+        }
+        prev=S;
+        S=(lev==0)? dd_mul_d(part,h) : dd_add(dd_ldexp(prev,-1),dd_mul_d(part,h));
+        if(lev>0) diff=fabs(dd_sub(S,prev).hi);
+        g_ntrace.iters=lev+1;
+        ntrace_row_local(lev+1,NAN,S.hi,h,lev>0? diff : NAN);   /* ÿһУfx Ϊƣstep Ϊ herr Ϊ */
+        if(lev>0 && (diff<=1e-30*fabs(S.hi) || (S.hi==0.0 && diff==0.0))) break;
+        h*=0.5;
+    }
+    g_ntrace.nevals+=ne;
+    if(ne>0 && nskip*2>ne){ snprintf(er,em,"ڵֵʧܣ޶"); return 0; }
+    g_dd_lossy=lossy;
+    *out=S; *errest=diff; *nevals=ne;
+    return 1;
+}
+
+/* ------------ ά֣/integn ------------
+ * άĬ n<=4 GenzCMalik 7/5 ǶȫӦÿȡ
+ * Ľײķ֣Ĳһֵ
+ * ά׼ؿ壺Sobol λ Halton ƽƣ
+ *  QMC_REPS ɢȸ׼ */
+#define QMC_REPS      16
+#define QMC_BITS      32
+#define QMC_DEFAULT_N (1L<<20)
+#define GM_DEFAULT_MAXEVAL 2000000L
+#define GM_MAX_DIM    MAX_BIND
+#define INTEGN_GM_AUTO_DIM 4
+
+/* Sobol JoeCKuo 1 άΪ van der Corput */
+typedef struct { int s, a; int m[5]; } SobolPoly;
+static const SobolPoly g_sobol_poly[MAX_BIND-1] = {
+    {1,0,{1}}, {2,1,{1,3}}, {3,1,{1,3,1}}, {3,2,{1,1,1}},
+    {4,1,{1,1,3,3}}, {4,4,{1,3,5,13}}, {5,2,{1,1,5,5,17}}
+};
+typedef struct { int dim; unsigned long v[MAX_BIND][QMC_BITS]; unsigned long x[MAX_BIND]; unsigned long idx; } SobolGen;
+
+static void sobol_init(SobolGen* g,int dim){
+    int d,i,k;
+    g->dim=dim; g->idx=0;
+    for(i=0;i<QMC_BITS;++i) g->v[0][i]=1UL<<(QMC_BITS-1-i);
+    for(d=1;d<dim;++d){
+        const SobolPoly* p=&g_sobol_poly[d-1];
+        for(i=0;i<p->s && i<QMC_BITS;++i) g->v[d][i]=((unsigned long)p->m[i])<<(QMC_BITS-1-i);
+        for(i=p->s;i<QMC_BITS;++i){
+            unsigned long w=g->v[d][i-p->s];
+            w^=w>>p->s;
+            for(k=1;k<p->s;++k) if((p->a>>(p->s-1-k))&1) w^=g->v[d][i-k];
+            g->v[d][i]=w & 0xFFFFFFFFUL;
+        }
+    }
+    for(d=0;d<dim;++d) g->x[d]=0;
+}
+/*  Gray ˳ȡһ㣨 0 Ϊԭ㣩 */
+static void sobol_next(SobolGen* g,unsigned long* out){
+    int d, c=0; unsigned long n=g->idx;
+    if(n>0){
+        unsigned long m=n-1;
+        while(m&1UL){ m>>=1; c++; }
+        for(d=0;d<g->dim;++d) g->x[d]^=g->v[d][c];
+    }
+    for(d=0;d<g->dim;++d) out[d]=g->x[d];
+    g->idx++;
+}
+static double halton_radical(unsigned long i,int base){
+    double f=1.0, r=0.0;
+    while(i>0){ f/=base; r+=f*(double)(i%(unsigned long)base); i/=(unsigned long)base; }
+    return r;
+}
+
+typedef struct { double val, err; long nevals; int method_qmc; } IntegnResult;
+
+/* ׼ؿ壺n Ϊܵhalton ѡ */
+static int integn_qmc(CalcProgram* prog,int dim,const double* lo,const double* hi,long n,int halton,calc_u64 seed,
+                      IntegnResult* res,char* er,size_t em){
+    static const int primes[MAX_BIND]={2,3,5,7,11,13,17,19};
+    double *buf, ys[CALC_LANES], vol=1.0, means[QMC_REPS], mean=0.0, var=0.0;
+    const double* in[MAX_BIND]; SobolGen* sg; CalcRng r; long m, i; int rep, d, cnt, k;
+    unsigned long pt[MAX_BIND], shift[MAX_BIND];
+    double cp[MAX_BIND];
+    m=n/QMC_REPS; if(m<CALC_LANES) m=CALC_LANES;
+    if(!halton){ long p=1; while(p*2<=m) p*=2; m=p; }   /* Sobol ȡ 2 ʱ */
+    buf=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*CALC_LANES*(size_t)dim);
+    sg=(SobolGen*)calc_malloc(MEM_ARRAY,sizeof(SobolGen));
+    if(!buf||!sg){ calc_free(buf); calc_free(sg); snprintf(er,em,"ڴ治"); return 0; }
+    for(d=0;d<dim;++d){ in[d]=buf+(size_t)d*CALC_LANES; vol*=hi[d]-lo[d]; }
+    rng_seed(&r,seed);
+    for(rep=0;rep<QMC_REPS;++rep){
+        CalcKahan acc={0.0,0.0};
+        for(d=0;d<dim;++d){ shift[d]=(unsigned long)(rng_next(&r)>>32); cp[d]=rng_u01(&r); }
+        if(!halton) sobol_init(sg,dim);
+        for(i=0;i<m;i+=cnt){
+            cnt=(m-i<CALC_LANES)? (int)(m-i) : CALC_LANES;
+            for(k=0;k<cnt;++k){
+                if(!halton){
+                    sobol_next(sg,pt);
+                    for(d=0;d<dim;++d)
+                        buf[(size_t)d*CALC_LANES+k]=lo[d]+(hi[d]-lo[d])*(((double)(pt[d]^shift[d])+0.5)/4294967296.0);
+                }else{
+                    for(d=0;d<dim;++d){
+                        double u=halton_radical((unsigned long)(i+k+1),primes[d])+cp[d];
+                        if(u>=1.0) u-=1.0;
+                        buf[(size_t)d*CALC_LANES+k]=lo[d]+(hi[d]-lo[d])*u;
+                    }
+                }
+            }
+            calc_eval_batch(prog,in,cnt,ys);
+            for(k=0;k<cnt;++k){
+                if(!isfinite(ys[k])){
+                    calc_free(buf); calc_free(sg);
+                    snprintf(er,em," (%.6g,...) ֵʧ",in[0][k]);
+                    return 0;
+                }
+                kahan_add(&acc,ys[k]);
+            }
+        }
+        means[rep]=vol*kahan_value(&acc)/(double)m;
+    }
+    for(rep=0;rep<QMC_REPS;++rep) mean+=means[rep];
+    mean/=QMC_REPS;
+    for(rep=0;rep<QMC_REPS;++rep) var+=(means[rep]-mean)*(means[rep]-mean);
+    var/=(QMC_REPS-1);
+    res->val=mean; res->err=sqrt(var/QMC_REPS); res->nevals=m*QMC_REPS; res->method_qmc=1;
+    calc_free(buf); calc_free(sg);
+    return 1;
+}
+
+/* GenzCMalik  c h */
+typedef struct { double c[GM_MAX_DIM], h[GM_MAX_DIM]; double val, err; int split; } GmRegion;
+
+static int gm_npts(int n){ return 1+4*n+2*n*(n-1)+(1<<n); }
+/* Ĳ㣬д pts[d*stride+j]j  off ʼ */
+static void gm_points(const GmRegion* r,int n,double* pts,int stride,int off){
+    static const double l2=0.35856858280031809199, l4=0.94868329805051379960, l5=0.68824720161168529772;
+    int i,j,d,k=off,s;
+    for(d=0;d<n;++d) pts[d*stride+k]=r->c[d];
+    k++;
+    for(i=0;i<n;++i){
+        double ls[4]; ls[0]=l2; ls[1]=-l2; ls[2]=l4; ls[3]=-l4;
+        for(s=0;s<4;++s,++k){
+            for(d=0;d<n;++d) pts[d*stride+k]=r->c[d];
+            pts[i*stride+k]+=ls[s]*r->h[i];
+        }
+    }
+    for(i=0;i<n;++i) for(j=i+1;j<n;++j) for(s=0;s<4;++s,++k){
+        for(d=0;d<n;++d) pts[d*stride+k]=r->c[d];
+        pts[i*stride+k]+=((s&1)? -l4:l4)*r->h[i];
+        pts[j*stride+k]+=((s&2)? -l4:l4)*r->h[j];
+    }
+    for(s=0;s<(1<<n);++s,++k)
+        for(d=0;d<n;++d) pts[d*stride+k]=r->c[d]+(((s>>d)&1)? -l5:l5)*r->h[d];
+}
+/* ɲֵ f gm_points ͬ򣩼 7 ֵѷ */
+static void gm_apply(GmRegion* r,int n,const double* f){
+    static const double ratio=(9.0/70.0)/(9.0/10.0);
+    double w1=(12824.0-9120.0*n+400.0*n*n)/19683.0, w2=980.0/6561.0, w3=(1820.0-400.0*n)/19683.0;
+    double w4=200.0/19683.0, w5=6859.0/19683.0/(double)(1<<n);
+    double e1=(729.0-950.0*n+50.0*n*n)/729.0, e2=245.0/486.0, e3=(265.0-100.0*n)/1458.0, e4=25.0/729.0;
+    double f0=f[0], s2=0, s3=0, s4=0, s5=0, vol=1.0, dmax=-1.0, r7, r5;
+    int i,k=1,m;
+    for(i=0;i<n;++i){
+        double a2=f[k]+f[k+1], a4=f[k+2]+f[k+3], dd;
+        s2+=a2; s3+=a4;
+        dd=fabs(a2-2*f0-ratio*(a4-2*f0));
+        if(dd>dmax*(1+1e-10)){ dmax=dd; r->split=i; }   /* ʱȡάȣⶶ */
+        k+=4;
+        vol*=2*r->h[i];
+    }
+    m=2*n*(n-1); for(i=0;i<m;++i) s4+=f[k++];
+    m=1<<n;      for(i=0;i<m;++i) s5+=f[k++];
+    r7=vol*(w1*f0+w2*s2+w3*s3+w4*s4+w5*s5);
+    r5=vol*(e1*f0+e2*s2+e3*s3+e4*s4);
+    r->val=r7; r->err=fabs(r7-r5);
+}
+static void gm_heap_push(GmRegion* hp,int* nh,const GmRegion* r){
+    int i=(*nh)++;
+    while(i>0 && hp[(i-1)/2].err<r->err){ hp[i]=hp[(i-1)/2]; i=(i-1)/2; }
+    hp[i]=*r;
+}
+static void gm_heap_pop(GmRegion* hp,int* nh,GmRegion* top){
+    GmRegion last; int i=0, c;
+    *top=hp[0]; last=hp[--(*nh)];
+    for(;;){
+        c=2*i+1; if(c>=*nh) break;
+        if(c+1<*nh && hp[c+1].err>hp[c].err) c++;
+        if(hp[c].err<=last.err) break;
+        hp[i]=hp[c]; i=c;
+    }
+    hp[i]=last;
+}
+
+static int integn_gm(CalcProgram* prog,int n,const double* lo,const double* hi,double reltol,double abstol,long maxeval,
+                     IntegnResult* res,char* er,size_t em){
+    int np=gm_npts(n), nh=0, cap, d, k;
+    double *pts, *ys; const double* in[GM_MAX_DIM]; GmRegion *hp, r, a, b;
+    CalcKahan tv, te; long evals=0;
+    if(n<2 || n>GM_MAX_DIM){ snprintf(er,em,"GenzCMalik Ҫ 2..%d ά",GM_MAX_DIM); return 0; }
+    cap=(int)(maxeval/np)+4;
+    hp=(GmRegion*)calc_malloc(MEM_ARRAY,sizeof(GmRegion)*(size_t)cap);
+    pts=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)(2*np)*(size_t)n);
+    ys=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)(2*np));
+    if(!hp||!pts||!ys){ calc_free(hp); calc_free(pts); calc_free(ys); snprintf(er,em,"ڴ治"); return 0; }
+    for(d=0;d<n;++d) in[d]=pts+(size_t)d*(2*np);
+    for(d=0;d<n;++d){ r.c[d]=0.5*(lo[d]+hi[d]); r.h[d]=0.5*(hi[d]-lo[d]); }
+    gm_points(&r,n,pts,2*np,0);
+    calc_eval_batch(prog,in,np,ys); evals+=np;
+    for(k=0;k<np;++k) if(!isfinite(ys[k])) break;
+    if(k<np){ calc_free(hp); calc_free(pts); calc_free(ys); snprintf(er,em,"ڲֵʧ"); return 0; }
+    gm_apply(&r,n,ys);
+    gm_heap_push(hp,&nh,&r);
+    for(;;){
+        /* ȫ/ֵÿ㣨ͣ */
+        tv.s=tv.c=te.s=te.c=0.0;
+        for(k=0;k<nh;++k){ kahan_add(&tv,hp[k].val); kahan_add(&te,hp[k].err); }
+        if(kahan_value(&te)<=reltol*fabs(kahan_value(&tv)) || kahan_value(&te)<=abstol) break;
+        if(evals+2*np>maxeval || nh+1>=cap) break;
+        gm_heap_pop(hp,&nh,&r);
+        a=r; b=r; d=r.split;
+        a.h[d]*=0.5; b.h[d]*=0.5;
+        a.c[d]-=a.h[d]; b.c[d]+=b.h[d];
+        gm_points(&a,n,pts,2*np,0);
+        gm_points(&b,n,pts,2*np,np);
+        calc_eval_batch(prog,in,2*np,ys); evals+=2*np;
+        for(k=0;k<2*np;++k) if(!isfinite(ys[k])) break;
+        if(k<2*np){ calc_free(hp); calc_free(pts); calc_free(ys); snprintf(er,em,"ڲֵʧ"); return 0; }
+        gm_apply(&a,n,ys); gm_apply(&b,n,ys+np);
+        gm_heap_push(hp,&nh,&a); gm_heap_push(hp,&nh,&b);
+    }
+    res->val=kahan_value(&tv); res->err=kahan_value(&te); res->nevals=evals; res->method_qmc=0;
+    calc_free(hp); calc_free(pts); calc_free(ys);
+    return 1;
+}
+
+/* ------------ أ/track ------------
+ *  (x,p) ƽ F(x,p)=0 αأԤ + Լ Newton У
+ * УӦ p żΪյ㣨foldԲֵ
+ * ٶչϵͳ {F=0, dF/dx=0}  Newton  */
+#define TRACK_MAX_TURN 8
+#define TRACK_MAX_PTS  100000
+#define TRACK_NEWTON_IT 8
+
+typedef struct {
+    int    npts, nturn, reached;
+    double turn_p[TRACK_MAX_TURN], turn_x[TRACK_MAX_TURN];
+    double x_end, p_end;
+    long   nevals;
+} TrackInfo;
+
+/* һֵõ F ƫĲ֣ */
+static int track_eval(CalcProgram* prog,double x,double p,double* F,double* Fx,double* Fp,long* nev){
+    double xs[5], ps[5], ys[5], hx=6e-6*(1.0+fabs(x)), hp=6e-6*(1.0+fabs(p));
+    const double* in[2];
+    xs[0]=x;    ps[0]=p;
+    xs[1]=x+hx; ps[1]=p;  xs[2]=x-hx; ps[2]=p;
+    xs[3]=x;    ps[3]=p+hp; xs[4]=x;  ps[4]=p-hp;
+    in[0]=xs; in[1]=ps;
+    calc_eval_batch(prog,in,5,ys);
+    *nev+=5;
+    if(!isfinite(ys[0])||!isfinite(ys[1])||!isfinite(ys[2])||!isfinite(ys[3])||!isfinite(ys[4])) return 0;
+    *F=ys[0]; *Fx=(ys[1]-ys[2])/(2*hx); *Fp=(ys[3]-ys[4])/(2*hp);
+    return 1;
+}
+
+/* յ㾫 (x,p)  F=0, Fx=0ƫ Fx Ĳ */
+static int track_fold_refine(CalcProgram* prog,double* x,double* p,long* nev){
+    double F, Fx, Fp, a, b, c, d, t1, t2, h, det, dx, dp; int it;
+    for(it=0;it<10;++it){
+        if(!track_eval(prog,*x,*p,&F,&Fx,&Fp,nev)) return 0;
+        h=1e-4*(1.0+fabs(*x));
+        if(!track_eval(prog,*x+h,*p,&t1,&a,&t2,nev) || !track_eval(prog,*x-h,*p,&t1,&b,&t2,nev)) return 0;
+        c=(a-b)/(2*h);                       /* Fxx */
+        h=1e-4*(1.0+fabs(*p));
+        if(!track_eval(prog,*x,*p+h,&t1,&a,&t2,nev) || !track_eval(prog,*x,*p-h,&t1,&b,&t2,nev)) return 0;
+        d=(a-b)/(2*h);                       /* Fxp */
+        det=Fx*d-Fp*c;
+        if(det==0.0 || !isfinite(det)) return 0;
+        dx=(-F*d+Fp*Fx)/det;
+        dp=(-Fx*Fx+F*c)/det;
+        *x+=dx; *p+=dp;
+        if(fabs(dx)+fabs(dp)<1e-10*(1.0+fabs(*x)+fabs(*p))) return 1;
+    }
+    return 0;
+}
+
+static int track_run(CalcProgram* prog,double p0,double p1,int steps,double x0,FILE* out,
+                     double** pp,double** px,TrackInfo* info,char* er,size_t em){
+    double x=x0, p=p0, F, Fx, Fp, tx, tp, nrm, ds, ds0, dsmin, tol=1e-12, dir=(p1>p0)? 1.0 : -1.0;
+    double *ap=NULL, *ax=NULL; int cap=0, it, k, stop=0;
+    memset(info,0,sizeof(*info));
+    if(steps<1) steps=100;
+    /* 㣺̶ p0  x  Newton */
+    for(it=0;it<50;++it){
+        if(!track_eval(prog,x,p,&F,&Fx,&Fp,&info->nevals)){ snprintf(er,em," x=%.6g ֵʧ",x); return 0; }
+        if(fabs(F)<tol*(1.0+fabs(x))) break;
+        if(Fx==0.0){ snprintf(er,em,"㴦 dF/dx=0뻻һ x0"); return 0; }
+        x-=F/Fx;
+    }
+    if(it==50){ snprintf(er,em," Newton δ"); return 0; }
+    ds0=fabs(p1-p0)/steps*sqrt(1.0+(Fx!=0.0? (Fp/Fx)*(Fp/Fx) : 0.0));
+    if(ds0>fabs(p1-p0)/steps*10) ds0=fabs(p1-p0)/steps*10;
+    ds=ds0; dsmin=ds0*1e-8;
+    /* ʼ (-Fp, Fx) p1  */
+    tx=-Fp; tp=Fx; nrm=sqrt(tx*tx+tp*tp);
+    if(nrm==0.0){ snprintf(er,em,"㴦 F ݶΪ 0"); return 0; }
+    tx/=nrm; tp/=nrm;
+    if(tp*dir<0){ tx=-tx; tp=-tp; }
+    if(out) fprintf(out,"p,x,type\n");
+
+    for(;;){
+        double zp, zx, np_, nx, ntx, ntp;
+        int ok=0;
+        /* ¼ǰ */
+        if(info->npts>=cap){
+            int nc=cap? cap*2 : 256; double *t1, *t2;
+            t1=(double*)calc_realloc(MEM_ARRAY,ap,sizeof(double)*(size_t)nc); if(t1) ap=t1;
+            t2=(double*)calc_realloc(MEM_ARRAY,ax,sizeof(double)*(size_t)nc); if(t2) ax=t2;
+            if(!t1||!t2){ calc_free(ap); calc_free(ax); snprintf(er,em,"ڴ治"); return 0; }
+            cap=nc;
+        }
+        ap[info->npts]=p; ax[info->npts]=x; info->npts++;
+        if(out) fprintf(out,"%.15g,%.15g,point\n",p,x);
+        if(stop || (p-p1)*dir>=0 || info->npts>=TRACK_MAX_PTS) break;
+
+        /* Ԥ-Уʧ */
+        while(!ok){
+            zp=p+ds*tp; zx=x+ds*tx;
+            np_=zp; nx=zx;
+            for(it=0;it<TRACK_NEWTON_IT;++it){
+                double g, det, dx, dp;
+                if(!track_eval(prog,nx,np_,&F,&Fx,&Fp,&info->nevals)) break;
+                /* [Fx Fp; tx tp] [dx dp]^T = -[F; tx(nx-zx)+tp(np_-zp)] */
+                g=tx*(nx-zx)+tp*(np_-zp);
+                det=Fx*tp-Fp*tx;
+                if(det==0.0) break;
+                dx=(-F*tp+Fp*g)/det;
+                dp=(-Fx*g+F*tx)/det;
+                nx+=dx; np_+=dp;
+                if(fabs(dx)+fabs(dp)<1e-11*(1.0+fabs(nx)+fabs(np_)) && fabs(F)<1e-9*(1.0+fabs(nx))){ ok=1; break; }
+            }
+            if(!ok){
+                ds*=0.5;
+                if(ds<dsmin){
+                    calc_free(ap); calc_free(ax);
+                    snprintf(er,em," p=%.6g, x=%.6g Сֲ㣩",p,x);
+                    return 0;
+                }
+            }
+        }
+        /* ͬ */
+        ntx=-Fp; ntp=Fx; nrm=sqrt(ntx*ntx+ntp*ntp);
+        if(nrm==0.0){ calc_free(ap); calc_free(ax); snprintf(er,em," p=%.6g ݶΪ 0",np_); return 0; }
+        ntx/=nrm; ntp/=nrm;
+        if(ntx*tx+ntp*tp<0){ ntx=-ntx; ntp=-ntp; }
+        if(tp*ntp<0 && info->nturn<TRACK_MAX_TURN){
+            double lam=tp/(tp-ntp), fx_=x+lam*(nx-x), fp_=p+lam*(np_-p), rx=fx_, rp=fp_;
+            /* ʧܻܳʱֵ */
+            if(track_fold_refine(prog,&rx,&rp,&info->nevals) && fabs(rx-fx_)+fabs(rp-fp_)<2*ds){ fx_=rx; fp_=rp; }
+            info->turn_p[info->nturn]=fp_;
+            info->turn_x[info->nturn]=fx_;
+            if(out) fprintf(out,"%.15g,%.15g,turn\n",info->turn_p[info->nturn],info->turn_x[info->nturn]);
+            info->nturn++;
+        }
+        /* Խյʱ p1  x У */
+        if((np_-p1)*dir>0 && fabs(ntp)>1e-3){
+            double xe=x+(nx-x)*(p1-p)/(np_-p);
+            for(k=0;k<20;++k){
+                if(!track_eval(prog,xe,p1,&F,&Fx,&Fp,&info->nevals) || Fx==0.0) break;
+                xe-=F/Fx;
+                if(fabs(F)<1e-12*(1.0+fabs(xe))) break;
+            }
+            nx=xe; np_=p1;
+        }
+        /* 뿪䣨ջһֹࣩͣ */
+        if((np_-p0)*dir<0){ p=np_; x=nx; stop=1; continue; }
+        x=nx; p=np_; tx=ntx; tp=ntp;
+        if(it<=2){ ds*=1.5; if(ds>ds0) ds=ds0; }   /*  steps 岽 */
+        else if(it>=5) ds*=0.7;
+    }
+    info->p_end=p; info->x_end=x; info->reached=((p-p1)*dir>=0 && fabs(p-p1)<1e-12*(1.0+fabs(p1)));
+    *pp=ap; *px=ax;
+    return 1;
+}
+
+/* ------------ /solvemany ------------
+ * ÿ CALC_LANES ֵΪһͬʱ Newtonÿֻδͨ
+ * (x, xh) ֵʧܵͨƳ
+ * Newton ʧܵͨٵ + Brent  */
+#define SOLVEMANY_MAX_N 10000000L
+
+typedef enum { SM_FAIL=0, SM_NEWTON=1, SM_BRENT=2 } SmStatus;
+typedef struct { long n, n_newton, n_brent, n_fail; double rmin, rmax; long nevals; } SolveManyStats;
+
+static double sm_eval(CalcProgram* prog,double x,double p,long* nev){
+    double v[2]; v[0]=x; v[1]=p; (*nev)++;
+    return calc_eval_point(prog,v);
+}
+/* BrentzeroinҪ f(a)f(b)  */
+static int sm_brent(CalcProgram* prog,double p,double a,double b,double fa,double fb,double tol,double* root,long* nev){
+    double c=a, fc=fa, d=b-a, e=d; int it;
+    for(it=0;it<200;++it){
+        double tol1, xm, s, q, r, pp;
+        if((fb>0 && fc>0) || (fb<0 && fc<0)){ c=a; fc=fa; d=b-a; e=d; }
+        if(fabs(fc)<fabs(fb)){ a=b; b=c; c=a; fa=fb; fb=fc; fc=fa; }
+        tol1=2.0*DBL_EPSILON*fabs(b)+0.5*tol;
+        xm=0.5*(c-b);
+        if(fabs(xm)<=tol1 || fb==0.0){ *root=b; return 1; }
+        if(fabs(e)>=tol1 && fabs(fa)>fabs(fb)){
+            s=fb/fa;
+            if(a==c){ pp=2.0*xm*s; q=1.0-s; }
+            else{
+                q=fa/fc; r=fb/fc;
+                pp=s*(2.0*xm*q*(q-r)-(b-a)*(r-1.0));
+                q=(q-1.0)*(r-1.0)*(s-1.0);
+            }
+            if(pp>0) q=-q; else pp=-pp;
+            if(2.0*pp < 3.0*xm*q-fabs(tol1*q) && 2.0*pp < fabs(e*q)){ e=d; d=pp/q; }
+            else { d=xm; e=d; }
+        }else { d=xm; e=d; }
+        a=b; fa=fb;
+        b+= (fabs(d)>tol1)? d : (xm>0? tol1 : -tol1);
+        fb=sm_eval(prog,b,p,nev);
+        if(!isfinite(fb)) return 0;
+    }
+    return 0;
+}
+/*  x0 ༸ұ */
+static int sm_bracket_brent(CalcProgram* prog,double p,double x0,double tol,double* root,long* nev){
+    double f0=sm_eval(prog,x0,p,nev), step=0.1*(1.0+fabs(x0)), xl=x0, xr=x0, fl=f0, fr=f0;
+    int k;
+    if(f0==0.0){ *root=x0; return 1; }
+    for(k=0;k<60;++k){
+        double nl=x0-step, nr=x0+step, gl=sm_eval(prog,nl,p,nev), gr=sm_eval(prog,nr,p,nev);
+        if(isfinite(gr) && isfinite(fr) && fr*gr<=0) return sm_brent(prog,p,xr,nr,fr,gr,tol,root,nev);
+        if(isfinite(gl) && isfinite(fl) && fl*gl<=0) return sm_brent(prog,p,nl,xl,gl,fl,tol,root,nev);
+        if(isfinite(gr)){ xr=nr; fr=gr; }
+        if(isfinite(gl)){ xl=nl; fl=gl; }
+        step*=1.6;
+    }
+    return 0;
+}
+
+static void solvemany_run(CalcProgram* prog,const double* ps,long n,double x0,int maxit,double tol,
+                          double* roots,unsigned char* status,SolveManyStats* st){
+    double X[3*CALC_LANES], P[3*CALC_LANES], Y[3*CALC_LANES], x[CALC_LANES], h[CALC_LANES];
+    int lane[CALC_LANES]; const double* in[2]; long base; int i, k, m, cnt, nact, it;
+    in[0]=X; in[1]=P;
+    memset(st,0,sizeof(*st)); st->n=n; st->rmin=1e300; st->rmax=-1e300;
+    for(base=0;base<n;base+=CALC_LANES){
+        cnt=(n-base<CALC_LANES)? (int)(n-base) : CALC_LANES;
+        for(i=0;i<cnt;++i){ x[i]=x0; status[base+i]=SM_FAIL; lane[i]=i; }
+        nact=cnt;
+        for(it=0;it<maxit && nact>0;++it){
+            /* ͨ[x | x+h | x-h] */
+            for(k=0;k<nact;++k){
+                i=lane[k]; h[i]=1e-6*(1.0+fabs(x[i]));
+                X[k]=x[i];           P[k]=ps[base+i];
+                X[nact+k]=x[i]+h[i]; P[nact+k]=ps[base+i];
+                X[2*nact+k]=x[i]-h[i]; P[2*nact+k]=ps[base+i];
+            }
+            calc_eval_batch(prog,in,3*nact,Y);
+            st->nevals+=3*nact;
+            /* ʧܵͨƳ루lane ԭѹY ԰ֲֶȡ */
+            for(k=0,m=0;k<nact;++k){
+                double f=Y[k], d, dx;
+                i=lane[k];
+                d=(Y[nact+k]-Y[2*nact+k])/(2*h[i]);
+                if(!isfinite(f) || !isfinite(d) || d==0.0) continue;       /*  Brent */
+                dx=f/d; x[i]-=dx;
+                if(fabs(f)<tol || fabs(dx)<=4*DBL_EPSILON*(1.0+fabs(x[i]))){ status[base+i]=SM_NEWTON; continue; }
+                lane[m++]=i;
+            }
+            nact=m;
+        }
+        for(i=0;i<cnt;++i){
+            if(status[base+i]==SM_NEWTON && isfinite(x[i])) roots[base+i]=x[i];
+            else if(sm_bracket_brent(prog,ps[base+i],x0,tol,&roots[base+i],&st->nevals)) status[base+i]=SM_BRENT;
+            else { status[base+i]=SM_FAIL; roots[base+i]=NAN; }
+        }
+    }
+    for(base=0;base<n;++base){
+        if(status[base]==SM_NEWTON) st->n_newton++;
+        else if(status[base]==SM_BRENT) st->n_brent++;
+        else { st->n_fail++; continue; }
+        if(roots[base]<st->rmin) st->rmin=roots[base];
+        if(roots[base]>st->rmax) st->rmax=roots[base];
+    }
+}
+
+/* ASCII ɢͼ x ӳ䵽Сy ӳ䵽У޵x Ҫ */
+static void plot_ascii_data(const double* xs,const double* ys,int n,int W,int H){
+    int i,j;
+    double xmin,xmax,ymin=1e300,ymax=-1e300;
+    char* grid; ArenaMark mk;
+    if(W<=0) W=60; if(W>120) W=120;
+    if(H<=0) H=20; if(H>40)  H=40;
+    if(n<=0) return;
+    xmin=xmax=xs[0];
+    for(i=1;i<n;++i){ if(xs[i]<xmin) xmin=xs[i]; if(xs[i]>xmax) xmax=xs[i]; }
+    if(xmax==xmin) xmax=xmin+1.0;
+
+    /* Ԥ ymin/ymax */
+    for(i=0;i<n;++i)
+        if(isfinite(ys[i])){ if(ys[i]<ymin) ymin=ys[i]; if(ys[i]>ymax) ymax=ys[i]; }
+    if(!(isfinite(ymin)&&isfinite(ymax)) || ymin==ymax){ ymin-=1; ymax+=1; }
+
+    /*  */
+    mk = calc_arena_mark();
+    grid = (char*)calc_arena_alloc((size_t)(W*H));
+    if(!grid) return;
+    for(i=0;i<H;++i) for(j=0;j<W;++j) grid[i*W+j]=' ';
+    /* ᣺x=0,y=0 */
+    if(xmin<=0 && xmax>=0){
+        int col = (int)((0 - xmin)/(xmax-xmin)*(W-1));
+        if(col<0) col=0; if(col>=W) col=W-1;
+        for(i=0;i<H;++i) grid[i*W+col]='|';
+    }
+    if(ymin<=0 && ymax>=0){
+        int row = (int)((ymax - 0)/(ymax-ymin)*(H-1));
+        if(row<0) row=0; if(row>=H) row=H-1;
+        for(j=0;j<W;++j) grid[row*W+j]='-';
+    }
+    /*  */
+    for(i=0;i<n;++i){
+        if(isfinite(ys[i])){
+            int col = (int)((xs[i]-xmin)/(xmax-xmin)*(W-1)+0.5);
+            int row = (int)((ymax - ys[i])/(ymax-ymin)*(H-1));
+            if(col>=0 && col<W && row>=0 && row<H) grid[row*W+col]='*';
+        }
+    }
+    /*  */
+    printf("\n y in [%.6g, %.6g]  x in [%.6g, %.6g]\n",ymin,ymax,xmin,xmax);
+    for(i=0;i<H;++i){
+        putchar(' ');
+        for(j=0;j<W;++j) putchar(grid[i*W+j]);
+        putchar('\n');
+    }
+    calc_arena_release(mk);
+}
+
+/* ASCII plotÿһ㣬ֵ */
+/* /plot Ĳ֣[xmin,xmax]  W Ⱦ㣨W<=120 */
+static int plot_sample_local(const char* expr,const char* v,double xmin,double xmax,int W,int opts,double* xs,double* ys,char* er,size_t em){
+    CalcProgram prog; const double* in[1];
+    int j;
+    if(!calc_compile(expr,&v,1,&prog,er,em)) return 0;
+    prog.fast=(opts&CALC_OPT_FAST)!=0; prog.f32=(opts&CALC_OPT_F32)!=0;
+    for(j=0;j<W;++j) xs[j] = (W>1)? xmin + (xmax-xmin)*j/(W-1.0) : xmin;
+    in[0]=xs;
+    calc_eval_batch(&prog,in,W,ys);
+    calc_program_free(&prog);
+    return 1;
+}
+static int plot_ascii(const char* expr,const char* v,double xmin,double xmax,int W,int H,int opts,char* er,size_t em){
+    double xs[120], ys[120];
+    if(W<=0) W=60; if(W>120) W=120;
+    if(!plot_sample_local(expr,v,xmin,xmax,W,opts,xs,ys,er,em)) return 0;
+    plot_ascii_data(xs,ys,W,W,H);
+    return 1;
+}
+
+/* ------------ ɨͼ/sweep /plot2d ------------
+ *  a:b:n Ϊ n Ⱦ㣻һڲ㣬 CALC_LANES ֵֿ
+ * дפڴ棩ͬʱͳ min/max λ */
+#define SWEEP_MAX_DIMS   4
+#define SWEEP_MAX_POINTS 100000000.0
+
+typedef struct { char name[NAME_LEN]; double a, b; long n; } SweepAxis;
+typedef struct {
+    long npts, nbad;
+    double vmin, vmax;
+    double argmin[SWEEP_MAX_DIMS], argmax[SWEEP_MAX_DIMS];
+} SweepStats;
+/* ͼ (x,y) ĸۼƾֵ */
+typedef struct { int W, H; double x0, x1, y0, y1; double* sum; int* cnt; int* bad; } HeatMap;
+
+static double sweep_axis_value(const SweepAxis* ax,long i){
+    return (ax->n>1)? ax->a + (ax->b-ax->a)*(double)i/(double)(ax->n-1) : ax->a;
+}
+
+/*  "x=a:b:n" */
+static int sweep_parse_axis(const char* s,SweepAxis* ax,char* er,size_t em){
+    const char* eq=strchr(s,'='); char* end; double n;
+    size_t ln;
+    if(!eq || eq==s){ snprintf(er,em,"ΧʽӦΪ var=a:b:n (%s)",s); return 0; }
+    ln=(size_t)(eq-s); if(ln>=NAME_LEN) ln=NAME_LEN-1;
+    memcpy(ax->name,s,ln); ax->name[ln]='\0';
+    ax->a=strtod(eq+1,&end); if(*end!=':'){ snprintf(er,em,"ΧʽӦΪ var=a:b:n (%s)",s); return 0; }
+    ax->b=strtod(end+1,&end); if(*end!=':'){ snprintf(er,em,"ΧʽӦΪ var=a:b:n (%s)",s); return 0; }
+    n=strtod(end+1,&end);
+    if(*end || !(n>=1) || n>SWEEP_MAX_POINTS || !isfinite(ax->a) || !isfinite(ax->b)){ snprintf(er,em,"%s ĵ˵Ч",ax->name); return 0; }
+    ax->n=(long)n;
+    return 1;
+}
+
+static int heat_init(HeatMap* hm,int W,int H,double x0,double x1,double y0,double y1){
+    size_t cells;
+    if(W<=0) W=60;
+    if(W>120) W=120;
+    if(H<=0) H=20;
+    if(H>40) H=40;
+    cells=(size_t)W*(size_t)H;
+    hm->W=W; hm->H=H; hm->x0=x0; hm->x1=x1; hm->y0=y0; hm->y1=y1;
+    hm->sum=(double*)calc_calloc(MEM_ARRAY,cells,sizeof(double));
+    hm->cnt=(int*)calc_calloc(MEM_ARRAY,cells,sizeof(int));
+    hm->bad=(int*)calc_calloc(MEM_ARRAY,cells,sizeof(int));
+    if(!hm->sum||!hm->cnt||!hm->bad){ calc_free(hm->sum); calc_free(hm->cnt); calc_free(hm->bad); return 0; }
+    return 1;
+}
+static void heat_free(HeatMap* hm){ calc_free(hm->sum); calc_free(hm->cnt); calc_free(hm->bad); hm->sum=NULL; hm->cnt=NULL; hm->bad=NULL; }
+static void heat_add(HeatMap* hm,double x,double y,double f){
+    int c, r;
+    c=(hm->x1>hm->x0)? (int)((x-hm->x0)/(hm->x1-hm->x0)*(hm->W-1)+0.5) : 0;
+    r=(hm->y1>hm->y0)? (int)((hm->y1-y)/(hm->y1-hm->y0)*(hm->H-1)+0.5) : 0;
+    if(c<0||c>=hm->W||r<0||r>=hm->H) return;
+    if(isfinite(f)){ hm->sum[r*hm->W+c]+=f; hm->cnt[r*hm->W+c]++; }
+    else hm->bad[r*hm->W+c]++;
+}
+/* Ӿֵ 10 Ҷַʾ'?' ʾֻЧֵ */
+static void heat_print(const HeatMap* hm,const char* xn,const char* yn){
+    static const char shade[]=" .:-=+*#%@";
+    int i,j; double lo=1e300, hi=-1e300, v;
+    for(i=0;i<hm->W*hm->H;++i) if(hm->cnt[i]){
+        v=hm->sum[i]/hm->cnt[i]; if(v<lo) lo=v; if(v>hi) hi=v;
+    }
+    printf("\n %s in [%.6g, %.6g] ()  %s in [%.6g, %.6g] ()\n",xn,hm->x0,hm->x1,yn,hm->y0,hm->y1);
+    printf(" +"); for(j=0;j<hm->W;++j) putchar('-'); printf("+\n");
+    for(i=0;i<hm->H;++i){
+        printf(" |");
+        for(j=0;j<hm->W;++j){
+            int k=i*hm->W+j, s;
+            if(hm->cnt[k]){
+                v=hm->sum[k]/hm->cnt[k];
+                s=(hi>lo)? (int)((v-lo)/(hi-lo)*9.0+0.5) : 5;
+                putchar(shade[s]);
+            }else putchar(hm->bad[k]? '?' : ' ');
+        }
+        printf("|\n");
+    }
+    printf(" +"); for(j=0;j<hm->W;++j) putchar('-'); printf("+\n");
+    if(lo<=hi) printf(" ɫ \"%s\": %.6g -> %.6g\n",shade,lo,hi);
+}
+
+/* ɨѭout ǿʱд CSVhm ǿʱάۼƵͼ */
+static int sweep_run(const char* expr,const SweepAxis* ax,int nax,FILE* out,HeatMap* hm,SweepStats* st,int opts,char* er,size_t em){
+    CalcProgram prog; const char* names[SWEEP_MAX_DIMS]; const double* in[SWEEP_MAX_DIMS];
+    double *buf, ys[CALC_LANES], total=1.0; long idx[SWEEP_MAX_DIMS], base, inner;
+    int d, k, cnt, last=nax-1; ArenaMark mk;
+    if(nax<1 || nax>SWEEP_MAX_DIMS){ snprintf(er,em,"ά [1,%d]",SWEEP_MAX_DIMS); return 0; }
+    for(d=0;d<nax;++d){ names[d]=ax[d].name; total*=(double)ax[d].n; }
+    if(total>SWEEP_MAX_POINTS){ snprintf(er,em,"ܵ %.0f  %.0f",total,SWEEP_MAX_POINTS); return 0; }
+    if(!calc_compile(expr,names,nax,&prog,er,em)) return 0;
+    prog.fast=(opts&CALC_OPT_FAST)!=0; prog.f32=(opts&CALC_OPT_F32)!=0;
+    mk=calc_arena_mark();
+    buf=(double*)calc_arena_alloc(sizeof(double)*CALC_LANES*(size_t)nax);
+    if(!buf){ calc_program_free(&prog); snprintf(er,em,"ڴ治"); return 0; }
+    for(d=0;d<nax;++d){ in[d]=buf+(size_t)d*CALC_LANES; idx[d]=0; }
+    st->npts=0; st->nbad=0; st->vmin=1e300; st->vmax=-1e300;
+    for(d=0;d<SWEEP_MAX_DIMS;++d){ st->argmin[d]=0.0; st->argmax[d]=0.0; }
+
+    if(out){
+        for(d=0;d<nax;++d) fprintf(out,"%s,",ax[d].name);
+        fprintf(out,"f\n");
+    }
+    inner=ax[last].n;
+    for(;;){
+        /* һڲ */
+        for(base=0;base<inner;base+=CALC_LANES){
+            cnt=(int)((inner-base<CALC_LANES)? inner-base : CALC_LANES);
+            for(d=0;d<last;++d){
+                double xv=sweep_axis_value(&ax[d],idx[d]);
+                for(k=0;k<cnt;++k) buf[(size_t)d*CALC_LANES+k]=xv;
+            }
+            for(k=0;k<cnt;++k) buf[(size_t)last*CALC_LANES+k]=sweep_axis_value(&ax[last],base+k);
+            calc_eval_batch(&prog,in,cnt,ys);
+            for(k=0;k<cnt;++k){
+                double f=ys[k];
+                if(isfinite(f)){
+                    if(f<st->vmin){ st->vmin=f; for(d=0;d<nax;++d) st->argmin[d]=in[d][k]; }
+                    if(f>st->vmax){ st->vmax=f; for(d=0;d<nax;++d) st->argmax[d]=in[d][k]; }
+                }else st->nbad++;
+                if(hm) heat_add(hm,in[0][k],nax>1? in[1][k]:0.0,f);
+            }
+            if(out){
+                for(k=0;k<cnt;++k){
+                    for(d=0;d<nax;++d) fprintf(out,"%.15g,",in[d][k]);
+                    fprintf(out,"%.15g\n",ys[k]);
+                }
+            }
+            st->npts+=cnt;
+        }
+        /* ±λ */
+        for(d=last-1;d>=0;--d){
+            if(++idx[d]<ax[d].n) break;
+            idx[d]=0;
+        }
+        if(d<0) break;
+    }
+    calc_arena_release(mk);
+    calc_program_free(&prog);
+    if(out && ferror(out)){ snprintf(er,em,"дļʧ"); return 0; }
+    return 1;
+}
+
+/* ȡ CSVǰΪ꣬ĩΪֵͷԶͼ */
+static int plot2d_csv(const char* file,int W,int H,char* er,size_t em){
+    FILE* fp=fopen(file,"r"); char line[MAX_LINE], xn[NAME_LEN]="x", yn[NAME_LEN]="y";
+    double x,y,f,x0=1e300,x1=-1e300,y0=1e300,y1=-1e300; long n=0; int pass; HeatMap hm;
+    if(!fp){ snprintf(er,em,"޷ %s",file); return 0; }
+    for(pass=0;pass<2;++pass){
+        rewind(fp);
+        while(fgets(line,sizeof(line),fp)){
+            char *p=line, *end, *c; double vals[3]; int nv=0;
+            f=0.0;
+            for(;;){
+                double t=strtod(p,&end);
+                if(end==p) break;
+                if(nv<2) vals[nv]=t;
+                nv++; f=t;
+                while(*end==' '||*end=='\t') end++;
+                if(*end!=',') break;
+                p=end+1;
+            }
+            if(nv<3){
+                if(pass==0 && n==0 && (c=strchr(line,','))!=NULL){   /* ͷȡǰ */
+                    size_t l=(size_t)(c-line); if(l>=NAME_LEN) l=NAME_LEN-1;
+                    memcpy(xn,line,l); xn[l]='\0';
+                    p=c+1; c=strchr(p,',');
+                    if(c){ l=(size_t)(c-p); if(l>=NAME_LEN) l=NAME_LEN-1; memcpy(yn,p,l); yn[l]='\0'; }
+                }
+                continue;
+            }
+            x=vals[0]; y=vals[1];
+            if(pass==0){
+                if(x<x0) x0=x;
+                if(x>x1) x1=x;
+                if(y<y0) y0=y;
+                if(y>y1) y1=y;
+                n++;
+            }else heat_add(&hm,x,y,f);
+        }
+        if(pass==0){
+            if(n==0){ fclose(fp); snprintf(er,em,"%s û x,y,f ",file); return 0; }
+            if(!heat_init(&hm,W,H,x0,x1,y0,y1)){ fclose(fp); snprintf(er,em,"ڴ治"); return 0; }
+        }
+    }
+    fclose(fp);
+    heat_print(&hm,xn,yn);
+    heat_free(&hm);
+    return 1;
+}
+
+/* ------------ ؿ壨/montecarlo ------------
+ *  MC_CHUNK ֿ飬 j ʹ jump j κֿ޹ءɸ֣
+ * ڰ CALC_LANES 벢ֵֵ/ϲChan ʽ
+ * ֱͼΧȡǰ MC_PILOT ЧķΧ */
+#define MC_CHUNK  65536
+#define MC_PILOT  4096
+#define MC_BINS   20
+#define MC_MAX_N  1e12
+
+typedef enum { MC_DIST_U, MC_DIST_N, MC_DIST_E } McDist;
+typedef struct { char name[NAME_LEN]; McDist dist; double p1, p2; } McVar;
+typedef struct {
+    double n, nbad, mean, m2;           /* m2 Ϊƽ */
+    double lo, hi, under, over;
+    double hist[MC_BINS];
+} McStats;
+
+/*  "x~U(a,b)" / "x~N(mu,sigma)" / "x~E(lambda)" */
+static int mc_parse_var(const char* s,McVar* v,char* er,size_t em){
+    const char* t=strchr(s,'~'); const char* p; char* end; size_t ln;
+    if(!t || t==s){ snprintf(er,em,"ֲʽӦΪ var~U(a,b)|N(mu,s)|E(l)"); return 0; }
+    ln=(size_t)(t-s); if(ln>=NAME_LEN) ln=NAME_LEN-1;
+    memcpy(v->name,s,ln); v->name[ln]='\0';
+    p=t+1;
+    switch(toupper((unsigned char)*p)){
+        case 'U': v->dist=MC_DIST_U; break;
+        case 'N': v->dist=MC_DIST_N; break;
+        case 'E': v->dist=MC_DIST_E; break;
+        default: snprintf(er,em,"δֲ֪: %s",p); return 0;
+    }
+    if(p[1]!='('){ snprintf(er,em,"ֲд: %s",s); return 0; }
+    v->p1=strtod(p+2,&end);
+    if(v->dist==MC_DIST_E){
+        v->p2=0.0;
+        if(*end!=')' || !(v->p1>0)){ snprintf(er,em,"E(lambda) Ҫ lambda>0"); return 0; }
+        return 1;
+    }
+    if(*end!=','){ snprintf(er,em,"%s Ҫ",s); return 0; }
+    v->p2=strtod(end+1,&end);
+    if(*end!=')'){ snprintf(er,em,"Ųƥ: %s",s); return 0; }
+    if(v->dist==MC_DIST_U && !(v->p2>v->p1)){ snprintf(er,em,"U(a,b) Ҫ a<b"); return 0; }
+    if(v->dist==MC_DIST_N && !(v->p2>=0)){ snprintf(er,em,"N(mu,sigma) Ҫ sigma>=0"); return 0; }
+    return 1;
+}
+static void mc_fill_var(CalcRng* r,const McVar* v,double* y,int n){
+    int i;
+    if(v->dist==MC_DIST_U){
+        rng_fill_u01(r,y,n);
+        for(i=0;i<n;++i) y[i]=v->p1+(v->p2-v->p1)*y[i];
+    }else if(v->dist==MC_DIST_N){
+        rng_fill_normal(r,y,n);
+        for(i=0;i<n;++i) y[i]=v->p1+v->p2*y[i];
+    }else{
+        for(i=0;i<n;++i) y[i]=-log(rng_u01_open(r))/v->p1;
+    }
+}
+static void mc_hist_add(McStats* st,double y){
+    int b;
+    if(y<st->lo){ st->under+=1; return; }
+    b=(st->hi>st->lo)? (int)((y-st->lo)/(st->hi-st->lo)*MC_BINS) : 0;
+    if(b>=MC_BINS){ if(y>st->hi){ st->over+=1; return; } b=MC_BINS-1; }
+    st->hist[b]+=1;
+}
+
+static int mc_run(const char* expr,const McVar* vars,int nv,double N,calc_u64 seed,McStats* st,int opts,char* er,size_t em){
+    CalcProgram prog; const char* names[MAX_BIND]; const double* in[MAX_BIND];
+    double *buf, ys[CALC_LANES], *pilot, done=0.0;
+    CalcRng base, cur; int k, d, cnt, npilot=0, ranged=0; ArenaMark mk;
+    names[0]=NULL;
+    if(nv>MAX_BIND){ snprintf(er,em,"(>%d)",MAX_BIND); return 0; }
+    if(!(N>=1) || N>MC_MAX_N){ snprintf(er,em," [1,%.0e]",MC_MAX_N); return 0; }
+    for(d=0;d<nv;++d) names[d]=vars[d].name;
+    if(!calc_compile(expr,names,nv,&prog,er,em)) return 0;
+    prog.fast=(opts&CALC_OPT_FAST)!=0; prog.f32=(opts&CALC_OPT_F32)!=0;
+    mk=calc_arena_mark();
+    buf=(double*)calc_arena_alloc(sizeof(double)*CALC_LANES*(size_t)(nv>0?nv:1));
+    pilot=(double*)calc_arena_alloc(sizeof(double)*MC_PILOT);
+    if(!buf||!pilot){ calc_arena_release(mk); calc_program_free(&prog); snprintf(er,em,"ڴ治"); return 0; }
+    for(d=0;d<nv;++d) in[d]=buf+(size_t)d*CALC_LANES;
+    memset(st,0,sizeof(*st));
+    rng_seed(&base,seed);
+
+    while(done<N){
+        double chunk=N-done, cdone=0.0;
+        if(chunk>MC_CHUNK) chunk=MC_CHUNK;
+        cur=base; rng_jump(&base);
+        g_rng_active=&cur;              /* ʽ rand()/randn() Ҳñ */
+        while(cdone<chunk){
+            double bn=0.0, bmean=0.0, bm2=0.0, delta, tot;
+            cnt=(chunk-cdone<CALC_LANES)? (int)(chunk-cdone) : CALC_LANES;
+            for(d=0;d<nv;++d) mc_fill_var(&cur,&vars[d],buf+(size_t)d*CALC_LANES,cnt);
+            calc_eval_batch(&prog,in,cnt,ys);
+            for(k=0;k<cnt;++k){
+                double y=ys[k];
+                if(!isfinite(y)){ st->nbad+=1; continue; }
+                bn+=1; delta=y-bmean; bmean+=delta/bn; bm2+=delta*(y-bmean);
+                if(ranged) mc_hist_add(st,y);
+                else pilot[npilot++]=y;
+                if(!ranged && npilot==MC_PILOT){
+                    int i; double lo=pilot[0], hi=pilot[0];
+                    for(i=1;i<npilot;++i){ if(pilot[i]<lo) lo=pilot[i]; if(pilot[i]>hi) hi=pilot[i]; }
+                    st->lo=lo-0.05*(hi-lo); st->hi=hi+0.05*(hi-lo); ranged=1;
+                    for(i=0;i<npilot;++i) mc_hist_add(st,pilot[i]);
+                }
+            }
+            if(bn>0){
+                tot=st->n+bn; delta=bmean-st->mean;
+                st->mean+=delta*bn/tot;
+                st->m2+=bm2+delta*delta*st->n*bn/tot;
+                st->n=tot;
+            }
+            cdone+=cnt;
+        }
+        done+=chunk;
+    }
+    g_rng_active=&g_rng;
+    if(!ranged && npilot>0){
+        int i; double lo=pilot[0], hi=pilot[0];
+        for(i=1;i<npilot;++i){ if(pilot[i]<lo) lo=pilot[i]; if(pilot[i]>hi) hi=pilot[i]; }
+        st->lo=lo; st->hi=hi;
+        for(i=0;i<npilot;++i) mc_hist_add(st,pilot[i]);
+    }
+    calc_arena_release(mk);
+    calc_program_free(&prog);
+    if(st->n==0){ snprintf(er,em,"ֵʧ"); return 0; }
+    return 1;
+}
+static void mc_hist_print(const McStats* st){
+    int b, j; double mx=0;
+    for(b=0;b<MC_BINS;++b) if(st->hist[b]>mx) mx=st->hist[b];
+    printf("\n ֱͼ (%d , Ч %.0f)\n",MC_BINS,st->n);
+    for(b=0;b<MC_BINS;++b){
+        double a=st->lo+(st->hi-st->lo)*b/MC_BINS, c=st->lo+(st->hi-st->lo)*(b+1)/MC_BINS;
+        int w=(mx>0)? (int)(st->hist[b]/mx*50+0.5) : 0;
+        printf(" [%11.5g,%11.5g) %10.0f |",a,c,st->hist[b]);
+        for(j=0;j<w;++j) putchar('#');
+        putchar('\n');
+    }
+    if(st->under>0 || st->over>0) printf(" Χ %.0f %.0f\n",st->under,st->over);
+}
+
+/* ------------ ȴ洢 /mat /eig /svd ʹã ------------ */
+typedef struct { char name[NAME_LEN]; int rows, cols; double* a; int in_use; } MatItem;
+static MatItem g_mats[MAX_MATS];
+
+static int mat_find_index(const char* name){
+    int i;
+    for(i=0;i<MAX_MATS;++i)
+        if(g_mats[i].in_use && strcmp(g_mats[i].name,name)==0) return i;
+    return -1;
+}
+static MatItem* mat_get(const char* name){
+    int i=mat_find_index(name);
+    return (i>=0)? &g_mats[i] : NULL;
+}
+/*  data Ϊ nameѴ򸲸ǣʧܷ 0 */
+static int mat_set(const char* name,int rows,int cols,const double* data){
+    int i=mat_find_index(name);
+    double* p;
+    if(rows<=0 || cols<=0) return 0;
+    p=(double*)calc_malloc(MEM_VARS,sizeof(double)*(size_t)rows*(size_t)cols);
+    if(!p) return 0;
+    memcpy(p,data,sizeof(double)*(size_t)rows*(size_t)cols);
+    if(i<0){
+        for(i=0;i<MAX_MATS;++i) if(!g_mats[i].in_use) break;
+        if(i==MAX_MATS){ calc_free(p); return 0; }
+        strncpy(g_mats[i].name,name,NAME_LEN-1);
+        g_mats[i].name[NAME_LEN-1]='\0';
+        g_mats[i].in_use=1;
+    }else if(g_mats[i].a){
+        calc_free(g_mats[i].a);
+    }
+    g_mats[i].rows=rows; g_mats[i].cols=cols; g_mats[i].a=p;
+    return 1;
+}
+static int mat_del(const char* name){
+    int i=mat_find_index(name);
+    if(i<0) return 0;
+    if(g_mats[i].a) calc_free(g_mats[i].a);
+    g_mats[i].a=NULL; g_mats[i].in_use=0; g_mats[i].name[0]='\0';
+    return 1;
+}
+static void mat_print(const MatItem* m){
+    int i,j;
+    printf("%s (%dx%d):\n",m->name,m->rows,m->cols);
+    for(i=0;i<m->rows;++i){
+        printf("  [");
+        for(j=0;j<m->cols;++j) printf(" %14.8g",m->a[i*m->cols+j]);
+        printf(" ]\n");
+    }
+}
+static void mat_list(void){
+    int i, cnt=0;
+    printf("Matrices:\n");
+    for(i=0;i<MAX_MATS;++i) if(g_mats[i].in_use){
+        printf("  %-8s %dx%d\n",g_mats[i].name,g_mats[i].rows,g_mats[i].cols);
+        cnt++;
+    }
+    if(cnt==0) printf("  (none)\n");
+}
+
+/* "[1,2;3,4]" ';' ָԪ ',' ָڵĶںԪΪʽ */
+static int mat_parse_local(const char* s,double* buf,int cap,int* rows,int* cols,char* er,size_t em){
+    char tmp[MAX_LINE], elem[MAX_LINE];
+    const char* p; int depth=0, n=0, r=0, c=0, len=0;
+    double v;
+    while(*s==' '||*s=='\t') s++;
+    if(*s!='['){ snprintf(er,em,"д [a,b;c,d]"); return 0; }
+    strncpy(tmp,s+1,sizeof(tmp)-1); tmp[sizeof(tmp)-1]='\0';
+    trim_spaces(tmp);
+    len=(int)strlen(tmp);
+    if(len==0 || tmp[len-1]!=']'){ snprintf(er,em,"ȱ ']'"); return 0; }
+    tmp[len-1]='\0';
+    *rows=0; *cols=0; len=0;
+    for(p=tmp;;++p){
+        if(*p=='(') depth++;
+        else if(*p==')') depth--;
+        if(*p=='\0' || (depth==0 && (*p==',' || *p==';'))){
+            elem[len]='\0'; trim_spaces(elem);
+            if(elem[0]=='\0'){ snprintf(er,em," %d дڿԪ",r+1); return 0; }
+            if(!eval_expr_local(elem,&v,er,em)) return 0;
+            if(n>=cap){ snprintf(er,em,"Ԫع(>%d)",cap); return 0; }
+            buf[n++]=v; c++; len=0;
+            if(*p!=','){
+                if(r==0) *cols=c;
+                else if(c!=*cols){ snprintf(er,em," %d  %d  %d һ",r+1,c,*cols); return 0; }
+                r++; c=0;
+                if(*p=='\0') break;
+            }
+            continue;
+        }
+        if(len<(int)sizeof(elem)-1) elem[len++]=*p;
+    }
+    *rows=r;
+    return 1;
+}
+
+static double hypot_local(double a,double b){
+    double x=fabs(a), y=fabs(b), t;
+    if(x<y){ t=x; x=y; y=t; }
+    if(x==0.0) return 0.0;
+    t=y/x;
+    return x*sqrt(1.0+t*t);
+}
+
+/* Գƾֽ⣺Householder Խǻ + ʽλ QLEISPACK tred2/tql2
+ * a Ϊ nn ȣ w ֵv ĵ j ΪӦλ */
+static int mat_eig_sym(int n,const double* a,double* w,double* v,char* er,size_t em){
+    double *d=w, *e;
+    int i,j,k,l,m,iter;
+    double f,g,h,hh,scale,tst1,eps=2.220446049250313e-16;
+    e=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n);
+    if(!e){ snprintf(er,em,"ڴ治"); return 0; }
+    for(i=0;i<n*n;++i) v[i]=a[i];
+#define V_(r,c) v[(r)*n+(c)]
+    /* tred2 */
+    for(j=0;j<n;++j) d[j]=V_(n-1,j);
+    for(i=n-1;i>0;--i){
+        scale=0.0; h=0.0;
+        for(k=0;k<i;++k) scale+=fabs(d[k]);
+        if(scale==0.0){
+            e[i]=d[i-1];
+            for(j=0;j<i;++j){ d[j]=V_(i-1,j); V_(i,j)=0.0; V_(j,i)=0.0; }
+        }else{
+            for(k=0;k<i;++k){ d[k]/=scale; h+=d[k]*d[k]; }
+            f=d[i-1]; g=sqrt(h); if(f>0) g=-g;
+            e[i]=scale*g; h-=f*g; d[i-1]=f-g;
+            for(j=0;j<i;++j) e[j]=0.0;
+            for(j=0;j<i;++j){
+                f=d[j]; V_(j,i)=f; g=e[j]+V_(j,j)*f;
+                for(k=j+1;k<=i-1;++k){ g+=V_(k,j)*d[k]; e[k]+=V_(k,j)*f; }
+                e[j]=g;
+            }
+            f=0.0;
+            for(j=0;j<i;++j){ e[j]/=h; f+=e[j]*d[j]; }
+            hh=f/(h+h);
+            for(j=0;j<i;++j) e[j]-=hh*d[j];
+            for(j=0;j<i;++j){
+                f=d[j]; g=e[j];
+                for(k=j;k<=i-1;++k) V_(k,j)-=(f*e[k]+g*d[k]);
+                d[j]=V_(i-1,j); V_(i,j)=0.0;
+            }
+        }
+        d[i]=h;
+    }
+    for(i=0;i<n-1;++i){
+        V_(n-1,i)=V_(i,i); V_(i,i)=1.0; h=d[i+1];
+        if(h!=0.0){
+            for(k=0;k<=i;++k) d[k]=V_(k,i+1)/h;
+            for(j=0;j<=i;++j){
+                g=0.0;
+                for(k=0;k<=i;++k) g+=V_(k,i+1)*V_(k,j);
+                for(k=0;k<=i;++k) V_(k,j)-=g*d[k];
+            }
+        }
+        for(k=0;k<=i;++k) V_(k,i+1)=0.0;
+    }
+    for(j=0;j<n;++j){ d[j]=V_(n-1,j); V_(n-1,j)=0.0; }
+    V_(n-1,n-1)=1.0; e[0]=0.0;
+
+    /* tql2 */
+    for(i=1;i<n;++i) e[i-1]=e[i];
+    e[n-1]=0.0;
+    f=0.0; tst1=0.0;
+    for(l=0;l<n;++l){
+        if(fabs(d[l])+fabs(e[l])>tst1) tst1=fabs(d[l])+fabs(e[l]);
+        m=l;
+        while(m<n){ if(fabs(e[m])<=eps*tst1) break; m++; }
+        if(m>l){
+            iter=0;
+            do{
+                double p,r,dl1,c,c2,c3,el1,s,s2;
+                if(++iter>60){ calc_free(e); snprintf(er,em,"QL δ"); return 0; }
+                g=d[l]; p=(d[l+1]-g)/(2.0*e[l]); r=hypot_local(p,1.0); if(p<0) r=-r;
+                d[l]=e[l]/(p+r); d[l+1]=e[l]*(p+r); dl1=d[l+1]; h=g-d[l];
+                for(i=l+2;i<n;++i) d[i]-=h;
+                f+=h;
+                p=d[m]; c=1.0; c2=c; c3=c; el1=e[l+1]; s=0.0; s2=0.0;
+                for(i=m-1;i>=l;--i){
+                    c3=c2; c2=c; s2=s;
+                    g=c*e[i]; h=c*p; r=hypot_local(p,e[i]);
+                    e[i+1]=s*r; s=e[i]/r; c=p/r;
+                    p=c*d[i]-s*g; d[i+1]=h+s*(c*g+s*d[i]);
+                    for(k=0;k<n;++k){
+                        h=V_(k,i+1);
+                        V_(k,i+1)=s*V_(k,i)+c*h;
+                        V_(k,i)=c*V_(k,i)-s*h;
+                    }
+                }
+                p=-s*s2*c3*el1*e[l]/dl1; e[l]=s*p; d[l]=c*p;
+            }while(fabs(e[l])>eps*tst1);
+        }
+        d[l]+=f; e[l]=0.0;
+    }
+    /* ѡͬʱУ */
+    for(i=0;i<n-1;++i){
+        k=i;
+        for(j=i+1;j<n;++j) if(d[j]<d[k]) k=j;
+        if(k!=i){
+            f=d[k]; d[k]=d[i]; d[i]=f;
+            for(j=0;j<n;++j){ f=V_(j,i); V_(j,i)=V_(j,k); V_(j,k)=f; }
+        }
+    }
+#undef V_
+    calc_free(e);
+    return 1;
+}
+
+/*  JacobiHestenesSVDa Ϊ mnҪ m>=nA = Udiag(s)V^T
+ * u Ϊ mns v Ϊ nn */
+static int mat_svd_tall(int m,int n,const double* a,double* u,double* s,double* v,char* er,size_t em){
+    int i,j,k,p,q,sweep,rotated;
+    double eps=2.220446049250313e-16;
+    for(i=0;i<m*n;++i) u[i]=a[i];
+    for(i=0;i<n;++i) for(j=0;j<n;++j) v[i*n+j]=(i==j)?1.0:0.0;
+    for(sweep=0;sweep<60;++sweep){
+        rotated=0;
+        for(p=0;p<n-1;++p) for(q=p+1;q<n;++q){
+            double alpha=0.0,beta=0.0,gamma=0.0,zeta,t,c,sn,t1;
+            for(k=0;k<m;++k){
+                alpha+=u[k*n+p]*u[k*n+p];
+                beta +=u[k*n+q]*u[k*n+q];
+                gamma+=u[k*n+p]*u[k*n+q];
+            }
+            if(gamma==0.0 || fabs(gamma)<=eps*sqrt(alpha*beta)) continue;
+            rotated=1;
+            zeta=(beta-alpha)/(2.0*gamma);
+            t=((zeta>=0)?1.0:-1.0)/(fabs(zeta)+sqrt(1.0+zeta*zeta));
+            c=1.0/sqrt(1.0+t*t); sn=c*t;
+            for(k=0;k<m;++k){
+                t1=u[k*n+p];
+                u[k*n+p]=c*t1-sn*u[k*n+q];
+                u[k*n+q]=sn*t1+c*u[k*n+q];
+            }
+            for(k=0;k<n;++k){
+                t1=v[k*n+p];
+                v[k*n+p]=c*t1-sn*v[k*n+q];
+                v[k*n+q]=sn*t1+c*v[k*n+q];
+            }
+        }
+        if(!rotated) break;
+    }
+    if(sweep==60){ snprintf(er,em,"Jacobi ɨδ"); return 0; }
+    for(j=0;j<n;++j){
+        double nrm=0.0;
+        for(k=0;k<m;++k) nrm+=u[k*n+j]*u[k*n+j];
+        nrm=sqrt(nrm); s[j]=nrm;
+        if(nrm>0.0) for(k=0;k<m;++k) u[k*n+j]/=nrm;
+    }
+    /* ͬʱ UV  */
+    for(i=0;i<n-1;++i){
+        k=i;
+        for(j=i+1;j<n;++j) if(s[j]>s[k]) k=j;
+        if(k!=i){
+            double t=s[k]; s[k]=s[i]; s[i]=t;
+            for(j=0;j<m;++j){ t=u[j*n+i]; u[j*n+i]=u[j*n+k]; u[j*n+k]=t; }
+            for(j=0;j<n;++j){ t=v[j*n+i]; v[j*n+i]=v[j*n+k]; v[j*n+k]=t; }
+        }
+    }
+    return 1;
+}
+/*  mnk=min(m,n) u Ϊ mks Ϊ kv Ϊ nkm<n ʱ A^T ֽ󽻻 U/V */
+static int mat_svd(int m,int n,const double* a,double* u,double* s,double* v,char* er,size_t em){
+    double* at; int i,j,ok;
+    if(m>=n) return mat_svd_tall(m,n,a,u,s,v,er,em);
+    at=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)m*(size_t)n);
+    if(!at){ snprintf(er,em,"ڴ治"); return 0; }
+    for(i=0;i<m;++i) for(j=0;j<n;++j) at[j*m+i]=a[i*n+j];
+    ok=mat_svd_tall(n,m,at,v,s,u,er,em);
+    calc_free(at);
+    return ok;
+}
+
+/* ------------ FFTϻ 2/3/4/5೤ Bluestein ------------ */
+typedef struct { double re, im; } CalcCplx;
+
+#define FFT_MAX_FACTORS 32
+#define FFT_PLAN_CACHE  4
+#define FFT_FOURSTEP_MIN (1<<18)  /* Сڴ˳ʱֽΪ n1n2 С任ֹڻ */
+typedef struct FftPlanTag {
+    int n;
+    int fac[2*FFT_MAX_FACTORS];  /* ( p, ʣ೤ m) ԣm==1  */
+    int ntw;                     /* n Ϊżʱֻǰ n/2 תӣȡ */
+    CalcCplx* tw;                /* exp(-2ik/n) */
+    /* Bluesteinn  2/3/5 ʱ 2 ݳ m ѭʵ */
+    int m;
+    CalcCplx* chirp;             /* exp(-ik^2/n)k<n */
+    CalcCplx* bfft;              /*  chirp е m  FFT */
+    struct FftPlanTag* sub;
+    /* Ĳn=n1n2б任 n2б任 n1 */
+    int n1, n2;
+    struct FftPlanTag *p1, *p2;
+} FftPlan;
+
+static FftPlan* g_fft_cache[FFT_PLAN_CACHE];
+static int g_fft_cache_next = 0;
+
+static CalcCplx fft_tw(const FftPlan* pl,size_t k){
+    CalcCplx t;
+    if((int)k<pl->ntw) return pl->tw[k];
+    t=pl->tw[k-(size_t)pl->ntw]; t.re=-t.re; t.im=-t.im;
+    return t;
+}
+static void fft_bf2(CalcCplx* F,size_t fstride,const FftPlan* pl,int m){
+    CalcCplx* F2=F+m; int k;
+    for(k=0;k<m;++k){
+        CalcCplx w=fft_tw(pl,fstride*(size_t)k), t;
+        t.re=F2[k].re*w.re-F2[k].im*w.im; t.im=F2[k].re*w.im+F2[k].im*w.re;
+        F2[k].re=F[k].re-t.re; F2[k].im=F[k].im-t.im;
+        F[k].re+=t.re; F[k].im+=t.im;
+    }
+}
+static void fft_bf4(CalcCplx* F,size_t fstride,const FftPlan* pl,int m){
+    int k;
+    for(k=0;k<m;++k){
+        CalcCplx w1=fft_tw(pl,fstride*(size_t)k), w2=fft_tw(pl,2*fstride*(size_t)k), w3=fft_tw(pl,3*fstride*(size_t)k);
+        CalcCplx s0,s1,s2,s3,s4,s5, *f1=F+k+m, *f2=F+k+2*m, *f3=F+k+3*m;
+        s0.re=f1->re*w1.re-f1->im*w1.im; s0.im=f1->re*w1.im+f1->im*w1.re;
+        s1.re=f2->re*w2.re-f2->im*w2.im; s1.im=f2->re*w2.im+f2->im*w2.re;
+        s2.re=f3->re*w3.re-f3->im*w3.im; s2.im=f3->re*w3.im+f3->im*w3.re;
+        s5.re=F[k].re-s1.re; s5.im=F[k].im-s1.im;
+        F[k].re+=s1.re; F[k].im+=s1.im;
+        s3.re=s0.re+s2.re; s3.im=s0.im+s2.im;
+        s4.re=s0.re-s2.re; s4.im=s0.im-s2.im;
+        f2->re=F[k].re-s3.re; f2->im=F[k].im-s3.im;
+        F[k].re+=s3.re; F[k].im+=s3.im;
+        f1->re=s5.re+s4.im; f1->im=s5.im-s4.re;
+        f3->re=s5.re-s4.im; f3->im=s5.im+s4.re;
+    }
+}
+/* ͨû35ֱӰ p  DFTתӺϲ */
+static void fft_bf_generic(CalcCplx* F,size_t fstride,const FftPlan* pl,int m,int p){
+    CalcCplx scratch[5];
+    int u,q1,q,k;
+    for(u=0;u<m;++u){
+        for(q1=0,k=u;q1<p;++q1,k+=m) scratch[q1]=F[k];
+        for(q1=0,k=u;q1<p;++q1,k+=m){
+            size_t twidx=0;
+            F[k]=scratch[0];
+            for(q=1;q<p;++q){
+                CalcCplx w;
+                twidx+=fstride*(size_t)k; if(twidx>=(size_t)pl->n) twidx-=(size_t)pl->n;
+                w=fft_tw(pl,twidx);
+                F[k].re+=scratch[q].re*w.re-scratch[q].im*w.im;
+                F[k].im+=scratch[q].re*w.im+scratch[q].im*w.re;
+            }
+        }
+    }
+}
+/* ݹ鰴ʱȡȶ p  m ı任 p  */
+static void fft_work(CalcCplx* out,const CalcCplx* in,size_t fstride,const int* fac,const FftPlan* pl){
+    CalcCplx* beg=out;
+    int p=fac[0], m=fac[1], q;
+    if(m==1){
+        for(q=0;q<p;++q){ out[q]=*in; in+=fstride; }
+    }else{
+        for(q=0;q<p;++q){ fft_work(out,in,fstride*(size_t)p,fac+2,pl); in+=fstride; out+=m; }
+    }
+    out=beg;
+    if(p==2) fft_bf2(out,fstride,pl,m);
+    else if(p==4) fft_bf4(out,fstride,pl,m);
+    else fft_bf_generic(out,fstride,pl,m,p);
+}
+
+static void fft_plan_free(FftPlan* pl){
+    if(!pl) return;
+    calc_free(pl->tw); calc_free(pl->chirp); calc_free(pl->bfft);
+    fft_plan_free(pl->sub); fft_plan_free(pl->p1); fft_plan_free(pl->p2);
+    calc_free(pl);
+}
+static int fft_execute(const FftPlan* pl,const CalcCplx* in,CalcCplx* out);
+
+static FftPlan* fft_plan_create(int n){
+    FftPlan* pl=(FftPlan*)calc_calloc(MEM_CACHE,1,sizeof(FftPlan));
+    int r=n, p=4, nf=0, k;
+    if(!pl) return NULL;
+    pl->n=n;
+    /* ʽֽ⣺ 4 235ʣ Bluestein */
+    while(r>1 && nf<FFT_MAX_FACTORS){
+        while(r%p){
+            if(p==4) p=2; else if(p==2) p=3; else if(p==3) p=5; else break;
+        }
+        if(r%p) break;
+        r/=p;
+        pl->fac[2*nf]=p; pl->fac[2*nf+1]=r; nf++;
+    }
+    if(n==1){ pl->fac[0]=1; pl->fac[1]=1; }
+    if(r>1){
+        /* BluesteinX_k = c_k   (x_j c_j)  conj(c_{k-j})c_k=exp(-ik^2/n) */
+        CalcCplx* b; size_t kk=0, twon=2*(size_t)n;
+        pl->m=1; while(pl->m<2*n-1) pl->m<<=1;
+        pl->sub=fft_plan_create(pl->m);
+        pl->chirp=(CalcCplx*)calc_malloc(MEM_CACHE,sizeof(CalcCplx)*(size_t)n);
+        pl->bfft=(CalcCplx*)calc_malloc(MEM_CACHE,sizeof(CalcCplx)*(size_t)pl->m);
+        b=(CalcCplx*)calc_calloc(MEM_CACHE,(size_t)pl->m,sizeof(CalcCplx));
+        if(!pl->sub || !pl->chirp || !pl->bfft || !b){ calc_free(b); fft_plan_free(pl); return NULL; }
+        for(k=0;k<n;++k){
+            if(k>0){ kk+=2*(size_t)k-1; if(kk>=twon) kk-=twon; } /* kk = k^2 mod 2n */
+            pl->chirp[k].re=cos(M_PI*(double)kk/n);
+            pl->chirp[k].im=-sin(M_PI*(double)kk/n);
+            b[k].re=pl->chirp[k].re; b[k].im=-pl->chirp[k].im;
+            if(k>0) b[pl->m-k]=b[k];
+        }
+        if(!fft_execute(pl->sub,b,pl->bfft)){ calc_free(b); fft_plan_free(pl); return NULL; }
+        calc_free(b);
+        return pl;
+    }
+    if(n>=FFT_FOURSTEP_MIN){
+        /* ȡС n ӻΪ n1 */
+        int n1=1;
+        for(k=0;k<nf && (double)n1*n1<(double)n;++k) n1*=pl->fac[2*k];
+        pl->n1=n1; pl->n2=n/n1;
+        pl->p1=fft_plan_create(pl->n1);
+        pl->p2=fft_plan_create(pl->n2);
+        if(!pl->p1 || !pl->p2){ fft_plan_free(pl); return NULL; }
+        return pl;
+    }
+    pl->ntw=(n%2==0)? n/2 : n;
+    pl->tw=(CalcCplx*)calc_malloc(MEM_CACHE,sizeof(CalcCplx)*(size_t)pl->ntw);
+    if(!pl->tw){ fft_plan_free(pl); return NULL; }
+    for(k=0;k<pl->ntw;++k){
+        double ang=-2.0*M_PI*(double)k/n;
+        pl->tw[k].re=cos(ang); pl->tw[k].im=sin(ang);
+    }
+    return pl;
+}
+/* ͬȵļƻתӡchirpڶεü临 */
+static FftPlan* fft_plan_get(int n){
+    int i;
+    for(i=0;i<FFT_PLAN_CACHE;++i) if(g_fft_cache[i] && g_fft_cache[i]->n==n) return g_fft_cache[i];
+    i=g_fft_cache_next; g_fft_cache_next=(g_fft_cache_next+1)%FFT_PLAN_CACHE;
+    fft_plan_free(g_fft_cache[i]);
+    g_fft_cache[i]=fft_plan_create(n);
+    return g_fft_cache[i];
+}
+
+/* ֿתãb Ϊ colsrowsb[c][r]=a[r][c] */
+static void fft_transpose(const CalcCplx* a,CalcCplx* b,int rows,int cols){
+    int r0,c0,r,c,r1,c1;
+    for(r0=0;r0<rows;r0+=32){
+        r1=(r0+32<rows)? r0+32 : rows;
+        for(c0=0;c0<cols;c0+=32){
+            c1=(c0+32<cols)? c0+32 : cols;
+            for(r=r0;r<r1;++r)
+                for(c=c0;c<c1;++c) b[(size_t)c*rows+r]=a[(size_t)r*cols+c];
+        }
+    }
+}
+/* Ĳx[j1+n1j2] Ȱ j2  n1  n2 ı任 exp(-2ij1k2/n)
+ * ٰ j1  n2  n1 ı任X[k2+n2k1]  */
+static int fft_fourstep(const FftPlan* pl,const CalcCplx* in,CalcCplx* out){
+    int n1=pl->n1, n2=pl->n2, j1, k2; ArenaMark mk=calc_arena_mark();
+    CalcCplx* tmp=(CalcCplx*)calc_arena_alloc(sizeof(CalcCplx)*(size_t)pl->n);
+    if(!tmp){ calc_arena_release(mk); return 0; }
+    fft_transpose(in,out,n2,n1);
+    for(j1=0;j1<n1;++j1){
+        CalcCplx *row=tmp+(size_t)j1*n2, w, c;
+        double ang=-2.0*M_PI*j1/pl->n;
+        if(!fft_execute(pl->p2,out+(size_t)j1*n2,row)){ calc_arena_release(mk); return 0; }
+        /* תõɣÿ 64 У׼ۻ */
+        w.re=cos(ang); w.im=sin(ang); c.re=1.0; c.im=0.0;
+        for(k2=0;k2<n2;++k2){
+            double re;
+            if((k2&63)==0){
+                double a2=-2.0*M_PI*(double)(((long)j1*k2)%pl->n)/pl->n;
+                c.re=cos(a2); c.im=sin(a2);
+            }
+            re=row[k2].re*c.re-row[k2].im*c.im;
+            row[k2].im=row[k2].re*c.im+row[k2].im*c.re;
+            row[k2].re=re;
+            re=c.re*w.re-c.im*w.im; c.im=c.re*w.im+c.im*w.re; c.re=re;
+        }
+    }
+    fft_transpose(tmp,out,n1,n2);
+    for(k2=0;k2<n2;++k2)
+        if(!fft_execute(pl->p1,out+(size_t)k2*n1,tmp+(size_t)k2*n1)){ calc_arena_release(mk); return 0; }
+    fft_transpose(tmp,out,n2,n1);
+    calc_arena_release(mk);
+    return 1;
+}
+
+/* in  out ص */
+static int fft_execute(const FftPlan* pl,const CalcCplx* in,CalcCplx* out){
+    CalcCplx* a; int k, n=pl->n, m=pl->m; ArenaMark mk;
+    if(pl->p1) return fft_fourstep(pl,in,out);
+    if(!pl->sub){ fft_work(out,in,1,pl->fac,pl); return 1; }
+    mk=calc_arena_mark();
+    if(!(a=(CalcCplx*)calc_arena_alloc(sizeof(CalcCplx)*2*(size_t)m))){ calc_arena_release(mk); return 0; }
+    memset(a,0,sizeof(CalcCplx)*2*(size_t)m);
+    for(k=0;k<n;++k){
+        a[k].re=in[k].re*pl->chirp[k].re-in[k].im*pl->chirp[k].im;
+        a[k].im=in[k].re*pl->chirp[k].im+in[k].im*pl->chirp[k].re;
+    }
+    if(!fft_execute(pl->sub,a,a+m)){ calc_arena_release(mk); return 0; }
+    /* Ƶ˺ȡ任任 1/m */
+    for(k=0;k<m;++k){
+        CalcCplx x=a[m+k], y=pl->bfft[k];
+        a[k].re=x.re*y.re-x.im*y.im;
+        a[k].im=-(x.re*y.im+x.im*y.re);
+    }
+    if(!fft_execute(pl->sub,a,a+m)){ calc_arena_release(mk); return 0; }
+    for(k=0;k<n;++k){
+        double re=a[m+k].re/m, im=-a[m+k].im/m;
+        out[k].re=re*pl->chirp[k].re-im*pl->chirp[k].im;
+        out[k].im=re*pl->chirp[k].im+im*pl->chirp[k].re;
+    }
+    calc_arena_release(mk);
+    return 1;
+}
+static int fft_forward(int n,const CalcCplx* in,CalcCplx* out,char* er,size_t em){
+    FftPlan* pl;
+    if(n<1 || n>FFT_MAX_N){ snprintf(er,em,"FFT  [1,%d]",FFT_MAX_N); return 0; }
+    pl=fft_plan_get(n);
+    if(!pl || !fft_execute(pl,in,out)){ snprintf(er,em,"ڴ治"); return 0; }
+    return 1;
+}
+
+/* ʵƵף fft_mag/fft_phasek=0..n/2df ΪƵʷֱʣѡ */
+static int fft_spectrum_local(const CalcCplx* in,int n,double df,int plot,char* msg,size_t msglen){
+    CalcCplx* out; double *mag,*ph,*fq; int k, nh=n/2+1, kmax=0; char er[128];
+    out=(CalcCplx*)calc_malloc(MEM_ARRAY,sizeof(CalcCplx)*(size_t)n);
+    mag=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)nh);
+    ph=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)nh);
+    if(!out||!mag||!ph){ calc_free(out); calc_free(mag); calc_free(ph); snprintf(msg,msglen,"/fft ʧ: ڴ治"); return 0; }
+    if(!fft_forward(n,in,out,er,sizeof(er))){ calc_free(out); calc_free(mag); calc_free(ph); snprintf(msg,msglen,"/fft ʧ: %s",er); return 0; }
+    for(k=0;k<nh;++k){
+        mag[k]=hypot_local(out[k].re,out[k].im);
+        ph[k]=atan2(out[k].im,out[k].re);
+        if(k>0 && mag[k]>mag[kmax]) kmax=k;
+    }
+    calc_free(out);
+    if(!mat_set("fft_mag",nh,1,mag) || !mat_set("fft_phase",nh,1,ph)){
+        calc_free(mag); calc_free(ph); snprintf(msg,msglen,"/fft ʧ: "); return 0;
+    }
+    if(plot){
+        fq=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)nh);
+        if(fq){
+            for(k=0;k<nh;++k) fq[k]=k*df;
+            plot_ascii_data(fq,mag,nh,70,20);
+            calc_free(fq);
+        }
+    }
+    snprintf(msg,msglen,"FFT N=%d: ֵ f=%.6g (bin %d) ֵ=%.6g -> fft_mag, fft_phase",
+             n,kmax*df,kmax,(kmax==0||2*kmax==n? 1.0:2.0)*mag[kmax]/n);
+    calc_free(mag); calc_free(ph);
+    return 1;
+}
+
+/* /helpȫгȫ */
+static void help_list_local(void){
+    printf("һ:\n");
+    printf("  \n");
+    printf("    /deg  /rad                     Ƕȵλ\n");
+    printf("    /let x=expr  /vars  /del x     Ϊĸ֡»ߣֿͷ\n");
+    printf("    /mc /mr /m+ [v] /m- [v]        ڴ棨㡢ۼӡۼ\n");
+    printf("    /history  /save <file>         ʷ¼\n");
+    printf("    /quit                          ˳\n");
+    printf("  ģʽ\n");
+    printf("    /fast [on|off]                 ٽƣ/plot /plot2d /sweep /montecarlo\n");
+    printf("    /prec [double|dd]              㾫\n");
+    printf("    /exact [on|off|show]           ȷ\n");
+    printf("    /prog [on|off] [8|16|32|64] [signed|unsigned] [wrap|checked] [hex|dec|oct|bin]\n");
+    printf("    /timing [on|off|stats|reset]   ֽ׶μʱ\n");
+    printf("    /mem [limit <ϵͳ|total> <MB|off>|reset]   ڴͳ\n");
+    printf("  ΢뷽\n");
+    printf("    /diff e v x0 [h]               ֵ΢\n");
+    printf("    /solve e v x0 [maxit tol]      Newton \n");
+    printf("    /track e x p p0 p1 steps x0 [--out f.csv] [--plot]\n");
+    printf("    /solvemany e x p file|a:b:n x0 [maxit tol] [--out f.csv]\n");
+    printf("    /integ e v a b [n|auto]        ֣Ĭ Simpson n=200\n");
+    printf("    /integn e x,y a:b,c:d [N] [--gm|--qmc|--halton] [--tol t] [--seed s]\n");
+    printf("    /sum e k a b|inf  /prod e k a b  /limit e x p|inf|-inf [+|-]\n");
+    printf("    /diff /solve /integ ɼ --trace f.csv\n");
+    printf("  ͼɨ\n");
+    printf("    /plot e v xmin xmax [W H]\n");
+    printf("    /plot2d e x a b y c d [W H]    /plot2d f.csv [W H]\n");
+    printf("    /sweep e x=a:b:n [y=a:b:n ...] [--out f.csv] [--plot]\n");
+    printf("    /plot /plot2d /sweep /montecarlo ɼ --f32\n");
+    printf("  任\n");
+    printf("    /montecarlo e x~U(a,b)|N(mu,s)|E(l) ... N [--seed s] [--hist]   /seed [n]\n");
+    printf("    /mat [A]  /mat A=[1,2;3,4]  /eig A [w V]  /svd A [U S V]\n");
+    printf("    /fft e v a b N [--plot]    /fft <vector> [--plot]\n");
+    printf("  \n");
+    printf("    /hex|/oct|/bin e [--out f]     /base <2..36> e [--out f]\n");
+    printf("   gamma lgamma beta erf erfc erfinv besselj bessely zeta hypot min max \n");
+    printf("  : --selftest  --bench [--json] [--reps R] [--corpus f]  --bench-f32\n");
+    printf("          --perfcheck ׼.json [...]  --gen-corpus N [...]\n");
+}
+
+/*  1 ʾѴ */
+static int handle_command_local(char* line,char* msg,size_t msglen){
+    char *cmd,*arg;
+
+    if(line[0] != '/') return 0;
+    cmd = strtok(line," \t\r\n");
+    arg = strtok(NULL,"");
+
+    if(is_cmd_local(cmd,"/help")){ clear_screen(); help_list_local(); printf("\nس..."); wait_enter_local(); msg[0]='\0'; return 1; }
+    if(is_cmd_local(cmd,"/deg")){ g_mode=MODE_DEG; snprintf(msg,msglen,"л DEG"); return 1; }
+    if(is_cmd_local(cmd,"/rad")){ g_mode=MODE_RAD; snprintf(msg,msglen,"л RAD"); return 1; }
+    if(is_cmd_local(cmd,"/prec")){
+        /* /prec [double|dd]ʽ/sum ޺ /integ ļ㾫 */
+        char w[8]="";
+        if(arg) sscanf(arg,"%7s",w);
+        if(strcmp(w,"dd")==0) g_prec=PREC_DD;
+        else if(strcmp(w,"double")==0) g_prec=PREC_DOUBLE;
+        else if(w[0]){ snprintf(msg,msglen,"÷: /prec [double|dd]"); return 1; }
+        if(g_prec==PREC_DD) snprintf(msg,msglen,"ȣ˫˫Լ 31 λʽ/sum/integ ˫˫");
+        else snprintf(msg,msglen,"ȣdoubleԼ 16 λ");
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/prog")){
+        /* /prog [on|off] [8|16|32|64] [signed|unsigned] [wrap|checked] [dec|hex|oct|bin]
+         * ϣüʱл */
+        char* t; int any=0;
+        static const char* bn[]={"bin","oct","dec","hex"};
+        static const int bv[]={2,8,10,16};
+        for(t=arg? strtok(arg," \t\r\n") : NULL; t; t=strtok(NULL," \t\r\n")){
+            int k, b=atoi(t);
+            any=1;
+            if(strcmp(t,"off")==0){ g_prog.on=0; continue; }
+            if(strcmp(t,"on")==0) ;
+            else if((b==8||b==16||b==32||b==64) && isdigit((unsigned char)t[0])) g_prog.bits=b;
+            else if(strcmp(t,"signed")==0 || strcmp(t,"unsigned")==0) g_prog.sgn=(t[0]=='s');
+            else if(strcmp(t,"wrap")==0 || strcmp(t,"checked")==0) g_prog.checked=(t[0]=='c');
+            else{
+                for(k=0;k<4 && strcmp(t,bn[k])!=0;++k) ;
+                if(k==4){ snprintf(msg,msglen,"÷: /prog [on|off] [8|16|32|64] [signed|unsigned] [wrap|checked] [hex..]"); return 1; }
+                g_prog.base=bv[k];
+            }
+            g_prog.on=1;
+        }
+        if(!any) g_prog.on=!g_prog.on;
+        if(g_prog.on) snprintf(msg,msglen,"Աģʽ%sint%d%s %s",g_prog.sgn? "" : "u",g_prog.bits,
+                               g_prog.checked? "" : "",g_prog.base==16? "hex" : g_prog.base==8? "oct" : g_prog.base==2? "bin" : "dec");
+        else snprintf(msg,msglen,"Աģʽ");
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/exact")){
+        /* /exact [on|off|show]ʱлshow ʾϴξȷȫ */
+        char w[8]="";
+        if(arg) sscanf(arg,"%7s",w);
+        if(strcmp(w,"show")==0){
+            char* t;
+            if(!g_last_rat_ok || rat_to_double(&g_last_rat)!=g_last_result){ snprintf(msg,msglen,"ûпʾľȷ"); return 1; }
+            t=rat_to_str(&g_last_rat);
+            if(!t){ snprintf(msg,msglen,"ڴ治"); return 1; }
+            clear_screen(); printf("%s\n",t); calc_free(t);
+            printf("\nس..."); wait_enter_local();
+            msg[0]='\0'; return 1;
+        }
+        if(strcmp(w,"on")==0) g_exact=1;
+        else if(strcmp(w,"off")==0) g_exact=0;
+        else if(w[0]){ snprintf(msg,msglen,"÷: /exact [on|off|show]"); return 1; }
+        else g_exact=!g_exact;
+        if(g_exact) snprintf(msg,msglen,"ȷģʽ㣬Խת double");
+        else snprintf(msg,msglen,"ȷģʽ");
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/timing")){
+        /* /timing [on|off|stats|reset]ʱлstats ʾۼͳ */
+        char w[8]="";
+        if(arg) sscanf(arg,"%7s",w);
+        if(strcmp(w,"stats")==0){
+            clear_screen(); timing_stats_print();
+            printf("\nس..."); wait_enter_local();
+            msg[0]='\0'; return 1;
+        }
+        if(strcmp(w,"reset")==0){ memset(g_tm_stat,0,sizeof(g_tm_stat)); snprintf(msg,msglen,"ʱͳ"); return 1; }
+        if(strcmp(w,"on")==0) g_timing=1;
+        else if(strcmp(w,"off")==0) g_timing=0;
+        else if(w[0]){ snprintf(msg,msglen,"÷: /timing [on|off|stats|reset]"); return 1; }
+        else g_timing=!g_timing;
+        timing_reset_line_local();   /* лڵһв */
+        if(g_timing) snprintf(msg,msglen,"ֽ׶μʱ/timing stats 鿴ͳƣ");
+        else snprintf(msg,msglen,"ֽ׶μʱ");
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/mem")){
+        /* /memϵͳڴ汨棻/mem limit <ϵͳ|total> <MB|off>ޣ/mem resetֵ */
+        char w[8]="", tag[16]="", val[16]="";
+        if(arg) sscanf(arg,"%7s %15s %15s",w,tag,val);
+        if(strcmp(w,"limit")==0){
+            MemStat* m=NULL; int i; double mb;
+            if(strcmp(tag,"total")==0) m=&g_mem_total;
+            for(i=0;i<MEM_NTAGS && !m;++i) if(strcmp(tag,g_mem_names[i])==0) m=&g_mem[i];
+            mb=(strcmp(val,"off")==0)? 0.0 : atof(val);
+            if(!m || mb<0 || (mb==0 && strcmp(val,"off")!=0)){
+                snprintf(msg,msglen,"÷: /mem limit <history|vars|code|cache|array|bignum|arena|pool|other|total> <MB|off>");
+                return 1;
+            }
+            m->limit=mb*1048576.0;
+            if(mb>0) snprintf(msg,msglen,"%s ڴ: %g MBǰ %.1f MB",tag,mb,m->cur/1048576.0);
+            else snprintf(msg,msglen,"%s ڴ: ",tag);
+            return 1;
+        }
+        if(strcmp(w,"reset")==0){
+            int i;
+            for(i=0;i<MEM_NTAGS;++i){ g_mem[i].peak=g_mem[i].cur; g_mem[i].nalloc=g_mem[i].nfree=g_mem[i].nfail=0; }
+            g_mem_total.peak=g_mem_total.cur; g_mem_total.nalloc=g_mem_total.nfree=g_mem_total.nfail=0;
+            g_arena.peak=g_arena.inuse; g_arena.allocs=g_arena.leaked=0; g_pool_hits=g_pool_misses=0;
+            snprintf(msg,msglen,"ڴֵ");
+            return 1;
+        }
+        if(w[0]){ snprintf(msg,msglen,"÷: /mem [limit <ϵͳ|total> <MB|off>|reset]"); return 1; }
+        clear_screen(); mem_report_print();
+        printf("\nس..."); wait_enter_local();
+        msg[0]='\0'; return 1;
+    }
+    if(is_cmd_local(cmd,"/fast")){
+        /* /fast [on|off]ʱл */
+        char w[8]="";
+        if(arg) sscanf(arg,"%7s",w);
+        if(strcmp(w,"on")==0) g_fast=1;
+        else if(strcmp(w,"off")==0) g_fast=0;
+        else if(w[0]){ snprintf(msg,msglen,"÷: /fast [on|off]"); return 1; }
+        else g_fast=!g_fast;
+        if(g_fast) snprintf(msg,msglen,"ٽģʽͼ/ɨ/MC  sin cos exp ln pow ƣ~1e-8");
+        else snprintf(msg,msglen,"ٽģʽأȫʹ libm");
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/mc")){ g_memory=0.0; snprintf(msg,msglen,"Memory cleared"); return 1; }
+    if(is_cmd_local(cmd,"/montecarlo")){
+        /* /montecarlo <expr> x~U(a,b) y~N(mu,s) ... <N> [--seed s] [--hist] [--f32] */
+        char e[MAX_LINE], er[128], *t; McVar vars[MAX_BIND]; McStats st;
+        int nv=0, hist=0, have_e=0, opts=batch_opts_local(arg); double N=0; calc_u64 seed=RNG_DEFAULT_SEED;
+        for(t=strtok(arg," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--hist")==0) hist=1;
+            else if(strcmp(t,"--seed")==0){
+                t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"--seed ȱֵ"); return 1; }
+                seed=(calc_u64)strtoul(t,NULL,10);
+            }else if(!have_e){ strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0'; have_e=1; }
+            else if(strchr(t,'~')){
+                if(nv>=MAX_BIND){ snprintf(msg,msglen,"/montecarlo  %d ",MAX_BIND); return 1; }
+                if(!mc_parse_var(t,&vars[nv],er,sizeof(er))){ snprintf(msg,msglen,"/montecarlo: %s",er); return 1; }
+                nv++;
+            }else N=atof(t);
+        }
+        if(!have_e || !(N>=1)){ snprintf(msg,msglen,"÷: /montecarlo <expr> x~U(a,b)|N(mu,s)|E(l) ... <N> [--seed s] [--hist] [--f32]"); return 1; }
+        N=floor(N);
+        if(!mc_run(e,vars,nv,N,seed,&st,opts,er,sizeof(er))){ snprintf(msg,msglen,"/montecarlo ʧ: %s",er); return 1; }
+        {
+            double data[MC_BINS*2], sd=(st.n>1)? sqrt(st.m2/(st.n-1)) : 0.0; int b;
+            for(b=0;b<MC_BINS;++b){ data[2*b]=st.lo+(st.hi-st.lo)*(b+0.5)/MC_BINS; data[2*b+1]=st.hist[b]; }
+            mat_set("mc_hist",MC_BINS,2,data);
+            if(hist){ clear_screen(); mc_hist_print(&st); printf("\nس..."); wait_enter_local(); }
+            g_last_result=st.mean; var_set("ans",g_last_result);
+            if(st.nbad>0) snprintf(msg,msglen,"MC N=%.0f: ֵ=%.10g  %.3g (=%.6g, ʧ %.0f) -> mc_hist",st.n,st.mean,sd/sqrt(st.n),sd,st.nbad);
+            else snprintf(msg,msglen,"MC N=%.0f: ֵ=%.10g  %.3g (=%.6g) -> mc_hist",st.n,st.mean,sd/sqrt(st.n),sd);
+        }
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/seed")){
+        /* /seed [n] rand()/randn()  */
+        unsigned long sd = arg ? strtoul(arg,NULL,10) : RNG_DEFAULT_SEED;
+        rng_seed(&g_rng,(calc_u64)sd);
+        snprintf(msg,msglen," = %lu",sd); return 1;
+    }
+    if(is_cmd_local(cmd,"/mr")){ snprintf(msg,msglen,"MR = %.15g",g_memory); g_last_result=g_memory; var_set("ans",g_last_result); return 1; }
+    if(is_cmd_local(cmd,"/m+")){
+        double v=g_last_result; if(arg) v=atof(arg);
+        g_memory += v; snprintf(msg,msglen,"M += %.15g -> %.15g",v,g_memory); return 1;
+    }
+    if(is_cmd_local(cmd,"/m-")){
+        double v=g_last_result; if(arg) v=atof(arg);
+        g_memory -= v; snprintf(msg,msglen,"M -= %.15g -> %.15g",v,g_memory); return 1;
+    }
+    if(is_cmd_local(cmd,"/history")){
+        clear_screen(); history_print(); printf("\nس..."); wait_enter_local();
+        msg[0]='\0'; return 1;
+    }
+    if(is_cmd_local(cmd,"/save")){
+        char* f = arg; if(!f || !*f){ snprintf(msg,msglen,"÷: /save <file>"); return 1; }
+        trim_spaces(f);
+        if(history_save(f)==0) snprintf(msg,msglen,"ʷѱ: %s",f);
+        else snprintf(msg,msglen,"ʧ");
+        return 1;
+    }
+    if(is_cmd_local(cmd,"/vars")){ clear_screen(); var_list(); printf("\nس..."); wait_enter_local(); msg[0]='\0'; return 1; }
+    if(is_cmd_local(cmd,"/del")){
+        char* name = arg; if(!name){ snprintf(msg,msglen,"÷: /del <name>"); return 1; }
+        trim_spaces(name);
+        if(var_del(name)) snprintf(msg,msglen,"ɾ: %s",name);
+        else if(mat_del(name)) snprintf(msg,msglen,"ɾ: %s",name);
+        else snprintf(msg,msglen,"ڱ: %s",name);
+        return 1;
     }
     if(is_cmd_local(cmd,"/let")){
         /* ֧ "/let x= expr"  "/let x expr" */
@@ -646,101 +5673,1556 @@ static int handle_command_local(char* line,char* msg,size_t msglen){
         var_set(name,val); if(strcmp(name,"ans")==0) g_last_result=val;
         snprintf(msg,msglen,"%s = %.15g",name,val); return 1;
     }
-
-    if(is_cmd_local(cmd,"/diff")){
-        /* /diff <expr> <var> <x0> [h] */
-        char e[MAX_LINE], vname[NAME_LEN]; double x0,h=1e-5; char* t;
-        if(!arg){ snprintf(msg,msglen,"÷: /diff <expr> <var> <x0> [h]"); return 1; }
-        /*  exprһհǰ token ܺո֧Ż޿ոʽʵ֣ */
-        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
-        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
-        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <x0>"); return 1; }
-        x0=atof(t);
-        t=strtok(NULL," \t\r\n"); if(t) h=atof(t);
-        {
-            char er[128]; double d = diff_center(e,vname,x0,h,er,sizeof(er));
-            if(!isfinite(d)){ snprintf(msg,msglen,"/diff ʧ: %s",er); }
-            else snprintf(msg,msglen,"d/d%s %s | x=%.6g  %.15g (h=%.1e)",vname,e,x0,d,h);
+
+    if(is_cmd_local(cmd,"/diff")){
+        /* /diff <expr> <var> <x0> [h] [--trace f.csv] */
+        char e[MAX_LINE], vname[NAME_LEN], tfile[MAX_LINE]; double x0,h=1e-5; char* t; int tr;
+        if(!arg){ snprintf(msg,msglen,"÷: /diff <expr> <var> <x0> [h] [--trace f.csv]"); return 1; }
+        tr=take_opt_local(arg,"--trace",tfile,sizeof(tfile));
+        if(tr<0){ snprintf(msg,msglen,"--trace ȱļ"); return 1; }
+        /*  exprһհǰ token ܺո֧Ż޿ոʽʵ֣ */
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <x0>"); return 1; }
+        x0=atof(t);
+        t=strtok(NULL," \t\r\n"); if(t) h=atof(t);
+        {
+            /*  h/2 һΣ|d(h)-d(h/2)|4/3  d(h) Ľض */
+            char er[128], sfx[56]; double d, d2, de;
+            if(!ntrace_begin_local(tr? tfile : NULL)){ snprintf(msg,msglen,"޷д %s",msg_short_local(tfile)); return 1; }
+            d=diff_center(e,vname,x0,h,er,sizeof(er));
+            d2=isfinite(d)? diff_center(e,vname,x0,0.5*h,er,sizeof(er)) : NAN;
+            de=4.0/3.0*fabs(d-d2);
+            ntrace_row_local(1,x0,d,h,NAN);
+            ntrace_row_local(2,x0,d2,0.5*h,de);
+            ntrace_end_local(sfx,sizeof(sfx));
+            if(!isfinite(d)){ snprintf(msg,msglen,"/diff ʧ: %s",er); }
+            else if(isfinite(de)) snprintf(msg,msglen,"d/d%s %s | x=%.6g  %.15g (h=%.1e, %.1e)%s",vname,msg_short_local(e),x0,d,h,de,sfx);
+            else snprintf(msg,msglen,"d/d%s %s | x=%.6g  %.15g (h=%.1e)%s",vname,msg_short_local(e),x0,d,h,sfx);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/solve")){
+        /* /solve <expr> <var> <x0> [maxit tol] [--trace f.csv] */
+        char e[MAX_LINE], vname[NAME_LEN], tfile[MAX_LINE], *t; double x0; int maxit=30, tr; double tol=1e-10;
+        if(!arg){ snprintf(msg,msglen,"÷: /solve <expr> <var> <x0> [maxit tol] [--trace f.csv]"); return 1; }
+        tr=take_opt_local(arg,"--trace",tfile,sizeof(tfile));
+        if(tr<0){ snprintf(msg,msglen,"--trace ȱļ"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <x0>"); return 1; }
+        x0=atof(t);
+        t=strtok(NULL," \t\r\n"); if(t) { maxit=atoi(t); t=strtok(NULL," \t\r\n"); if(t) tol=atof(t); }
+        {
+            char er[128], sfx[56]; double r; int ok;
+            if(!ntrace_begin_local(tr? tfile : NULL)){ snprintf(msg,msglen,"޷д %s",msg_short_local(tfile)); return 1; }
+            ok=solve_newton(e,vname,x0,maxit,tol,&r,er,sizeof(er));
+            ntrace_end_local(sfx,sizeof(sfx));
+            if(ok){ snprintf(msg,msglen,"root %.15g%s",r,sfx); }
+            else snprintf(msg,msglen,"/solve ʧ: %s%s",msg_short_local(er),sfx);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/solvemany")){
+        /* /solvemany <expr> <x> <param> <file|a:b:n> <x0> [maxit tol] [--out f.csv] */
+        char *tok[7], er[128], out_file[MAX_LINE], *t; const char* names[2]; int nt=0, maxit=30;
+        double tol=1e-10, *ps=NULL, *roots; unsigned char* status; long n=0, i; SweepAxis ax; char spec[MAX_LINE];
+        CalcProgram prog; SolveManyStats st;
+        out_file[0]='\0';
+        for(t=arg? strtok(arg," \t\r\n"):NULL; t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--out")==0){
+                t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"--out ȱļ"); return 1; }
+                strncpy(out_file,t,sizeof(out_file)-1); out_file[sizeof(out_file)-1]='\0';
+            }else if(nt<7) tok[nt++]=t;
+        }
+        if(nt<5){ snprintf(msg,msglen,"÷: /solvemany <expr> <x> <param> <file|a:b:n> <x0> [maxit tol] [--out f.csv]"); return 1; }
+        if(nt>5) maxit=atoi(tok[5]);
+        if(nt>6) tol=atof(tok[6]);
+        /* ֵa:b:n Χļÿеһ */
+        snprintf(spec,sizeof(spec),"p=%s",tok[3]);
+        if(strchr(tok[3],':') && sweep_parse_axis(spec,&ax,er,sizeof(er))){
+            if(ax.n>SOLVEMANY_MAX_N){ snprintf(msg,msglen,"/solvemany  %ld ֵ",SOLVEMANY_MAX_N); return 1; }
+            n=ax.n; ps=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n);
+            if(!ps){ snprintf(msg,msglen,"/solvemany ʧ: ڴ治"); return 1; }
+            for(i=0;i<n;++i) ps[i]=sweep_axis_value(&ax,i);
+        }else{
+            FILE* fp=fopen(tok[3],"r"); char line[MAX_LINE]; long cap=0;
+            if(!fp){ snprintf(msg,msglen,"޷ %s",tok[3]); return 1; }
+            while(fgets(line,sizeof(line),fp) && n<SOLVEMANY_MAX_N){
+                char* end; double v=strtod(line,&end);
+                if(end==line) continue;       /* ͷ */
+                if(n>=cap){
+                    long nc=cap? cap*2 : 1024; double* q=(double*)calc_realloc(MEM_ARRAY,ps,sizeof(double)*(size_t)nc);
+                    if(!q){ calc_free(ps); fclose(fp); snprintf(msg,msglen,"/solvemany ʧ: ڴ治"); return 1; }
+                    ps=q; cap=nc;
+                }
+                ps[n++]=v;
+            }
+            fclose(fp);
+            if(n==0){ calc_free(ps); snprintf(msg,msglen,"%s ûֵ",tok[3]); return 1; }
+        }
+        names[0]=tok[1]; names[1]=tok[2];
+        if(!calc_compile(tok[0],names,2,&prog,er,sizeof(er))){ calc_free(ps); snprintf(msg,msglen,"/solvemany ʧ: %s",er); return 1; }
+        roots=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n);
+        status=(unsigned char*)calc_malloc(MEM_ARRAY,(size_t)n);
+        if(!roots||!status){ calc_free(ps); calc_free(roots); calc_free(status); calc_program_free(&prog); snprintf(msg,msglen,"/solvemany ʧ: ڴ治"); return 1; }
+        solvemany_run(&prog,ps,n,atof(tok[4]),maxit,tol,roots,status,&st);
+        calc_program_free(&prog);
+        if(out_file[0]){
+            FILE* fp=fopen(out_file,"w");
+            if(fp){
+                static const char* sn[3]={"fail","newton","brent"};
+                fprintf(fp,"%s,%s,method\n",tok[2],tok[1]);
+                for(i=0;i<n;++i) fprintf(fp,"%.15g,%.15g,%s\n",ps[i],roots[i],sn[status[i]]);
+                fclose(fp);
+            }else out_file[0]='\0';
+        }
+        if(n*2<=MAX_MAT_ELEMS){
+            double* m=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n*2);
+            if(m){
+                for(i=0;i<n;++i){ m[2*i]=ps[i]; m[2*i+1]=roots[i]; }
+                mat_set("roots",(int)n,2,m); calc_free(m);
+            }
+        }
+        calc_free(ps); calc_free(roots); calc_free(status);
+        if(st.n_fail==st.n) snprintf(msg,msglen,"/solvemany: %ld ֵδҵһ x0",st.n);
+        else snprintf(msg,msglen,"%ld : Newton %ld, Brent %ld, ʧ %ld; [%.8g,%.8g] %s%s",st.n,st.n_newton,st.n_brent,st.n_fail,
+                      st.rmin,st.rmax,out_file[0]?"-> ":(n*2<=MAX_MAT_ELEMS?"-> roots":""),out_file);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/track")){
+        /* /track <expr> <x> <param> <p0> <p1> <steps> <x0> [--out f.csv] [--plot] */
+        char *tok[7], er[128], out_file[MAX_LINE], *t; const char* names[2]; int nt=0, plot=0;
+        CalcProgram prog; TrackInfo info; double *ps=NULL, *xs=NULL; FILE* fp=NULL; int ok;
+        out_file[0]='\0';
+        if(!arg){ snprintf(msg,msglen,"÷: /track <expr> <x> <param> <p0> <p1> <steps> <x0> [--out f.csv] [--plot]"); return 1; }
+        for(t=strtok(arg," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--plot")==0) plot=1;
+            else if(strcmp(t,"--out")==0){
+                t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"--out ȱļ"); return 1; }
+                strncpy(out_file,t,sizeof(out_file)-1); out_file[sizeof(out_file)-1]='\0';
+            }else if(nt<7) tok[nt++]=t;
+        }
+        if(nt!=7){ snprintf(msg,msglen,"÷: /track <expr> <x> <param> <p0> <p1> <steps> <x0> [--out f.csv] [--plot]"); return 1; }
+        if(atof(tok[3])==atof(tok[4])){ snprintf(msg,msglen,"/track Ҫ p0!=p1"); return 1; }
+        names[0]=tok[1]; names[1]=tok[2];
+        if(!calc_compile(tok[0],names,2,&prog,er,sizeof(er))){ snprintf(msg,msglen,"/track ʧ: %s",er); return 1; }
+        if(out_file[0] && !(fp=fopen(out_file,"w"))){ calc_program_free(&prog); snprintf(msg,msglen,"޷д %s",out_file); return 1; }
+        ok=track_run(&prog,atof(tok[3]),atof(tok[4]),atoi(tok[5]),atof(tok[6]),fp,&ps,&xs,&info,er,sizeof(er));
+        calc_program_free(&prog);
+        if(fp) fclose(fp);
+        if(!ok){ snprintf(msg,msglen,"/track ʧ: %s",er); return 1; }
+        if(info.npts*2<=MAX_MAT_ELEMS){
+            double* m=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)info.npts*2); int i;
+            if(m){
+                for(i=0;i<info.npts;++i){ m[2*i]=ps[i]; m[2*i+1]=xs[i]; }
+                mat_set("track",info.npts,2,m);
+                calc_free(m);
+            }
+        }
+        if(plot){ clear_screen(); plot_ascii_data(ps,xs,info.npts,70,20); printf("\nس..."); wait_enter_local(); }
+        calc_free(ps); calc_free(xs);
+        if(info.nturn>0)
+            snprintf(msg,msglen,"%d , %d յ(׸ %s%.8g, %s%.8g), յ %s=%.6g %s=%.12g",info.npts,info.nturn,
+                     tok[2],info.turn_p[0],tok[1],info.turn_x[0],tok[2],info.p_end,tok[1],info.x_end);
+        else
+            snprintf(msg,msglen,"%d , %ld ֵ, յ %s=%.6g ʱ %s=%.15g",info.npts,info.nevals,tok[2],info.p_end,tok[1],info.x_end);
+        if(info.reached){ g_last_result=info.x_end; var_set("ans",g_last_result); }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/integ")){
+        /* /integ <expr> <var> <a> <b> [n|auto] [--trace f.csv]Ĭ Simpson n=200auto ʱӦ GaussCKronrod */
+        char e[MAX_LINE], vname[NAME_LEN], tfile[MAX_LINE], sfx[56], *t; double a,b; int n=200, nset=0, adapt=0, tr; char er[128]; double val;
+        if(!arg){ snprintf(msg,msglen,"÷: /integ <expr> <var> <a> <b> [n|auto] [--trace f.csv]"); return 1; }
+        tr=take_opt_local(arg,"--trace",tfile,sizeof(tfile));
+        if(tr<0){ snprintf(msg,msglen,"--trace ȱļ"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <a>"); return 1; }
+        a=(strcmp(t,"-inf")==0)? -HUGE_VAL : ((strcmp(t,"inf")==0)? HUGE_VAL : atof(t));
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <b>"); return 1; }
+        b=(strcmp(t,"-inf")==0)? -HUGE_VAL : ((strcmp(t,"inf")==0)? HUGE_VAL : atof(t));
+        t=strtok(NULL," \t\r\n");
+        if(t && strcmp(t,"auto")==0) adapt=1;
+        else if(t){ n=atoi(t); nset=1; }
+        if(!isfinite(a) || !isfinite(b)){
+            if(nset){ snprintf(msg,msglen,"Simpson Ҫ޻ޣȥ n  auto ʹӦ֣"); return 1; }
+            adapt=1;
+        }
+        if(!ntrace_begin_local(tr? tfile : NULL)){ snprintf(msg,msglen,"޷д %s",msg_short_local(tfile)); return 1; }
+        if(g_prec==PREC_DD && !nset && isfinite(a) && isfinite(b)){
+            double errest; long nev; CalcDD r; char buf[64]; int ok=integ_tanhsinh_dd(e,vname,a,b,&r,&errest,&nev,er,sizeof(er));
+            ntrace_end_local(sfx,sizeof(sfx));
+            if(ok){
+                g_last_result=r.hi; g_last_dd=r; g_last_dd_lossy=g_dd_lossy; var_set("ans",g_last_result);
+                dd_format_local(r,g_dd_lossy? 17 : 32,buf,sizeof(buf));
+                if(errest>1e-20*(fabs(r.hi)>1.0? fabs(r.hi) : 1.0))
+                    snprintf(msg,msglen,"/integ(DD) δ:  %.15g, %.1e%s",r.hi,errest,sfx);
+                else snprintf(msg,msglen,"  %s (DD tanh-sinh, %.0e)%s",buf,errest,sfx);
+            }else snprintf(msg,msglen,"/integ ʧ: %s",er);
+        }else if(adapt){
+            double errest; long nev; int ok=integ_adaptive(e,vname,a,b,&val,&errest,&nev,er,sizeof(er));
+            ntrace_end_local(sfx,sizeof(sfx));
+            if(ok){
+                g_last_result=val; var_set("ans",g_last_result);
+                snprintf(msg,msglen,"[%g,%g] %s d%s  %.15g (%.1e)%s",a,b,msg_short_local(e),vname,val,errest,sfx);
+            }else snprintf(msg,msglen,"/integ ʧ: %s",er);
+        }else{
+            double errest; int ok=integ_simpson(e,vname,a,b,n,&val,&errest,er,sizeof(er));
+            ntrace_end_local(sfx,sizeof(sfx));
+            if(!ok) snprintf(msg,msglen,"/integ ʧ: %s",er);
+            else{
+                g_last_result=val; var_set("ans",g_last_result);
+                if(isfinite(errest)) snprintf(msg,msglen,"[%g,%g] %s d%s  %.15g (n=%d, %.1e)%s",a,b,msg_short_local(e),vname,val,n,errest,sfx);
+                else snprintf(msg,msglen,"[%g,%g] %s d%s  %.15g (n=%d)%s",a,b,msg_short_local(e),vname,val,n,sfx);
+            }
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/integn")){
+        /* /integn <expr> x,y,.. a:b,c:d,.. [N] [--gm|--qmc|--halton] [--tol t] [--seed s] */
+        char e[MAX_LINE], er[128], vl[MAX_LINE], bl[MAX_LINE], *t, *p, *q;
+        char names_buf[MAX_BIND][NAME_LEN]; const char* names[MAX_BIND];
+        double lo[MAX_BIND], hi[MAX_BIND], tol=1e-8, N=0;
+        int nt=0, dim=0, nb=0, method=0, ok; calc_u64 seed=RNG_DEFAULT_SEED;   /* method: 0 Զ 1 gm 2 sobol 3 halton */
+        CalcProgram prog; IntegnResult res; size_t L;
+        if(!arg){ snprintf(msg,msglen,"÷: /integn <expr> x,y a:b,c:d [N] [--gm|--qmc|--halton] [--tol t]"); return 1; }
+        for(t=strtok(arg," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--gm")==0) method=1;
+            else if(strcmp(t,"--qmc")==0) method=2;
+            else if(strcmp(t,"--halton")==0) method=3;
+            else if(strcmp(t,"--tol")==0 || strcmp(t,"--seed")==0){
+                int is_tol=(t[2]=='t');
+                t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ѡȱֵ"); return 1; }
+                if(is_tol) tol=atof(t); else seed=(calc_u64)strtoul(t,NULL,10);
+            }else if(nt==0){ strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0'; nt++; }
+            else if(nt==1){ strncpy(vl,t,sizeof(vl)-1); vl[sizeof(vl)-1]='\0'; nt++; }
+            else if(nt==2){ strncpy(bl,t,sizeof(bl)-1); bl[sizeof(bl)-1]='\0'; nt++; }
+            else N=atof(t);
+        }
+        if(nt<3){ snprintf(msg,msglen,"÷: /integn <expr> x,y a:b,c:d [N] [--gm|--qmc|--halton] [--tol t]"); return 1; }
+        for(p=vl; p && *p; p=q){
+            q=strchr(p,','); if(q) *q++='\0';
+            if(dim>=MAX_BIND){ snprintf(msg,msglen,"/integn  %d ά",MAX_BIND); return 1; }
+            L=strlen(p); if(L==0 || L>=NAME_LEN){ snprintf(msg,msglen,"/integn: Ƿ1~%d ַ",NAME_LEN-1); return 1; }
+            memcpy(names_buf[dim],p,L+1);
+            names[dim]=names_buf[dim]; dim++;
+        }
+        for(p=bl; p && *p; p=q){
+            char* c;
+            q=strchr(p,','); if(q) *q++='\0';
+            c=strchr(p,':');
+            if(!c || nb>=MAX_BIND){ snprintf(msg,msglen,"޸ʽӦΪ a:b,c:d,..."); return 1; }
+            lo[nb]=atof(p); hi[nb]=atof(c+1); nb++;
+        }
+        if(dim==0 || nb!=dim){ snprintf(msg,msglen,"/integn: %d  %d ",dim,nb); return 1; }
+        for(nb=0;nb<dim;++nb) if(!(hi[nb]>lo[nb])){ snprintf(msg,msglen,"/integn: %s Ļ a<b",names[nb]); return 1; }
+        if(method==0) method=(dim>=2 && dim<=INTEGN_GM_AUTO_DIM)? 1 : 2;
+        if(method==1 && dim<2){ snprintf(msg,msglen,"һά /integ  --qmc"); return 1; }
+        if(!calc_compile(e,names,dim,&prog,er,sizeof(er))){ snprintf(msg,msglen,"/integn ʧ: %s",er); return 1; }
+        if(method==1) ok=integn_gm(&prog,dim,lo,hi,tol,1e-14,N>0? (long)N : GM_DEFAULT_MAXEVAL,&res,er,sizeof(er));
+        else ok=integn_qmc(&prog,dim,lo,hi,N>0? (long)N : QMC_DEFAULT_N,method==3,seed,&res,er,sizeof(er));
+        calc_program_free(&prog);
+        if(!ok){ snprintf(msg,msglen,"/integn ʧ: %s",er); return 1; }
+        g_last_result=res.val; var_set("ans",g_last_result);
+        snprintf(msg,msglen," %s  %.15g (%.1e, %ld , %s)",msg_short_local(e),res.val,res.err,res.nevals,
+                 method==1? "GenzCMalik" : (method==3? "Halton+ƽ" : "Sobol+λ"));
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/sum")){
+        /* /sum <expr> <k> <a> <b>b Ϊ inf */
+        char e[MAX_LINE], vname[NAME_LEN], *t, er[128]; double a,b=0.0,val; int inf=0;
+        if(!arg){ snprintf(msg,msglen,"÷: /sum <expr> <k> <a> <b|inf>"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <k>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <a>"); return 1; }
+        a=atof(t);
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <b>"); return 1; }
+        if(strcmp(t,"inf")==0 || strcmp(t,"+inf")==0) inf=1; else b=atof(t);
+        if(!nearly_integer_local(a) || (!inf && !nearly_integer_local(b))){ snprintf(msg,msglen,"/sum Ϊ"); return 1; }
+        a=round_local(a); b=round_local(b);
+        if(inf){
+            double errest; int nt; const char* method;
+            if(sum_infinite(e,vname,a,&val,&errest,&nt,&method,er,sizeof(er))){
+                if(errest>1e-8*(fabs(val)>1.0? fabs(val) : 1.0))
+                    snprintf(msg,msglen,"/sum δ(ܷɢ):  %.10g, %.1e (%s)",val,errest,method);
+                else snprintf(msg,msglen,"[%s=%g..inf] %s  %.15g (%s, %d , %.1e)",vname,a,msg_short_local(e),val,method,nt,errest);
+            }else snprintf(msg,msglen,"/sum ʧ: %s",er);
+        }else{
+            if(b<a){ snprintf(msg,msglen,"/sum Ҫ a<=b"); return 1; }
+            if(g_exact){
+                CalcRat r; int inx=0; char pre[NAME_LEN+64];
+                rat_init(&r);
+                if(!sum_finite_exact(e,vname,a,b,&r,&inx,er,sizeof(er))){ snprintf(msg,msglen,"/sum ʧ: %s",er); return 1; }
+                if(!inx){
+                    snprintf(pre,sizeof(pre),"[%s=%g..%g] = ",vname,a,b);
+                    rat_result_msg_local(pre,&r,msg,msglen);
+                    g_last_result=rat_to_double(&r); var_set("ans",g_last_result);
+                    rat_free(&g_last_rat); g_last_rat=r; g_last_rat_ok=1;
+                    return 1;
+                }
+                /* Ǿȷ double/˫˫· */
+            }
+            if(g_prec==PREC_DD){
+                CalcDD r; char buf[64];
+                if(sum_finite_dd(e,vname,a,b,&r,er,sizeof(er))){
+                    g_last_result=r.hi; g_last_dd=r; g_last_dd_lossy=g_dd_lossy; var_set("ans",g_last_result);
+                    dd_format_local(r,g_dd_lossy? 17 : 32,buf,sizeof(buf));
+                    snprintf(msg,msglen,"[%s=%g..%g] = %s (DD)",vname,a,b,buf);
+                }else snprintf(msg,msglen,"/sum ʧ: %s",er);
+            }else if(sum_finite(e,vname,a,b,&val,er,sizeof(er)))
+                snprintf(msg,msglen,"[%s=%g..%g] %s = %.15g",vname,a,b,msg_short_local(e),val);
+            else snprintf(msg,msglen,"/sum ʧ: %s",er);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/prod")){
+        /* /prod <expr> <k> <a> <b> */
+        char e[MAX_LINE], vname[NAME_LEN], *t, er[128]; double a,b,la; int sg;
+        if(!arg){ snprintf(msg,msglen,"÷: /prod <expr> <k> <a> <b>"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <k>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <a>"); return 1; }
+        a=atof(t);
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <b>"); return 1; }
+        b=atof(t);
+        if(!nearly_integer_local(a) || !nearly_integer_local(b) || b<a){ snprintf(msg,msglen,"/prod Ϊ a<=b"); return 1; }
+        a=round_local(a); b=round_local(b);
+        if(!prod_finite(e,vname,a,b,&la,&sg,er,sizeof(er))){ snprintf(msg,msglen,"/prod ʧ: %s",er); return 1; }
+        if(sg==0) snprintf(msg,msglen,"[%s=%g..%g] %s = 0 ()",vname,a,b,msg_short_local(e));
+        else if(fabs(la)<700.0) snprintf(msg,msglen,"[%s=%g..%g] %s = %.15g",vname,a,b,msg_short_local(e),sg*exp(la));
+        else{
+            /*  double Χ m10^E ʾ */
+            double l10=la/log(10.0), ex=floor(l10);
+            snprintf(msg,msglen,"[%s=%g..%g] %s = %s%.12ge%+.0f",vname,a,b,msg_short_local(e),(sg<0)?"-":"",pow(10.0,l10-ex),ex);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/limit")){
+        /* /limit <expr> <var> <point|inf|-inf> [+|-] */
+        char e[MAX_LINE], vname[NAME_LEN], *t, er[128]; double pt=0.0, vp=0.0, ep=0.0, vm=0.0, em2=0.0;
+        int inf=0, side=0, okp=1, okm=1; CalcProgram prog; const char* names[1];
+        if(!arg){ snprintf(msg,msglen,"÷: /limit <expr> <var> <point|inf|-inf> [+|-]"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <point>"); return 1; }
+        if(strcmp(t,"inf")==0 || strcmp(t,"+inf")==0) inf=1;
+        else if(strcmp(t,"-inf")==0) inf=-1;
+        else pt=atof(t);
+        t=strtok(NULL," \t\r\n");
+        if(t){ if(strcmp(t,"+")==0) side=1; else if(strcmp(t,"-")==0) side=-1; else { snprintf(msg,msglen,"Ϊ +  -"); return 1; } }
+        names[0]=vname;
+        if(!calc_compile(e,names,1,&prog,er,sizeof(er))){ snprintf(msg,msglen,"/limit ʧ: %s",er); return 1; }
+        if(inf || side>=0) okp=limit_side(&prog,pt,inf,1,&vp,&ep,er,sizeof(er));
+        if(!inf && side<=0 && okp) okm=limit_side(&prog,pt,0,-1,&vm,&em2,er,sizeof(er));
+        calc_program_free(&prog);
+        if(!okp || !okm){ snprintf(msg,msglen,"/limit ʧ: %s",er); return 1; }
+        if(!inf && side==0){
+            double tol=1e-6*(fabs(vp)>1.0? fabs(vp) : 1.0);
+            if(ep>tol || em2>tol || fabs(vp-vm)>tol+ep+em2){
+                snprintf(msg,msglen,"/limit: Ҽ޲һ»򲻴 (%s->%g-: %.10g, +: %.10g)",vname,pt,vm,vp);
+                return 1;
+            }
+            vp=0.5*(vp+vm); ep=(ep>em2)? ep : em2;
+        }else if(side<0){ vp=vm; ep=em2; }
+        if(ep>1e-6*(fabs(vp)>1.0? fabs(vp) : 1.0)) snprintf(msg,msglen,"/limit: ޿ܲ ( %.10g, %.1e)",vp,ep);
+        else if(inf) snprintf(msg,msglen,"lim %s->%s %s  %.15g (%.1e)",vname,inf>0?"+inf":"-inf",msg_short_local(e),vp,ep);
+        else snprintf(msg,msglen,"lim %s->%g%s %s  %.15g (%.1e)",vname,pt,side>0?"+":(side<0?"-":""),msg_short_local(e),vp,ep);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/plot")){
+        /* /plot <expr> <var> <xmin> <xmax> [W H] [--f32] */
+        char e[MAX_LINE], vname[NAME_LEN], *t; double xmin,xmax; int W=60,H=20, opts=batch_opts_local(arg);
+        if(!arg){ snprintf(msg,msglen,"÷: /plot <expr> <var> <xmin> <xmax> [W H] [--f32]"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
+        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <xmin>"); return 1; }
+        xmin=atof(t);
+        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <xmax>"); return 1; }
+        xmax=atof(t);
+        t=strtok(NULL," \t\r\n"); if(t){ W=atoi(t); t=strtok(NULL," \t\r\n"); if(t) H=atoi(t); }
+        {
+            char er[128];
+            if(!plot_ascii(e,vname,xmin,xmax,W,H,opts,er,sizeof(er))){ snprintf(msg,msglen,"/plot ʧ: %s",er); return 1; }
+        }
+        snprintf(msg,msglen,"ѻͼ%s, %s[%.6g,%.6g], %dx%d",msg_short_local(e),vname,xmin,xmax,W,H);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/sweep")){
+        /* /sweep <expr> v=a:b:n [v2=a:b:n ...] [--out file.csv] [--plot] [--f32] */
+        char e[MAX_LINE], er[128], out_file[MAX_LINE], pos[2][96], *t; SweepAxis ax[SWEEP_MAX_DIMS];
+        int nax=0, plot=0, d, w, opts=batch_opts_local(arg); FILE* fp=NULL; HeatMap hm; SweepStats st;
+        out_file[0]='\0';
+        if(!arg){ snprintf(msg,msglen,"÷: /sweep <expr> x=a:b:n [y=a:b:n ...] [--out f.csv] [--plot] [--f32]"); return 1; }
+        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
+        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
+        for(t=strtok(NULL," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--plot")==0) plot=1;
+            else if(strcmp(t,"--out")==0){
+                t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"--out ȱļ"); return 1; }
+                strncpy(out_file,t,sizeof(out_file)-1); out_file[sizeof(out_file)-1]='\0';
+            }else{
+                if(nax>=SWEEP_MAX_DIMS){ snprintf(msg,msglen,"/sweep  %d ",SWEEP_MAX_DIMS); return 1; }
+                if(!sweep_parse_axis(t,&ax[nax],er,sizeof(er))){ snprintf(msg,msglen,"/sweep: %s",er); return 1; }
+                nax++;
+            }
+        }
+        if(nax==0){ snprintf(msg,msglen,"/sweep ҪһΧ var=a:b:n"); return 1; }
+        if(plot && nax!=2){ snprintf(msg,msglen,"/sweep --plot ֶ֧άɨ"); return 1; }
+        if(plot && !heat_init(&hm,70,20,ax[0].a<ax[0].b?ax[0].a:ax[0].b,ax[0].a<ax[0].b?ax[0].b:ax[0].a,
+                              ax[1].a<ax[1].b?ax[1].a:ax[1].b,ax[1].a<ax[1].b?ax[1].b:ax[1].a)){
+            snprintf(msg,msglen,"/sweep ʧ: ڴ治"); return 1;
+        }
+        if(out_file[0]){
+            fp=fopen(out_file,"w");
+            if(!fp){ if(plot) heat_free(&hm); snprintf(msg,msglen,"޷д %s",out_file); return 1; }
+        }
+        if(!sweep_run(e,ax,nax,fp,plot?&hm:NULL,&st,opts,er,sizeof(er))){
+            if(fp) fclose(fp);
+            if(plot) heat_free(&hm);
+            snprintf(msg,msglen,"/sweep ʧ: %s",er); return 1;
+        }
+        if(fp) fclose(fp);
+        if(plot){
+            clear_screen(); heat_print(&hm,ax[0].name,ax[1].name); heat_free(&hm);
+            printf("\nس..."); wait_enter_local();
+        }
+        if(st.nbad==st.npts){ snprintf(msg,msglen,"/sweep: %ld ֵʧ",st.npts); return 1; }
+        /* д (a,b,..) */
+        for(w=0;w<2;++w){
+            const double* arg_=w? st.argmax : st.argmin; size_t p=0;
+            pos[w][0]='\0';
+            for(d=0;d<nax && p<sizeof(pos[w]);++d){
+                int r=snprintf(pos[w]+p,sizeof(pos[w])-p,"%s%.6g",d?",":"",arg_[d]);
+                if(r<0) break;
+                p+=(size_t)r;
+            }
+        }
+        snprintf(msg,msglen,"%ld : min=%.10g @(%s) max=%.10g @(%s)%s%s",
+                 st.npts,st.vmin,pos[0],st.vmax,pos[1],out_file[0]?" -> ":"",out_file);
+        if(st.nbad>0){
+            size_t l=strlen(msg);
+            if(l<msglen) snprintf(msg+l,msglen-l," ʧ %ld ",st.nbad);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/plot2d")){
+        /* /plot2d <expr> <x> <a> <b> <y> <c> <d> [W H] [--f32]    /plot2d <file.csv> [W H] */
+        char *tok[9], er[128], *t; int nt=0, W=70, H=20, opts=batch_opts_local(arg);
+        if(!arg){ snprintf(msg,msglen,"÷: /plot2d <expr> <x> <a> <b> <y> <c> <d> [W H]  /plot2d <file.csv> [W H]"); return 1; }
+        for(t=strtok(arg," \t\r\n"); t && nt<9; t=strtok(NULL," \t\r\n")) tok[nt++]=t;
+        if(nt==1 || nt==3){
+            if(nt==3){ W=atoi(tok[1]); H=atoi(tok[2]); }
+            clear_screen();
+            if(!plot2d_csv(tok[0],W,H,er,sizeof(er))){ snprintf(msg,msglen,"/plot2d ʧ: %s",er); return 1; }
+            printf("\nس..."); wait_enter_local();
+            snprintf(msg,msglen,"ѻͼ%s",tok[0]);
+            return 1;
+        }
+        if(nt!=7 && nt!=9){ snprintf(msg,msglen,"÷: /plot2d <expr> <x> <a> <b> <y> <c> <d> [W H]"); return 1; }
+        if(nt==9){ W=atoi(tok[7]); H=atoi(tok[8]); }
+        {
+            SweepAxis ax[2]; HeatMap hm; SweepStats st;
+            double a=atof(tok[2]), b=atof(tok[3]), c=atof(tok[5]), dd=atof(tok[6]);
+            if(!(b>a) || !(dd>c)){ snprintf(msg,msglen,"/plot2d Ҫ a<b  c<d"); return 1; }
+            if(!heat_init(&hm,W,H,a,b,c,dd)){ snprintf(msg,msglen,"/plot2d ʧ: ڴ治"); return 1; }
+            /* ÿһ */
+            strncpy(ax[0].name,tok[1],NAME_LEN-1); ax[0].name[NAME_LEN-1]='\0';
+            strncpy(ax[1].name,tok[4],NAME_LEN-1); ax[1].name[NAME_LEN-1]='\0';
+            ax[0].a=a; ax[0].b=b; ax[0].n=hm.W;
+            ax[1].a=c; ax[1].b=dd; ax[1].n=hm.H;
+            if(!sweep_run(tok[0],ax,2,NULL,&hm,&st,opts,er,sizeof(er))){ heat_free(&hm); snprintf(msg,msglen,"/plot2d ʧ: %s",er); return 1; }
+            clear_screen(); heat_print(&hm,ax[0].name,ax[1].name); heat_free(&hm);
+            printf("\nس..."); wait_enter_local();
+            snprintf(msg,msglen,"ѻͼ%s, %dx%d",tok[0],W,H);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/mat")){
+        /* /mat гȫ/mat A ʾ/mat A=[1,2;3,4]  /mat A [1,2;3,4]  */
+        char *p=arg, *br; char name[NAME_LEN], er[128]; int r,c; size_t L;
+        static double buf[MAX_MAT_ELEMS];
+        if(!p){ clear_screen(); mat_list(); printf("\nس..."); wait_enter_local(); msg[0]='\0'; return 1; }
+        trim_spaces(p);
+        br=strchr(p,'[');
+        if(!br){
+            MatItem* m=mat_get(p);
+            if(!m){ snprintf(msg,msglen,"ھ: %s",p); return 1; }
+            clear_screen(); mat_print(m); printf("\nس..."); wait_enter_local(); msg[0]='\0'; return 1;
+        }
+        *br='\0'; trim_spaces(p);
+        L=strlen(p); if(L>0 && p[L-1]=='='){ p[--L]='\0'; trim_spaces(p); L=strlen(p); }
+        if(L==0||L>=NAME_LEN){ snprintf(msg,msglen,"Ƿ"); return 1; }
+        strncpy(name,p,NAME_LEN-1); name[NAME_LEN-1]='\0';
+        *br='[';
+        if(!mat_parse_local(br,buf,MAX_MAT_ELEMS,&r,&c,er,sizeof(er))){ snprintf(msg,msglen,"/mat ʧ: %s",er); return 1; }
+        if(!mat_set(name,r,c,buf)){ snprintf(msg,msglen,"/mat ʧ: ڴ治"); return 1; }
+        snprintf(msg,msglen,"%s = %dx%d ",name,r,c);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/eig")){
+        /* /eig <A> [w V]Գƾֵ򣩴 wд V */
+        char *t, wname[NAME_LEN]="eig_w", vname[NAME_LEN]="eig_v", er[128];
+        MatItem* m; double *w, *v; int n,i,j;
+        if(!arg){ snprintf(msg,msglen,"÷: /eig <A> [w V]"); return 1; }
+        t=strtok(arg," \t\r\n");
+        m=t? mat_get(t) : NULL;
+        if(!m){ snprintf(msg,msglen,"ھ: %s",t?t:""); return 1; }
+        t=strtok(NULL," \t\r\n"); if(t){ strncpy(wname,t,NAME_LEN-1); wname[NAME_LEN-1]='\0';
+            t=strtok(NULL," \t\r\n"); if(t){ strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0'; } }
+        n=m->rows;
+        if(m->cols!=n){ snprintf(msg,msglen,"/eig Ҫ (%s Ϊ %dx%d)",m->name,m->rows,m->cols); return 1; }
+        for(i=0;i<n;++i) for(j=i+1;j<n;++j){
+            double x=m->a[i*n+j], y=m->a[j*n+i];
+            if(fabs(x-y) > 1e-12*(fabs(x)+fabs(y)+1.0)){ snprintf(msg,msglen,"/eig ֶ֧Գƾ (a[%d][%d]!=a[%d][%d])",i+1,j+1,j+1,i+1); return 1; }
+        }
+        w=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n);
+        v=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)n*(size_t)n);
+        if(!w||!v){ calc_free(w); calc_free(v); snprintf(msg,msglen,"ڴ治"); return 1; }
+        if(!mat_eig_sym(n,m->a,w,v,er,sizeof(er))) snprintf(msg,msglen,"/eig ʧ: %s",er);
+        else if(!mat_set(wname,n,1,w) || !mat_set(vname,n,n,v)) snprintf(msg,msglen,"/eig ʧ: ");
+        else if(n==1) snprintf(msg,msglen,"eig: w=[%.8g] -> %s,%s",w[0],wname,vname);
+        else snprintf(msg,msglen,"eig: w=[%.8g .. %.8g] (%d ) -> %s,%s",w[0],w[n-1],n,wname,vname);
+        calc_free(w); calc_free(v);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/svd")){
+        /* /svd <A> [U S V]A = Udiag(S)V^TS  */
+        char *t, un[NAME_LEN]="svd_u", sn[NAME_LEN]="svd_s", vn[NAME_LEN]="svd_v", er[128];
+        MatItem* m; double *u,*s,*v; int r,c,k;
+        if(!arg){ snprintf(msg,msglen,"÷: /svd <A> [U S V]"); return 1; }
+        t=strtok(arg," \t\r\n");
+        m=t? mat_get(t) : NULL;
+        if(!m){ snprintf(msg,msglen,"ھ: %s",t?t:""); return 1; }
+        t=strtok(NULL," \t\r\n"); if(t){ strncpy(un,t,NAME_LEN-1); un[NAME_LEN-1]='\0';
+            t=strtok(NULL," \t\r\n"); if(t){ strncpy(sn,t,NAME_LEN-1); sn[NAME_LEN-1]='\0';
+                t=strtok(NULL," \t\r\n"); if(t){ strncpy(vn,t,NAME_LEN-1); vn[NAME_LEN-1]='\0'; } } }
+        r=m->rows; c=m->cols; k=(r<c)?r:c;
+        u=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)r*(size_t)k);
+        s=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)k);
+        v=(double*)calc_malloc(MEM_ARRAY,sizeof(double)*(size_t)c*(size_t)k);
+        if(!u||!s||!v){ calc_free(u); calc_free(s); calc_free(v); snprintf(msg,msglen,"ڴ治"); return 1; }
+        if(!mat_svd(r,c,m->a,u,s,v,er,sizeof(er))) snprintf(msg,msglen,"/svd ʧ: %s",er);
+        else if(!mat_set(un,r,k,u) || !mat_set(sn,k,1,s) || !mat_set(vn,c,k,v)) snprintf(msg,msglen,"/svd ʧ: ");
+        else snprintf(msg,msglen,"svd: s=[%.8g .. %.8g] cond=%.6g -> %s,%s,%s",s[0],s[k-1],(s[k-1]>0)?s[0]/s[k-1]:HUGE_VAL,un,sn,vn);
+        calc_free(u); calc_free(s); calc_free(v);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/fft")){
+        /* /fft <expr> <var> <a> <b> <N> [--plot] [a,b) ϵȾ N 
+         * /fft <vector> [--plot]ло󣩱任 */
+        char e[MAX_LINE], vname[NAME_LEN], *t, *tok[6], er[128]; int nt=0, plot=0, n, k;
+        CalcCplx* in; MatItem* m;
+        k=0;
+        if(!arg){ snprintf(msg,msglen,"÷: /fft <expr> <var> <a> <b> <N> [--plot]  /fft <vector> [--plot]"); return 1; }
+        for(t=strtok(arg," \t\r\n"); t; t=strtok(NULL," \t\r\n")){
+            if(strcmp(t,"--plot")==0) plot=1;
+            else if(nt<6) tok[nt++]=t;
+        }
+        if(nt==1){
+            m=mat_get(tok[0]);
+            if(!m){ snprintf(msg,msglen,"ھ: %s",tok[0]); return 1; }
+            if(m->rows!=1 && m->cols!=1){ snprintf(msg,msglen,"/fft Ҫ (%s Ϊ %dx%d)",m->name,m->rows,m->cols); return 1; }
+            n=m->rows*m->cols;
+            in=(CalcCplx*)calc_malloc(MEM_ARRAY,sizeof(CalcCplx)*(size_t)n);
+            if(!in){ snprintf(msg,msglen,"/fft ʧ: ڴ治"); return 1; }
+            for(k=0;k<n;++k){ in[k].re=m->a[k]; in[k].im=0.0; }
+            fft_spectrum_local(in,n,1.0,plot,msg,msglen);
+            calc_free(in);
+            return 1;
+        }
+        if(nt!=5){ snprintf(msg,msglen,"÷: /fft <expr> <var> <a> <b> <N> [--plot]"); return 1; }
+        strncpy(e,tok[0],sizeof(e)-1); e[sizeof(e)-1]='\0';
+        strncpy(vname,tok[1],NAME_LEN-1); vname[NAME_LEN-1]='\0';
+        {
+            double a=atof(tok[2]), b=atof(tok[3]), xs[CALC_LANES], ys[CALC_LANES];
+            const char* names[1]; const double* ins[1]; CalcProgram prog; int base, cnt;
+            n=atoi(tok[4]);
+            if(n<2 || n>FFT_MAX_N || !(b>a)){ snprintf(msg,msglen,"/fft Ҫ a<b  N  [2,%d]",FFT_MAX_N); return 1; }
+            names[0]=vname; ins[0]=xs;
+            if(!calc_compile(e,names,1,&prog,er,sizeof(er))){ snprintf(msg,msglen,"/fft ʧ: %s",er); return 1; }
+            in=(CalcCplx*)calc_malloc(MEM_ARRAY,sizeof(CalcCplx)*(size_t)n);
+            if(!in){ calc_program_free(&prog); snprintf(msg,msglen,"/fft ʧ: ڴ治"); return 1; }
+            for(base=0;base<n;base+=CALC_LANES){
+                cnt=n-base; if(cnt>CALC_LANES) cnt=CALC_LANES;
+                for(k=0;k<cnt;++k) xs[k]=a+(b-a)*(double)(base+k)/n;
+                calc_eval_batch(&prog,ins,cnt,ys);
+                for(k=0;k<cnt;++k){
+                    if(!isfinite(ys[k])) break;
+                    in[base+k].re=ys[k]; in[base+k].im=0.0;
+                }
+                if(k<cnt) break;
+            }
+            calc_program_free(&prog);
+            if(base<n) snprintf(msg,msglen,"/fft ʧ: %s=%.6g ֵʧ",vname,xs[k]);
+            else fft_spectrum_local(in,n,1.0/(b-a),plot,msg,msglen);
+            calc_free(in);
+        }
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/hex") || is_cmd_local(cmd,"/oct") || is_cmd_local(cmd,"/bin") || is_cmd_local(cmd,"/base")){
+        /* /hex|/oct|/bin <expr> [--out f]/base <2..36> <expr> [--out f]ʽȷֵ
+         * Ϊλֻܾȷƣ̽ʾУʾдļ */
+        char er[128], out_file[MAX_LINE], *e=arg, *p, *s; const char* pre; ExVal v; clock_t t0; double ms;
+        int base=is_cmd_local(cmd,"/hex")? 16 : is_cmd_local(cmd,"/oct")? 8 : is_cmd_local(cmd,"/bin")? 2 : 0;
+        out_file[0]='\0';
+        if(e && (p=strstr(e,"--out"))!=NULL && (p==e || p[-1]==' ' || p[-1]=='\t')){
+            if(sscanf(p+5,"%511s",out_file)!=1){ snprintf(msg,msglen,"--out ȱļ"); return 1; }
+            *p='\0';
+        }
+        if(e && !base){ base=(int)strtol(e,&e,10); if(base<2 || base>36){ base=0; e=NULL; } }
+        if(e) trim_spaces(e);
+        if(!e || !e[0]){
+            if(base) snprintf(msg,msglen,"÷: %s <ʽ> [--out ļ]",cmd);
+            else snprintf(msg,msglen,"÷: /base <2..36> <ʽ> [--out ļ]");
+            return 1;
+        }
+        if(!eval_expr_exact_local(e,&v,er,sizeof(er))){ snprintf(msg,msglen,"%s ʧ: %s",cmd,er); return 1; }
+        if(!v.exact || !rat_is_int(&v.q)){ ex_free_local(&v); snprintf(msg,msglen,"%s Ҫ floor/round ȡ",cmd); return 1; }
+        t0=clock(); s=big_to_base(&v.q.num,base); ms=1000.0*(double)(clock()-t0)/CLOCKS_PER_SEC;
+        pre=(base==16)? "0x" : (base==8)? "0o" : (base==2)? "0b" : "";
+        if(!s) snprintf(msg,msglen,"%s ʧ: ڴ治",cmd);
+        else if(out_file[0]){
+            FILE* fp=fopen(out_file,"w");
+            if(!fp) snprintf(msg,msglen,"޷д %s",out_file);
+            else{
+                fprintf(fp,"%s%s%s\n",v.q.neg? "-" : "",pre,s); fclose(fp);
+                snprintf(msg,msglen,"д %s%lu λ %d ƣת %.1f ms",out_file,(unsigned long)strlen(s),base,ms);
+            }
+        }else if(strlen(s)<=48){
+            if(pre[0]) snprintf(msg,msglen,"%s%s%s",v.q.neg? "-" : "",pre,s);
+            else snprintf(msg,msglen,"%s%s (%d )",v.q.neg? "-" : "",s,base);
+        }else{
+            clear_screen(); printf("%s%s%s\n",v.q.neg? "-" : "",pre,s);
+            printf("\n%lu λ %d ƣת %.1f ms\n",(unsigned long)strlen(s),base,ms);
+            printf("\nس..."); wait_enter_local();
+            msg[0]='\0';
+        }
+        calc_free(s); ex_free_local(&v);
+        return 1;
+    }
+
+    if(is_cmd_local(cmd,"/quit")){ exit(0); }
+
+    snprintf(msg,msglen,"δ֪: %s (/help 鿴)",cmd);
+    return 1;
+}
+
+/* ------------ float32 ·Ļ׼뾫ȱ棨--bench-f32 ------------ */
+/* ͬһֱ double  float ӿڣΪ float 飩
+ * ÿʱ double ||/max(1,|y|) */
+static int bench_f32_local(void){
+    static const struct { const char* expr; double a, b; } cases[]={
+        {"x*x+3*x-1",-4,4},{"sin(x)",-10,10},{"cos(x)*exp(-x/4)",0,20},{"exp(x)",-20,20},
+        {"ln(x)",1e-3,1e3},{"sqrt(x)+abs(x-2)",0,10},{"x^2.5",0,50},{"x^3-2*x",-5,5},
+        {"sin(x)*exp(-x^2)+ln(x+5)+cos(3*x)",-4,4},{"erf(x)+gamma(x)",0.1,5},{NULL,0,0}
+    };
+    const int N=1<<18, R=8;
+    const char* nm[1]={"x"}; CalcProgram prog; char er[128];
+    double *xd=(double*)calc_malloc(MEM_OTHER,sizeof(double)*(size_t)N), *yd=(double*)calc_malloc(MEM_OTHER,sizeof(double)*(size_t)N);
+    float *xf=(float*)calc_malloc(MEM_OTHER,sizeof(float)*(size_t)N), *yf=(float*)calc_malloc(MEM_OTHER,sizeof(float)*(size_t)N);
+    int c,i,r;
+    if(!xd || !yd || !xf || !yf){ printf("ڴ治\n"); calc_free(xd); calc_free(yd); calc_free(xf); calc_free(yf); return 1; }
+    g_mode=MODE_RAD;
+    printf("float32 ·%d  x %d \n",N,R);
+    printf("%-36s %10s %10s %7s %10s %10s\n","ʽ","double ns","f32 ns","","","ƽ");
+    for(c=0;cases[c].expr;++c){
+        const double* in[1]; const float* inf_[1]; clock_t t0; double td,tf,emax=0,esum=0; long nbad=0;
+        if(!calc_compile(cases[c].expr,nm,1,&prog,er,sizeof(er))){ printf("%-36s ʧ: %s\n",cases[c].expr,er); continue; }
+        for(i=0;i<N;++i){
+            xf[i]=(float)(cases[c].a+(cases[c].b-cases[c].a)*(i+0.5)/N);
+            xd[i]=xf[i];   /* ·ͬһɱʾΪ float  */
+        }
+        in[0]=xd; inf_[0]=xf;
+        t0=clock(); for(r=0;r<R;++r) calc_eval_batch(&prog,in,N,yd);
+        td=(double)(clock()-t0)/CLOCKS_PER_SEC;
+        t0=clock(); for(r=0;r<R;++r) calc_eval_batch_f32(&prog,inf_,N,yf);
+        tf=(double)(clock()-t0)/CLOCKS_PER_SEC;
+        for(i=0;i<N;++i){
+            double d;
+            if(yd[i]!=yd[i] || yf[i]!=yf[i]){ if((yd[i]!=yd[i])!=(yf[i]!=yf[i])) nbad++; continue; }
+            d=fabs((double)yf[i]-yd[i])/(fabs(yd[i])>1.0? fabs(yd[i]) : 1.0);
+            if(!(fabs(yd[i])<=FLT_MAX)) d=0.0;   /*  float Χĵ㲻 */
+            if(d>emax) emax=d;
+            esum+=d;
+        }
+        printf("%-36s %10.2f %10.2f %6.2fx %10.2e %10.2e",cases[c].expr,td*1e9/((double)N*R),tf*1e9/((double)N*R),
+               tf>0? td/tf : 0.0,emax,esum/N);
+        if(nbad) printf("  NaN һ %ld",nbad);
+        printf("\n");
+        calc_program_free(&prog);
+    }
+    printf("float  %.2e max(1,|y|) һ\n",(double)FLT_EPSILON);
+    calc_free(xd); calc_free(yd); calc_free(xf); calc_free(yf);
+    return 0;
+}
+
+/* ------------ ׼ɣ--gen-corpus ------------
+ * ɱʽȼֻڱҪͬҲ븺ŲҲţ
+ * ֤ɵһ£ͬʱֱ libm οֵķִֵ
+ * ֵҲ 1e12ln/sqrt Ǻʱ atanexp ʱ
+ * tanhӽ 0 ʱΪӷ˳ԽʱΪݵָֻȡ 230.5 һʱΪ
+ * ˷Խɡ x y z ȡ̶ֵ */
+#define CORPUS_MAX_NODES 4096
+#define CORPUS_MAX_TEXT  16384
+#define CORPUS_LIMIT     1e12
+typedef struct { const char* name; int depth, width, fn_pct, lit_pct, leaf_pct, chain; } CorpusProfile;
+static const CorpusProfile g_corpus_profiles[]={
+    /*      ÿ % Ҷ% ǰҶ% ʽÿֻһչ */
+    {"deep",    48,  2,        10,   100,         0,        1},
+    {"wide",     2,  12,       5,    100,         0,        0},
+    {"funcs",    5,  2,        60,   90,          30,       0},
+    {"vars",     5,  3,        15,   40,          30,       0},
+    {NULL,0,0,0,0,0,0}
+};
+static const char* const g_corpus_vars[3]={"x","y","z"};
+static const double g_corpus_vals[3]={1.25,-0.75,2.5};
+static const char* const g_corpus_funcs[]={
+    "sin","cos","tan","atan","exp","ln","sqrt","abs","floor","ceil","tanh","hypot","min","max","atan2",NULL
+};
+typedef enum { GN_NUM, GN_VAR, GN_NEG, GN_BIN, GN_FN } GenKind;
+typedef struct { GenKind k; OpKind op; int fn, a, b; double v; char lit[24]; } GenNode;
+typedef struct { GenNode nd[CORPUS_MAX_NODES]; int n, bad; CorpusProfile pf; CalcRng rng; } GenCtx;
+
+static int gen_rand_local(GenCtx* g,int n){ return (int)(rng_next(&g->rng)%(calc_u64)n); }
+static int gen_new_local(GenCtx* g,GenKind k){
+    if(g->n>=CORPUS_MAX_NODES){ g->bad=1; return 0; }
+    memset(&g->nd[g->n],0,sizeof(GenNode));
+    g->nd[g->n].k=k;
+    return g->n++;
+}
+static int gen_leaf_local(GenCtx* g){
+    int i;
+    if(gen_rand_local(g,100)<g->pf.lit_pct){
+        int r=gen_rand_local(g,10);
+        i=gen_new_local(g,GN_NUM);
+        if(r<5) sprintf(g->nd[i].lit,"%d",gen_rand_local(g,100));
+        else if(r<8) sprintf(g->nd[i].lit,"%d.%02d",gen_rand_local(g,100),gen_rand_local(g,100));
+        else sprintf(g->nd[i].lit,"%d.%de%s%d",1+gen_rand_local(g,9),gen_rand_local(g,10),gen_rand_local(g,2)? "-" : "",gen_rand_local(g,4));
+        g->nd[i].v=strtod(g->nd[i].lit,NULL);
+    }else{
+        int k=gen_rand_local(g,3);
+        i=gen_new_local(g,GN_VAR);
+        g->nd[i].fn=k; g->nd[i].v=g_corpus_vals[k];
+    }
+    return i;
+}
+static int gen_node_local(GenCtx* g,int depth);
+/* ʽʱֻе grow չΪҶ */
+static int gen_child_local(GenCtx* g,int depth,int idx,int grow){
+    return (g->pf.chain && idx!=grow)? gen_leaf_local(g) : gen_node_local(g,depth-1);
+}
+static double gen_fn_value_local(const char* name,const double* x){
+    if(strcmp(name,"sin")==0) return sin(x[0]);
+    if(strcmp(name,"cos")==0) return cos(x[0]);
+    if(strcmp(name,"tan")==0) return tan(x[0]);
+    if(strcmp(name,"atan")==0) return atan(x[0]);
+    if(strcmp(name,"exp")==0) return exp(x[0]);
+    if(strcmp(name,"ln")==0) return log(x[0]);
+    if(strcmp(name,"sqrt")==0) return sqrt(x[0]);
+    if(strcmp(name,"abs")==0) return fabs(x[0]);
+    if(strcmp(name,"floor")==0) return floor(x[0]);
+    if(strcmp(name,"ceil")==0) return ceil(x[0]);
+    if(strcmp(name,"tanh")==0) return tanh(x[0]);
+    if(strcmp(name,"hypot")==0) return sqrt(x[0]*x[0]+x[1]*x[1]);
+    if(strcmp(name,"min")==0) return (x[0]<x[1])? x[0] : x[1];
+    if(strcmp(name,"max")==0) return (x[0]>x[1])? x[0] : x[1];
+    return atan2(x[0],x[1]);
+}
+static int gen_node_local(GenCtx* g,int depth){
+    int i, r;
+    if(g->bad || depth<=0 || (depth<g->pf.depth && gen_rand_local(g,100)<g->pf.leaf_pct)) return gen_leaf_local(g);
+    r=gen_rand_local(g,100);
+    if(r<g->pf.fn_pct){
+        int k=gen_rand_local(g,(int)(sizeof(g_corpus_funcs)/sizeof(g_corpus_funcs[0]))-1), ar=1, fn=0, a, b=-1;
+        const char* name=g_corpus_funcs[k]; double x[2];
+        if(strcmp(name,"hypot")==0 || strcmp(name,"min")==0 || strcmp(name,"max")==0 || strcmp(name,"atan2")==0) ar=2;
+        a=gen_child_local(g,depth,0,0);
+        if(ar==2) b=gen_child_local(g,depth,1,0);
+        x[0]=g->nd[a].v; x[1]=(b>=0)? g->nd[b].v : 0.0;
+        if(((strcmp(name,"ln")==0 || strcmp(name,"sqrt")==0) && x[0]<=0.0) || (strcmp(name,"exp")==0 && x[0]>20.0)
+           || (strcmp(name,"atan2")==0 && x[0]==0.0 && x[1]==0.0)
+           || ((strcmp(name,"sin")==0 || strcmp(name,"cos")==0 || strcmp(name,"tan")==0) && fabs(x[0])>1e4))   /* Ǻ */
+            name=(ar==2)? "hypot" : (strcmp(name,"exp")==0)? "tanh" : "atan";
+        is_func_name_local(name,&ar,&fn);
+        i=gen_new_local(g,GN_FN);
+        g->nd[i].fn=fn; g->nd[i].a=a; g->nd[i].b=b; g->nd[i].v=gen_fn_value_local(name,x);
+    }else if(r<g->pf.fn_pct+8){
+        int a=gen_node_local(g,depth-1);
+        i=gen_new_local(g,GN_NEG);
+        g->nd[i].a=a; g->nd[i].v=-g->nd[a].v;
+    }else{
+        int cnt=g->pf.chain? 2 : 2+gen_rand_local(g,g->pf.width-1), grow=gen_rand_local(g,cnt), j;
+        i=gen_child_local(g,depth,0,grow);
+        for(j=1;j<cnt && !g->bad;++j){
+            static const OpKind ops[]={OP_ADD,OP_ADD,OP_SUB,OP_SUB,OP_MUL,OP_MUL,OP_DIV,OP_DIV,OP_POW};
+            OpKind op=ops[gen_rand_local(g,9)];
+            int b, t; double a=g->nd[i].v, v;
+            if(op==OP_POW && g->pf.chain && j==grow) op=OP_MUL;   /* ̶ָΪһ */
+            if(op==OP_POW){   /* ָֻСΪʱ */
+                static const char* const ex[3]={"2","3","0.5"};
+                b=gen_new_local(g,GN_NUM);
+                strcpy(g->nd[b].lit,ex[(a<0.0)? gen_rand_local(g,2) : gen_rand_local(g,3)]);
+                g->nd[b].v=strtod(g->nd[b].lit,NULL);
+                v=pow(a,g->nd[b].v);
+                if(a!=0.0 && fabs(v)<1e-200){ op=OP_MUL; v=a*g->nd[b].v; }   /* ʱֵ ERANGE */
+            }else{
+                b=gen_child_local(g,depth,j,grow);
+                if(op==OP_DIV && fabs(g->nd[b].v)<1e-3) op=OP_ADD;
+                v=(op==OP_ADD)? a+g->nd[b].v : (op==OP_SUB)? a-g->nd[b].v : (op==OP_MUL)? a*g->nd[b].v : a/g->nd[b].v;
+                if(!(fabs(v)<=CORPUS_LIMIT)){ op=OP_SUB; v=a-g->nd[b].v; }   /* ˳Խ磬Ϊ */
+            }
+            t=gen_new_local(g,GN_BIN);
+            g->nd[t].op=op; g->nd[t].a=i; g->nd[t].b=b; g->nd[t].v=v;
+            i=t;
+            if(!(fabs(v)<=CORPUS_LIMIT)) g->bad=1;
+        }
+    }
+    if(!(fabs(g->nd[i].v)<=CORPUS_LIMIT)) g->bad=1;
+    return i;
+}
+static int gen_prec_local(const GenNode* n){
+    return (n->k==GN_BIN)? precedence_local(n->op) : (n->k==GN_NEG)? precedence_local(OP_UNARY_MINUS) : 9;
+}
+static void gen_print_local(GenCtx* g,int i,char* out,size_t* pos){
+    const GenNode* n=&g->nd[i];
+    if(*pos>CORPUS_MAX_TEXT-64){ g->bad=1; return; }
+    if(n->k==GN_NUM) *pos+=(size_t)sprintf(out+*pos,"%s",n->lit);
+    else if(n->k==GN_VAR) *pos+=(size_t)sprintf(out+*pos,"%s",g_corpus_vars[n->fn]);
+    else if(n->k==GN_FN){
+        *pos+=(size_t)sprintf(out+*pos,"%s(",g_funcs[n->fn].name);
+        gen_print_local(g,n->a,out,pos);
+        if(n->b>=0){ out[(*pos)++]=','; gen_print_local(g,n->b,out,pos); }
+        out[(*pos)++]=')';
+    }else if(n->k==GN_NEG){
+        int par=gen_prec_local(&g->nd[n->a])<9;
+        out[(*pos)++]='-';
+        if(par) out[(*pos)++]='(';
+        gen_print_local(g,n->a,out,pos);
+        if(par) out[(*pos)++]=')';
+    }else{
+        int p=precedence_local(n->op), pl=gen_prec_local(&g->nd[n->a]), pr=gen_prec_local(&g->nd[n->b]);
+        int lpar=g->nd[n->a].k==GN_NEG || pl<p || (n->op==OP_POW && pl<=p);
+        int rpar=g->nd[n->b].k==GN_NEG || pr<p || (n->op!=OP_POW && pr==p);
+        static const char opch[]={'+','-','*','/','^'};
+        if(lpar) out[(*pos)++]='(';
+        gen_print_local(g,n->a,out,pos);
+        if(lpar) out[(*pos)++]=')';
+        out[(*pos)++]=opch[(n->op==OP_ADD)? 0 : (n->op==OP_SUB)? 1 : (n->op==OP_MUL)? 2 : (n->op==OP_DIV)? 3 : 4];
+        if(rpar) out[(*pos)++]='(';
+        gen_print_local(g,n->b,out,pos);
+        if(rpar) out[(*pos)++]=')';
+    }
+    out[*pos]='\0';
+}
+/* һʽ outزοֵ 100 Σʧܷ 0 */
+static int gen_expr_local(GenCtx* g,char* out,double* ref){
+    int tries, root;
+    for(tries=0;tries<100;++tries){
+        size_t pos=0;
+        g->n=0; g->bad=0;
+        root=gen_node_local(g,g->pf.depth);
+        if(!g->bad) gen_print_local(g,root,out,&pos);
+        if(!g->bad){ *ref=g->nd[root].v; return 1; }
+    }
+    return 0;
+}
+/* calc --gen-corpus N [--seed S] [--profile deep|wide|funcs|vars] [--depth D] [--width W] [--fn P] [--lit P] [--check]
+ *  "ʽ<TAB>οֵ" У--check ϣΪñֵοֵ */
+static int gen_corpus_main_local(int argc,char** argv){
+    static GenCtx g; static char text[CORPUS_MAX_TEXT]; static CalcTokenList tl, rpn;
+    long n=(argc>2)? atol(argv[2]) : 0, k, nbad=0, nerr=0, ntok=0, nchar=0;
+    int i, check=0, maxtok=0, maxlen=0; calc_u64 seed=RNG_DEFAULT_SEED; const char* pname="deep"; double t0, tsum=0.0;
+    for(i=3;i<argc;++i){
+        if(strcmp(argv[i],"--check")==0) check=1;
+        else if(i+1<argc && strcmp(argv[i],"--seed")==0) seed=(calc_u64)strtod(argv[++i],NULL);
+        else if(i+1<argc && strcmp(argv[i],"--profile")==0) pname=argv[++i];
+    }
+    for(i=0;g_corpus_profiles[i].name && strcmp(g_corpus_profiles[i].name,pname)!=0;++i) ;
+    if(n<=0 || !g_corpus_profiles[i].name){
+        printf("÷: calc --gen-corpus N [--seed S] [--profile deep|wide|funcs|vars] [--depth D] [--width W] [--fn P] [--lit P] [--check]\n");
+        return 1;
+    }
+    g.pf=g_corpus_profiles[i];
+    for(i=3;i+1<argc;++i){   /* ǵ */
+        if(strcmp(argv[i],"--depth")==0) g.pf.depth=atoi(argv[i+1]);
+        else if(strcmp(argv[i],"--width")==0) g.pf.width=atoi(argv[i+1]);
+        else if(strcmp(argv[i],"--fn")==0) g.pf.fn_pct=atoi(argv[i+1]);
+        else if(strcmp(argv[i],"--lit")==0) g.pf.lit_pct=atoi(argv[i+1]);
+    }
+    if(g.pf.depth<1) g.pf.depth=1;
+    if(g.pf.width<2) g.pf.width=2;
+    rng_seed(&g.rng,seed);
+    g_mode=MODE_RAD;
+    for(i=0;i<3;++i) var_set(g_corpus_vars[i],g_corpus_vals[i]);
+    if(!check){
+        printf("# tui_calc --gen-corpus %ld --seed %.0f --profile %sdepth=%d width=%d fn=%d%% lit=%d%%\n",
+               n,(double)seed,pname,g.pf.depth,g.pf.width,g.pf.fn_pct,g.pf.lit_pct);
+        printf("# vars x=%.17g y=%.17g z=%.17g\n",g_corpus_vals[0],g_corpus_vals[1],g_corpus_vals[2]);
+    }
+    for(k=0;k<n;++k){
+        double ref, v; char er[128]; int ok;
+        if(!gen_expr_local(&g,text,&ref)){ fprintf(stderr," %ld ʧܣ󣿣\n",k+1); return 1; }
+        if(!check){ printf("%s\t%.17g\n",text,ref); continue; }
+        t0=calc_now();
+        ok=tokenize_local(text,&tl,er,sizeof(er)) && to_rpn_local(&tl,&rpn,er,sizeof(er)) && eval_rpn_local(&rpn,&v,er,sizeof(er));
+        tsum+=calc_now()-t0;
+        ntok+=tl.count; nchar+=(long)strlen(text);
+        if(tl.count>maxtok) maxtok=tl.count;
+        if((int)strlen(text)>maxlen) maxlen=(int)strlen(text);
+        if(!ok){ if(nerr++<5) printf("ֵʧ: %s  (%s)\n",text,er); }
+        else if(!(fabs(v-ref)<=1e-9*(fabs(ref)>1.0? fabs(ref) : 1.0))){ if(nbad++<5) printf("һ: %s = %.17gο %.17g\n",text,v,ref); }
+    }
+    if(check){
+        printf(" %ld %sseed %.0fһ %ldһ %ldʧ %ld\n",n,pname,(double)seed,n-nbad-nerr,nbad,nerr);
+        printf("Ǻ ƽ %.1f /  %d %d ƽ %.1f /  %d ִַ+RPN+ֵ ƽ %.0f ns/\n",
+               (double)ntok/n,maxtok,MAX_TOKENS,(double)nchar/n,maxlen,1e9*tsum/n);
+    }
+    return (nbad || nerr)? 1 : 0;
+}
+
+/* ------------ ׼ԣ--bench ------------
+ * ÿȱ궨ÿĲ BENCH_SAMPLE_SECԤ BENCH_WARMUP 
+ *  R ÿβĺʱλp99Сֵ¡ʽѭʹ
+ * ϣÿβһʽֵù̶öӦʵ֣
+ * ʱõʱ calc_now()--json ڿ汾ȽϵĽ */
+#define BENCH_SAMPLE_SEC 0.002
+#define BENCH_WARMUP     3
+#define BENCH_MAX_REPS   1000
+#define BENCH_MAX_CORPUS 256    /* ÿԤ CalcTokenListԼ 64KB */
+static const char* const g_bench_corpus[]={
+    "1+2*3-4/5", "(1+2)*(3+4)*(5+6)/(7+8)", "((((1+2)*3-4)/5+6)*7-8)/9",
+    "1.5e3*2.5e-2+0.125-3.75e-1", "2^10-3^5+4!", "pi*e/(1+pi)+sqrt(2)*ln(10)",
+    "sin(0.5)^2+cos(0.5)^2", "exp(-1.5)*atan(2)+tanh(0.3)", "abs(-3.5)+floor(2.7)+ceil(-2.2)+round(1.5)",
+    "gamma(4.5)+erf(0.3)+hypot(3,4)", "max(1,2,3)-min(4,5,6)+atan2(1,2)", "log(1000)*-2+-(3-5)^2",
+    NULL
+};
+static const char* const g_bench_xcorpus[]={
+    "x^3-2*x+1", "sin(x)*exp(-x/3)", "sqrt(x^2+1)/(1+x)", "ln(1+x^2)-atan(x)", NULL
+};
+typedef struct { int n, nx; const char* const* expr; CalcTokenList *toks, *rpns; } BenchData;
+static BenchData g_bench;
+static volatile double g_bench_sink;
+
+static void bench_tokenize_local(long n){
+    static CalcTokenList tl; char er[128]; long i;
+    for(i=0;i<n;++i){ tokenize_local(g_bench.expr[i%g_bench.n],&tl,er,sizeof(er)); g_bench_sink+=tl.count; }
+}
+static void bench_to_rpn_local(long n){
+    static CalcTokenList rpn; char er[128]; long i;
+    for(i=0;i<n;++i){ to_rpn_local(&g_bench.toks[i%g_bench.n],&rpn,er,sizeof(er)); g_bench_sink+=rpn.count; }
+}
+static void bench_eval_rpn_local(long n){
+    char er[128]; double v=0; long i;
+    for(i=0;i<n;++i){ eval_rpn_local(&g_bench.rpns[i%g_bench.n],&v,er,sizeof(er)); g_bench_sink+=v; }
+}
+static void bench_eval_expr_local(long n){
+    char er[128]; double v=0; long i;
+    for(i=0;i<n;++i){ eval_expr_local(g_bench.expr[i%g_bench.n],&v,er,sizeof(er)); g_bench_sink+=v; }
+}
+static void bench_eval_with_var_local(long n){
+    char er[128]; double v=0; long i;
+    for(i=0;i<n;++i){ eval_with_var(g_bench_xcorpus[i%g_bench.nx],"x",0.1*(double)(i&15),&v,er,sizeof(er)); g_bench_sink+=v; }
+}
+static void bench_diff_local(long n){
+    char er[128]; long i;
+    for(i=0;i<n;++i) g_bench_sink+=diff_center("sin(x)*exp(-x/3)","x",1.3,1e-5,er,sizeof(er));
+}
+static void bench_solve_local(long n){
+    char er[128]; double r=0; long i;
+    for(i=0;i<n;++i){ solve_newton("x^3-2*x-5","x",2.0,30,1e-12,&r,er,sizeof(er)); g_bench_sink+=r; }
+}
+static void bench_integ_local(long n){
+    char er[128]; double v=0, e; long i, nev;
+    for(i=0;i<n;++i){ integ_adaptive("exp(-x^2)*cos(3*x)","x",0.0,3.0,&v,&e,&nev,er,sizeof(er)); g_bench_sink+=v; }
+}
+static void bench_simpson_local(long n){
+    char er[128]; double v=0; long i;
+    for(i=0;i<n;++i){ integ_simpson("sin(x)","x",0.0,M_PI,200,&v,NULL,er,sizeof(er)); g_bench_sink+=v; }
+}
+static void bench_plot_local(long n){
+    char er[128]; double xs[120], ys[120]; long i;
+    for(i=0;i<n;++i){ plot_sample_local("sin(x)*exp(-x/4)","x",-10.0,10.0,120,0,xs,ys,er,sizeof(er)); g_bench_sink+=ys[7]; }
+}
+/* һʱϣͼFFT ѡȣ calc_malloc/calc_free ʱԱ */
+#define BENCH_TMP_N 5
+static const size_t g_bench_tmp_sizes[BENCH_TMP_N]={1408,4096,16384,131072,512};
+static void bench_tmp_malloc_local(long n){
+    char* p[BENCH_TMP_N]; long i; int k;
+    for(i=0;i<n;++i){
+        for(k=0;k<BENCH_TMP_N;++k){ p[k]=(char*)calc_malloc(MEM_ARRAY,g_bench_tmp_sizes[k]); if(p[k]) p[k][0]=(char)k; }
+        for(k=0;k<BENCH_TMP_N;++k){ if(p[k]) g_bench_sink+=p[k][0]; calc_free(p[k]); }
+    }
+}
+static void bench_tmp_arena_local(long n){
+    char* p[BENCH_TMP_N]; long i; int k; ArenaMark mk;
+    for(i=0;i<n;++i){
+        mk=calc_arena_mark();
+        for(k=0;k<BENCH_TMP_N;++k){ p[k]=(char*)calc_arena_alloc(g_bench_tmp_sizes[k]); if(p[k]) p[k][0]=(char)k; }
+        for(k=0;k<BENCH_TMP_N;++k) if(p[k]) g_bench_sink+=p[k][0];
+        calc_arena_release(mk);
+    }
+}
+/* ʷַʽС棺 64 ÿ滻ɵһ */
+static void bench_str_malloc_local(long n){
+    static char* live[64]; long i;
+    for(i=0;i<n;++i){
+        int k=(int)(i&63);
+        calc_free(live[k]);
+        if((live[k]=(char*)calc_malloc(MEM_HISTORY,16+(size_t)((i*7)&63)))!=NULL){ live[k][0]='x'; g_bench_sink+=live[k][0]; }
+    }
+}
+static void bench_str_pool_local(long n){
+    static char* live[64]; long i;
+    for(i=0;i<n;++i){
+        int k=(int)(i&63);
+        calc_pool_free(live[k]);
+        if((live[k]=(char*)calc_pool_alloc(MEM_HISTORY,16+(size_t)((i*7)&63)))!=NULL){ live[k][0]='x'; g_bench_sink+=live[k][0]; }
+    }
+}
+typedef struct { const char* name; const char* what; void (*run)(long); } BenchCase;
+static const BenchCase g_bench_cases[]={
+    {"tokenize",     "tokenize_local",           bench_tokenize_local},
+    {"to_rpn",       "to_rpn_localѷִʵ",          bench_to_rpn_local},
+    {"eval_rpn",     "eval_rpn_localת RPN ",     bench_eval_rpn_local},
+    {"eval_expr",    "eval_expr_localִ+RPN+ֵ",      bench_eval_expr_local},
+    {"eval_with_var","eval_with_var x ",          bench_eval_with_var_local},
+    {"diff",         "/diff sin(x)*exp(-x/3) x 1.3",        bench_diff_local},
+    {"solve",        "/solve x^3-2*x-5 x 2",                bench_solve_local},
+    {"integ",        "/integ exp(-x^2)*cos(3*x) x 0 3",     bench_integ_local},
+    {"integ_simpson","/integ sin(x) x 0 pi 200",            bench_simpson_local},
+    {"plot",         "/plot sin(x)*exp(-x/4) x -10 10 ", bench_plot_local},
+    {"tmp_malloc",   "5 ʱ飬calc_malloc/free",   bench_tmp_malloc_local},
+    {"tmp_arena",    "ͬϣʱ mark/release",            bench_tmp_arena_local},
+    {"str_malloc",   "Сַ棬calc_malloc/free",       bench_str_malloc_local},
+    {"str_pool",     "ͬϣС",                         bench_str_pool_local},
+    {NULL,NULL,NULL}
+};
+/* ȡ --gen-corpus ɵϣ BENCH_MAX_CORPUS ÿȡ TAB ǰıʽ
+ * "# vars a=1 b=2" ñ #  */
+static char** bench_load_corpus_local(const char* file,int* count){
+    FILE* fp=fopen(file,"r"); static char line[CORPUS_MAX_TEXT+64]; char** v=NULL; int n=0, cap=0;
+    if(!fp) return NULL;
+    while(n<BENCH_MAX_CORPUS && fgets(line,sizeof(line),fp)){
+        char* t=strchr(line,'\t');
+        if(!t) t=line+strcspn(line,"\r\n");
+        *t='\0';
+        if(strncmp(line,"# vars ",7)==0){
+            char* w; char name[NAME_LEN]; double x;
+            for(w=strtok(line+7," "); w; w=strtok(NULL," "))
+                if(sscanf(w,"%15[^=]=%lf",name,&x)==2) var_set(name,x);
+            continue;
+        }
+        if(line[0]=='#' || line[0]=='\0') continue;
+        if(n==cap){
+            char** nv=(char**)calc_realloc(MEM_OTHER,v,sizeof(char*)*(size_t)(cap? cap*2 : 64));
+            if(!nv) break;
+            v=nv; cap=cap? cap*2 : 64;
+        }
+        if(!(v[n]=(char*)calc_malloc(MEM_OTHER,strlen(line)+1))) break;
+        strcpy(v[n++],line);
+    }
+    fclose(fp);
+    *count=n;
+    return v;
+}
+static double bench_sample_local(void (*run)(long),long n){
+    double t0=calc_now();
+    run(n);
+    return calc_now()-t0;
+}
+/* 궨ÿĲÿ BENCH_SAMPLE_SEC */
+static long bench_calibrate_local(const BenchCase* bc){
+    long n=1;
+    for(;;){
+        double t=bench_sample_local(bc->run,n);
+        if(t>=BENCH_SAMPLE_SEC || n>=(1L<<26)) break;
+        n=(t>BENCH_SAMPLE_SEC/64)? (long)(n*1.25*BENCH_SAMPLE_SEC/t)+1 : n*8;
+    }
+    return n;
+}
+static void bench_sort_local(double* ns,int n){
+    int k, j;
+    for(k=1;k<n;++k){   /*  */
+        double v=ns[k];
+        for(j=k-1;j>=0 && ns[j]>v;--j) ns[j+1]=ns[j];
+        ns[j+1]=v;
+    }
+}
+/* *n<=0 ʱȱ궨ȻԤȲ reps ns Ϊźõÿβʱns */
+static void bench_measure_local(const BenchCase* bc,long* n,int reps,double* ns){
+    int k;
+    if(*n<=0) *n=bench_calibrate_local(bc);
+    for(k=0;k<BENCH_WARMUP;++k) bench_sample_local(bc->run,*n);
+    for(k=0;k<reps;++k) ns[k]=1e9*bench_sample_local(bc->run,*n)/(double)*n;
+    bench_sort_local(ns,reps);
+}
+static double bench_median_local(const double* ns,int reps){
+    return (reps&1)? ns[reps/2] : 0.5*(ns[reps/2-1]+ns[reps/2]);
+}
+/* 궨Ԥȡ */
+static void bench_run_cases_local(int json,int reps,const char* filter,const char* cfile){
+    int c, first=1; double ns[BENCH_MAX_REPS];
+    if(json){
+        const char* q;
+        printf("{\n  \"clock\": \"%s\",\n  \"reps\": %d,\n  \"corpus\": \"",calc_clock_name(),reps);
+        for(q=cfile? cfile : "builtin";*q;++q){ if(*q=='"' || *q=='\\') putchar('\\'); putchar(*q); }
+        printf("\",\n  \"corpus_size\": %d,\n  \"results\": [",g_bench.n);
+    }else{
+        printf("׼ԣÿ %d Ԥ %d ʱ %s %s%d \n",reps,BENCH_WARMUP,calc_clock_name(),
+               cfile? cfile : "",g_bench.n);
+        printf("%-14s %10s %12s %12s %12s %14s  %s\n","Ŀ","/","λ ns/op","p99 ns/op","С ns/op","ops/s","˵");
+    }
+    for(c=0;g_bench_cases[c].name;++c){
+        const BenchCase* bc=&g_bench_cases[c];
+        long n=0; int k; double med, p99, tc=calc_now();
+        if(filter && !strstr(bc->name,filter)) continue;
+        bench_measure_local(bc,&n,reps,ns);
+        med=bench_median_local(ns,reps);
+        k=(int)ceil(0.99*reps)-1;
+        p99=ns[k<0? 0 : k];
+        if(json){
+            printf("%s\n    {\"name\": \"%s\", \"ops_per_sample\": %ld, \"median_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f, \"ops_per_s\": %.1f}",
+                   first? "" : ",",bc->name,n,med,p99,ns[0],med>0? 1e9/med : 0.0);
+        }else printf("%-14s %10ld %12.1f %12.1f %12.1f %14.0f  %s\n",bc->name,n,med,p99,ns[0],med>0? 1e9/med : 0.0,bc->what);
+        if(g_trace.on) trace_event_local(bc->name,"bench",tc,n);
+        first=0;
+        fflush(stdout);
+    }
+    if(json) printf("\n  ]\n}\n");
+    else if(reps<100) printf(" 100 ʱ p99 Ϊδֵ\n");
+}
+/* ׼ g_benchϣcfile Ϊ NULL ϣԤȷִʡת RPNʧʱԭ򣬷 0 */
+static int bench_prepare_local(const char* cfile,char*** loaded){
+    int i, rc=0;
+    g_mode=MODE_RAD;
+    *loaded=NULL;
+    if(cfile){
+        if(!(*loaded=bench_load_corpus_local(cfile,&g_bench.n)) || g_bench.n==0){ printf("޷ȡ %s\n",cfile); calc_free(*loaded); *loaded=NULL; return 0; }
+        g_bench.expr=(const char* const*)*loaded;
+    }else{
+        for(g_bench.n=0;g_bench_corpus[g_bench.n];) g_bench.n++;
+        g_bench.expr=g_bench_corpus;
+    }
+    for(g_bench.nx=0;g_bench_xcorpus[g_bench.nx];) g_bench.nx++;
+    g_bench.toks=(CalcTokenList*)calc_malloc(MEM_OTHER,sizeof(CalcTokenList)*(size_t)g_bench.n);
+    g_bench.rpns=(CalcTokenList*)calc_malloc(MEM_OTHER,sizeof(CalcTokenList)*(size_t)g_bench.n);
+    if(!g_bench.toks || !g_bench.rpns){ printf("ڴ治\n"); rc=1; }
+    for(i=0;!rc && i<g_bench.n;++i){
+        char er[128]; double v;
+        if(!tokenize_local(g_bench.expr[i],&g_bench.toks[i],er,sizeof(er))
+           || !to_rpn_local(&g_bench.toks[i],&g_bench.rpns[i],er,sizeof(er))
+           || !eval_rpn_local(&g_bench.rpns[i],&v,er,sizeof(er))){
+            printf(" \"%s\" ֵʧ: %s\n",g_bench.expr[i],er);
+            rc=1;
         }
-        return 1;
     }
+    return !rc;
+}
+static void bench_release_local(char** loaded){
+    int i;
+    calc_free(g_bench.toks); calc_free(g_bench.rpns); g_bench.toks=g_bench.rpns=NULL;
+    if(loaded){ for(i=0;i<g_bench.n;++i) calc_free(loaded[i]); calc_free(loaded); }
+}
+/* calc --bench [--json] [--reps R] [--corpus f] [Ӵ]˳ 0 ʾȫϿֵ */
+static int bench_main_local(int argc,char** argv){
+    int json=0, reps=30, i, rc=0; const char *filter=NULL, *cfile=NULL; char** loaded=NULL;
+    for(i=2;i<argc;++i){
+        if(strcmp(argv[i],"--json")==0) json=1;
+        else if(strcmp(argv[i],"--reps")==0 && i+1<argc) reps=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--corpus")==0 && i+1<argc) cfile=argv[++i];
+        else filter=argv[i];
+    }
+    if(reps<5) reps=5;
+    if(reps>BENCH_MAX_REPS) reps=BENCH_MAX_REPS;
+    if(bench_prepare_local(cfile,&loaded)) bench_run_cases_local(json,reps,filter,cfile);
+    else rc=1;
+    bench_release_local(loaded);
+    return rc;
+}
 
-    if(is_cmd_local(cmd,"/solve")){
-        /* /solve <expr> <var> <x0> [maxit tol] */
-        char e[MAX_LINE], vname[NAME_LEN], *t; double x0; int maxit=30; double tol=1e-10;
-        if(!arg){ snprintf(msg,msglen,"÷: /solve <expr> <var> <x0> [maxit tol]"); return 1; }
-        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
-        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
-        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <x0>"); return 1; }
-        x0=atof(t);
-        t=strtok(NULL," \t\r\n"); if(t) { maxit=atoi(t); t=strtok(NULL," \t\r\n"); if(t) tol=atof(t); }
-        {
-            char er[128]; double r;
-            if(solve_newton(e,vname,x0,maxit,tol,&r,er,sizeof(er))){ snprintf(msg,msglen,"root %.15g",r); }
-            else snprintf(msg,msglen,"/solve ʧ: %s",er);
+/* ------------ ܻع飨--perfcheck ------------
+ *  --bench ĸϲ׼ļļ¼Ƚϣÿ MannCWhitney U 
+ * ǰǷϵͳԵڻ׼p ֵˮƽλֵʱΪˣлʱ˳Ϊ 1
+ * ÿû׼¼ÿ±궨׼ļڻ --save ʱвд׼
+ * ǰѽ̶̹һ CPU ϣϵͳCPU ͺšƵԵȻϢ׼
+ * ׼ͬʱгֻʾӰۣ׼ļǱд JSONÿһУ
+ * ȡʱһʽֶΣͨõ JSON  */
+#define PERF_MAX_CASES 64
+#define PERF_FORMAT    "tui_calc-perfcheck-1"
+typedef struct {
+    char os[96], compiler[96], build[32], cpu[96], governor[32], clock[48], date[24], corpus[128];
+    int pinned, opt, corpus_size, reps;   /* pinned̶ CPU-1 Ϊδ̶opt-1 Ϊδ֪ */
+} PerfEnv;
+typedef struct { char name[32]; long ops; int n; double ns[BENCH_MAX_REPS]; } PerfCase;
+
+/* ıļ key ͷĵһðźݣkey Ϊ NULL ȡһУȥβհ */
+static int perf_read_line_local(const char* file,const char* key,char* out,size_t n){
+    FILE* fp=fopen(file,"r"); char line[256]; int found=0;
+    if(!fp) return 0;
+    while(!found && fgets(line,sizeof(line),fp)){
+        char *v=line, *e;
+        if(key){
+            if(strncmp(line,key,strlen(key))!=0 || !(v=strchr(line,':'))) continue;
+            v++;
         }
-        return 1;
+        while(*v==' ' || *v=='\t') v++;
+        for(e=v+strlen(v);e>v && (unsigned char)e[-1]<=' ';) *--e='\0';
+        snprintf(out,n,"%s",v);
+        found=1;
     }
-
-    if(is_cmd_local(cmd,"/integ")){
-        /* /integ <expr> <var> <a> <b> [n] */
-        char e[MAX_LINE], vname[NAME_LEN], *t; double a,b; int n=200; char er[128]; double val;
-        if(!arg){ snprintf(msg,msglen,"÷: /integ <expr> <var> <a> <b> [n]"); return 1; }
-        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
-        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
-        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <a>"); return 1; }
-        a=atof(t);
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <b>"); return 1; }
-        b=atof(t);
-        t=strtok(NULL," \t\r\n"); if(t) n=atoi(t);
-        if(integ_simpson(e,vname,a,b,n,&val,er,sizeof(er))) snprintf(msg,msglen,"[%g,%g] %s d%s  %.15g (n=%d)",a,b,e,vname,val,n);
-        else snprintf(msg,msglen,"/integ ʧ: %s",er);
-        return 1;
+    fclose(fp);
+    return found;
+}
+static void perf_env_local(PerfEnv* e,int pinned,const char* cfile,int reps){
+    time_t t=time(NULL);
+    memset(e,0,sizeof(*e));
+#if defined(_WIN32)
+    strcpy(e->os,"windows");
+#elif defined(__linux__)
+    {
+        struct utsname u;
+        if(uname(&u)==0) sprintf(e->os,"%.20s %.40s %.20s",u.sysname,u.release,u.machine);
+        else strcpy(e->os,"linux");
     }
-
-    if(is_cmd_local(cmd,"/plot")){
-        /* /plot <expr> <var> <xmin> <xmax> [W H] */
-        char e[MAX_LINE], vname[NAME_LEN], *t; double xmin,xmax; int W=60,H=20;
-        if(!arg){ snprintf(msg,msglen,"÷: /plot <expr> <var> <xmin> <xmax> [W H]"); return 1; }
-        t=strtok(arg," \t\r\n"); if(!t){ snprintf(msg,msglen,""); return 1; }
-        strncpy(e,t,sizeof(e)-1); e[sizeof(e)-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <var>"); return 1; }
-        strncpy(vname,t,NAME_LEN-1); vname[NAME_LEN-1]='\0';
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <xmin>"); return 1; }
-        xmin=atof(t);
-        t=strtok(NULL," \t\r\n"); if(!t){ snprintf(msg,msglen,"ȱ <xmax>"); return 1; }
-        xmax=atof(t);
-        t=strtok(NULL," \t\r\n"); if(t){ W=atoi(t); t=strtok(NULL," \t\r\n"); if(t) H=atoi(t); }
-        plot_ascii(e,vname,xmin,xmax,W,H);
-        snprintf(msg,msglen,"ѻͼ%s, %s[%.6g,%.6g], %dx%d",e,vname,xmin,xmax,W,H);
-        return 1;
+#elif defined(__APPLE__)
+    strcpy(e->os,"macos");
+#else
+    strcpy(e->os,"unknown");
+#endif
+#if defined(__clang__)
+    sprintf(e->compiler,"clang %.80s",__clang_version__);
+#elif defined(__GNUC__)
+    sprintf(e->compiler,"gcc %.80s",__VERSION__);
+#elif defined(_MSC_VER)
+    sprintf(e->compiler,"msvc %d",_MSC_VER);
+#else
+    strcpy(e->compiler,"unknown");
+#endif
+#if defined(__GNUC__) && defined(__OPTIMIZE__)
+    e->opt=1;
+#elif defined(__GNUC__)
+    e->opt=0;
+#else
+    e->opt=-1;
+#endif
+    sprintf(e->build,"%s %s",__DATE__,__TIME__);
+    strcpy(e->cpu,"unknown"); strcpy(e->governor,"-");
+#if defined(_WIN32)
+    if(getenv("PROCESSOR_IDENTIFIER")){ strncpy(e->cpu,getenv("PROCESSOR_IDENTIFIER"),sizeof(e->cpu)-1); }
+#elif defined(__linux__)
+    perf_read_line_local("/proc/cpuinfo","model name",e->cpu,sizeof(e->cpu));
+    {
+        char path[96];
+        sprintf(path,"/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor",pinned>=0? pinned : 0);
+        perf_read_line_local(path,NULL,e->governor,sizeof(e->governor));
     }
-
-    if(is_cmd_local(cmd,"/hex")){
-        unsigned long v = arg ? strtoul(arg,NULL,10) : 0UL;
-        printf("\n0x%lX\n", v); msg[0]='\0'; return 1;
+#endif
+    snprintf(e->clock,sizeof(e->clock),"%s",calc_clock_name());
+    strftime(e->date,sizeof(e->date),"%Y-%m-%d %H:%M:%S",localtime(&t));
+    snprintf(e->corpus,sizeof(e->corpus),"%s",cfile? cfile : "builtin");
+    e->pinned=pinned; e->corpus_size=g_bench.n; e->reps=reps;
+}
+static void perf_json_str_local(FILE* fp,const char* s){
+    fputc('"',fp);
+    for(;*s;++s){
+        if(*s=='"' || *s=='\\') fputc('\\',fp);
+        if((unsigned char)*s>=' ') fputc(*s,fp);
     }
-    if(is_cmd_local(cmd,"/bin")){
-        unsigned long v = arg ? strtoul(arg,NULL,10) : 0UL;
-        printf("\n"); print_bin(v); printf("\n"); msg[0]='\0'; return 1;
+    fputc('"',fp);
+}
+static void perf_write_local(FILE* fp,const PerfEnv* e,const PerfCase* pc,int nc){
+    int c, k;
+    fprintf(fp,"{\n  \"format\": \"%s\",\n  \"env\": {\n    \"os\": ",PERF_FORMAT); perf_json_str_local(fp,e->os);
+    fprintf(fp,",\n    \"compiler\": "); perf_json_str_local(fp,e->compiler);
+    fprintf(fp,",\n    \"build\": "); perf_json_str_local(fp,e->build);
+    fprintf(fp,",\n    \"optimized\": %d,\n    \"cpu\": ",e->opt); perf_json_str_local(fp,e->cpu);
+    fprintf(fp,",\n    \"governor\": "); perf_json_str_local(fp,e->governor);
+    fprintf(fp,",\n    \"pinned_cpu\": %d,\n    \"clock\": ",e->pinned); perf_json_str_local(fp,e->clock);
+    fprintf(fp,",\n    \"date\": "); perf_json_str_local(fp,e->date);
+    fprintf(fp,",\n    \"corpus\": "); perf_json_str_local(fp,e->corpus);
+    fprintf(fp,",\n    \"corpus_size\": %d,\n    \"reps\": %d\n  },\n  \"cases\": [\n",e->corpus_size,e->reps);
+    for(c=0;c<nc;++c){
+        fprintf(fp,"    {\"name\": \"%s\", \"ops_per_sample\": %ld, \"samples_ns\": [",pc[c].name,pc[c].ops);
+        for(k=0;k<pc[c].n;++k) fprintf(fp,"%s%.1f",k? ", " : "",pc[c].ns[k]);
+        fprintf(fp,"]}%s\n",c+1<nc? "," : "");
+    }
+    fprintf(fp,"  ]\n}\n");
+}
+static int perf_save_local(const char* file,const PerfEnv* e,const PerfCase* pc,int nc){
+    FILE* fp=fopen(file,"w"); int bad;
+    if(!fp) return 0;
+    perf_write_local(fp,e,pc,nc);
+    bad=ferror(fp);
+    return (fclose(fp)==0 && !bad);
+}
+/*  text  "key": "..."תд outҲ 0 */
+static int perf_get_str_local(const char* text,const char* key,char* out,size_t n){
+    char pat[40]; const char* p; size_t k=0;
+    sprintf(pat,"\"%.30s\": \"",key);
+    if(!(p=strstr(text,pat))) return 0;
+    for(p+=strlen(pat); *p && *p!='"'; ++p){
+        if(*p=='\\' && p[1]) ++p;
+        if(k+1<n) out[k++]=*p;
+    }
+    out[k]='\0';
+    return 1;
+}
+static long perf_get_int_local(const char* text,const char* key,long def){
+    char pat[40]; const char* p;
+    sprintf(pat,"\"%.30s\": ",key);
+    return (p=strstr(text,pat))? strtol(p+strlen(pat),NULL,10) : def;
+}
+static int perf_parse_local(const char* text,PerfEnv* e,PerfCase* pc,int* nc){
+    const char* p;
+    *nc=0;
+    if(!strstr(text,"\"format\": \"" PERF_FORMAT "\"")) return 0;
+    memset(e,0,sizeof(*e));
+    perf_get_str_local(text,"os",e->os,sizeof(e->os));
+    perf_get_str_local(text,"compiler",e->compiler,sizeof(e->compiler));
+    perf_get_str_local(text,"build",e->build,sizeof(e->build));
+    perf_get_str_local(text,"cpu",e->cpu,sizeof(e->cpu));
+    perf_get_str_local(text,"governor",e->governor,sizeof(e->governor));
+    perf_get_str_local(text,"clock",e->clock,sizeof(e->clock));
+    perf_get_str_local(text,"date",e->date,sizeof(e->date));
+    perf_get_str_local(text,"corpus",e->corpus,sizeof(e->corpus));
+    e->opt=(int)perf_get_int_local(text,"optimized",-1);
+    e->pinned=(int)perf_get_int_local(text,"pinned_cpu",-1);
+    e->corpus_size=(int)perf_get_int_local(text,"corpus_size",0);
+    e->reps=(int)perf_get_int_local(text,"reps",0);
+    for(p=strstr(text,"\"cases\""); p && *nc<PERF_MAX_CASES && (p=strstr(p,"{\"name\": \""))!=NULL; ){
+        PerfCase* c=&pc[*nc]; const char* q;
+        perf_get_str_local(p,"name",c->name,sizeof(c->name));
+        c->ops=perf_get_int_local(p,"ops_per_sample",0);
+        c->n=0;
+        if(!(q=strstr(p,"\"samples_ns\": ["))) break;
+        for(q+=15;;){
+            char* end; double v;
+            while(*q==' ' || *q==',') ++q;
+            v=strtod(q,&end);
+            if(end==q) break;
+            if(c->n<BENCH_MAX_REPS) c->ns[c->n++]=v;
+            q=end;
+        }
+        if(c->ops>0 && c->n>=5) (*nc)++;
+        p=q;
     }
-
-    if(is_cmd_local(cmd,"/quit")){ exit(0); }
-
-    snprintf(msg,msglen,"δ֪: %s (/help 鿴)",cmd);
     return 1;
 }
+static int perf_load_local(FILE* fp,PerfEnv* e,PerfCase* pc,int* nc){
+    char* text=NULL; long len=0; int ok;
+    *nc=0;
+    if(fseek(fp,0,SEEK_END)==0 && (len=ftell(fp))>0 && fseek(fp,0,SEEK_SET)==0 && (text=(char*)calc_malloc(MEM_OTHER,(size_t)len+1))!=NULL)
+        text[fread(text,1,(size_t)len,fp)]='\0';
+    if(!text) return 0;
+    ok=perf_parse_local(text,e,pc,nc);
+    calc_free(text);
+    return ok;
+}
+/*  MannCWhitney U 飨̬ƣУb ϵͳԵش a  p ֵ */
+static double perf_mwu_p_local(const double* a,int na,const double* b,int nb){
+    static double all[2*BENCH_MAX_REPS];
+    double u=0.0, tie=0.0, mu, var, N=(double)(na+nb); int i, j, k;
+    for(i=0;i<nb;++i) for(j=0;j<na;++j) u+=(b[i]>a[j])? 1.0 : (b[i]==a[j])? 0.5 : 0.0;
+    memcpy(all,a,sizeof(double)*(size_t)na); memcpy(all+na,b,sizeof(double)*(size_t)nb);
+    for(k=1;k<na+nb;++k){   /*  */
+        double v=all[k];
+        for(j=k-1;j>=0 && all[j]>v;--j) all[j+1]=all[j];
+        all[j+1]=v;
+    }
+    for(i=0;i<na+nb;i=j){
+        for(j=i+1;j<na+nb && all[j]==all[i];++j) ;
+        tie+=(double)(j-i)*(j-i)*(j-i)-(j-i);
+    }
+    mu=0.5*na*nb;
+    var=(double)na*nb/12.0*((N+1.0)-tie/(N*(N-1.0)));
+    if(var<=0.0) return (u>mu)? 0.0 : 1.0;
+    return 0.5*erfc_local((u-mu-0.5)/sqrt(2.0*var));
+}
+/* г׼ͬĻʱǲͬУ */
+static void perf_env_diff_local(const PerfEnv* b,const PerfEnv* e){
+    const char *keys[6], *bv[6], *ev[6]; int i, nd=0;
+    keys[0]="os";       bv[0]=b->os;       ev[0]=e->os;
+    keys[1]="compiler"; bv[1]=b->compiler; ev[1]=e->compiler;
+    keys[2]="cpu";      bv[2]=b->cpu;      ev[2]=e->cpu;
+    keys[3]="governor"; bv[3]=b->governor; ev[3]=e->governor;
+    keys[4]="clock";    bv[4]=b->clock;    ev[4]=e->clock;
+    keys[5]="corpus";   bv[5]=b->corpus;   ev[5]=e->corpus;
+    for(i=0;i<6;++i){
+        if(strcmp(bv[i],ev[i])==0) continue;
+        if(!nd++) printf("ע⣺׼ͬԻǴ\n");
+        printf("  %-9s ׼ %s\n  %-9s ǰ %s\n",keys[i],bv[i],"",ev[i]);
+    }
+    if(b->opt!=e->opt){ if(!nd++) printf("ע⣺׼ͬԻǴ\n"); printf("  optimized ׼ %dǰ %d\n",b->opt,e->opt); }
+    if((b->pinned>=0)!=(e->pinned>=0)){ if(!nd++) printf("ע⣺׼ͬԻǴ\n"); printf("  pinned    ׼ %dǰ %d\n",b->pinned,e->pinned); }
+    if(nd) printf("\n");
+}
+/* ٶȲգ޹صĹ̶/ѭһ
+ * ı仯ӳƵʻصƯƣ--normalize ʱλ֮Ȼ㵱ǰ */
+static void perf_ref_local(long n){
+    calc_u32 x=12345u; double acc=0.0; long i; int k;
+    for(i=0;i<n;++i){
+        for(k=0;k<64;++k){ x=x*1664525u+1013904223u; acc=acc*0.999+(double)(x>>16); }
+    }
+    g_bench_sink+=acc;
+}
+static const BenchCase g_perf_ref={"ref_loop","̶ѭٶȲգ",perf_ref_local};
+/* ȸÿԤȣٰθÿһʹʱԵĸŷ̯Ǽĳһ
+ * ֻ on[c]  */
+static void perf_sample_local(PerfCase* pc,const BenchCase* const* bcs,const int* on,int nc,int reps){
+    int c, k, r;
+    for(c=0;c<nc;++c) if(on[c]) for(k=0;k<BENCH_WARMUP;++k) bench_sample_local(bcs[c]->run,pc[c].ops);
+    for(r=0;r<reps;++r)
+        for(c=0;c<nc;++c) if(on[c]) pc[c].ns[r]=1e9*bench_sample_local(bcs[c]->run,pc[c].ops)/(double)pc[c].ops;
+    for(c=0;c<nc;++c) if(on[c]){ pc[c].n=reps; bench_sort_local(pc[c].ns,reps); }
+}
+/* calc --perfcheck ׼.json [--save] [--reps R] [--threshold ٷֱ] [--alpha A] [--retries K] [--normalize] [--no-pin] [--corpus f] [Ӵ]
+ * Ϊ˵ٸ K Σÿζ˲˳룺0 ޻ˣд׼1 лˣ2 ׼ļϴ */
+static int perfcheck_main_local(int argc,char** argv){
+    static const BenchCase* bcs[PERF_MAX_CASES];
+    static PerfCase* bp[PERF_MAX_CASES];
+    static int on[PERF_MAX_CASES], verdict[PERF_MAX_CASES], nret[PERF_MAX_CASES];
+    static double chg[PERF_MAX_CASES], pslow[PERF_MAX_CASES], sc[BENCH_MAX_REPS];
+    const char *file=NULL, *filter=NULL, *cfile=NULL; char** loaded=NULL;
+    int save=0, pin=1, norm=0, reps=0, retries=2, i, c, t, nb=0, nc=0, nreg=0, nfast=0, rc=0;
+    double thr=10.0, alpha=0.01, drift=1.0; PerfEnv env, benv; PerfCase *base=NULL, *cur=NULL; FILE* fp;
+    for(i=2;i<argc;++i){
+        if(strcmp(argv[i],"--save")==0) save=1;
+        else if(strcmp(argv[i],"--no-pin")==0) pin=0;
+        else if(strcmp(argv[i],"--normalize")==0) norm=1;
+        else if(strcmp(argv[i],"--reps")==0 && i+1<argc) reps=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--threshold")==0 && i+1<argc) thr=atof(argv[++i]);
+        else if(strcmp(argv[i],"--alpha")==0 && i+1<argc) alpha=atof(argv[++i]);
+        else if(strcmp(argv[i],"--retries")==0 && i+1<argc) retries=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--corpus")==0 && i+1<argc) cfile=argv[++i];
+        else if(!file) file=argv[i];
+        else filter=argv[i];
+    }
+    if(!file || thr<0 || !(alpha>0 && alpha<1) || retries<0){
+        printf("÷: calc --perfcheck ׼.json [--save] [--reps R] [--threshold ٷֱ] [--alpha A] [--retries K] [--normalize] [--no-pin] [--corpus f] [Ӵ]\n");
+        return 2;
+    }
+    base=(PerfCase*)calc_malloc(MEM_OTHER,sizeof(PerfCase)*PERF_MAX_CASES);
+    cur=(PerfCase*)calc_malloc(MEM_OTHER,sizeof(PerfCase)*PERF_MAX_CASES);
+    if(!(fp=fopen(file,"rb"))) save=1;   /* ׼ڣ¼ */
+    if(!base || !cur){ printf("ڴ治\n"); rc=2; }
+    else if(!save && !perf_load_local(fp,&benv,base,&nb)){ printf("޷ȡ׼ %sӦΪ --perfcheck дļ\n",file); rc=2; }
+    if(fp) fclose(fp);
+    if(!rc){
+        if(reps<=0) reps=(!save && benv.reps>0)? benv.reps : 30;
+        if(reps<5) reps=5;
+        if(reps>BENCH_MAX_REPS) reps=BENCH_MAX_REPS;
+        if(!save && !cfile && strcmp(benv.corpus,"builtin")!=0) cfile=benv.corpus;   /* û׼ */
+        if(!bench_prepare_local(cfile,&loaded)) rc=2;
+    }
+    if(!rc){
+        perf_env_local(&env,pin? calc_pin_cpu() : -1,cfile,reps);
+        printf("ܻع飺%sÿ %d ʱ %s",save? "¼׼" : "ԱȻ׼",reps,env.clock);
+        if(env.pinned>=0) printf("̶ CPU %d\n",env.pinned); else printf("δ̶ CPU\n");
+        printf("CPU %sƵ %s %s%s\n",env.cpu,env.governor,env.compiler,env.opt==0? "δŻ" : "");
+        if(!save){
+            printf("׼ %s¼ %s %sֵ %.1f%% %g %d \n\n",file,benv.date,benv.build,thr,alpha,retries);
+            perf_env_diff_local(&benv,&env);
+        }else printf("\n");
+        /*  0 ΪٶȲգԱʱֻ׼еû׼ÿ */
+        for(c=-1;(c<0 || g_bench_cases[c].name) && nc<PERF_MAX_CASES;++c){
+            const BenchCase* bc=(c<0)? &g_perf_ref : &g_bench_cases[c]; PerfCase* b=NULL;
+            if(c>=0 && filter && !strstr(bc->name,filter)) continue;
+            for(i=0;i<nb && !b;++i) if(strcmp(base[i].name,bc->name)==0) b=&base[i];
+            if(!save && !b && c>=0){ printf("%-14s ׼޴\n",bc->name); continue; }
+            bcs[nc]=bc; bp[nc]=b; on[nc]=1; nret[nc]=0;
+            strcpy(cur[nc].name,bc->name);
+            cur[nc].ops=b? b->ops : bench_calibrate_local(bc);
+            nc++;
+        }
+        printf(" %d ...\n",nc-1); fflush(stdout);
+        perf_sample_local(cur,bcs,on,nc,reps);
+    }
+    if(!rc && save){
+        printf("%-14s %10s %12s %12s\n","Ŀ","/","λ ns/op","p99 ns/op");
+        for(c=0;c<nc;++c){
+            i=(int)ceil(0.99*reps)-1;
+            printf("%-14s %10ld %12.1f %12.1f\n",cur[c].name,cur[c].ops,bench_median_local(cur[c].ns,reps),cur[c].ns[i<0? 0 : i]);
+        }
+        if(perf_save_local(file,&env,cur,nc)) printf("\nд׼ %s%d \n",file,nc-1);
+        else { printf("\n޷д %s\n",file); rc=2; }
+    }else if(!rc){
+        for(t=0;;++t){
+            int nflag=0;
+            if(bp[0]) drift=bench_median_local(cur[0].ns,reps)/bench_median_local(bp[0]->ns,bp[0]->n);
+            for(c=1;c<nc;++c){
+                double mb, mc, f=(norm && drift>0)? drift : 1.0;
+                if(!on[c]) continue;
+                for(i=0;i<reps;++i) sc[i]=cur[c].ns[i]/f;
+                mb=bench_median_local(bp[c]->ns,bp[c]->n); mc=bench_median_local(sc,reps);
+                chg[c]=(mb>0)? 100.0*(mc/mb-1.0) : 0.0;
+                pslow[c]=perf_mwu_p_local(bp[c]->ns,bp[c]->n,sc,reps);
+                if(pslow[c]<alpha && chg[c]>thr) verdict[c]=1;
+                else if(perf_mwu_p_local(sc,reps,bp[c]->ns,bp[c]->n)<alpha && chg[c]<-thr) verdict[c]=-1;
+                else verdict[c]=0;
+                nret[c]+=(t>0);
+                on[c]=(verdict[c]==1); nflag+=on[c];
+            }
+            if(!nflag || t==retries) break;
+            printf(" %d ƻˣ %d Σ...\n",nflag,t+1); fflush(stdout);
+            perf_sample_local(cur,bcs,on,nc,reps);   /*  on[0] ʼΪ 1渴һز */
+        }
+        if(!bp[0]) printf("\n׼ûٶȲ ref_loop޷ƻٶȵƯ\n");
+        else {
+            printf("\nٶȲ ref_loop%+.1f%%%s\n",100.0*(drift-1.0),norm? "Ѱ˻" : "");
+            if(!norm && fabs(drift-1.0)*100.0>0.5*thr)
+                printf("ע⣺ѭı仯ѳֵһ룬Ƶʻ¼׼ʱͬۿܲɿɼ --normalize ز⣩\n");
+        }
+        printf("\n%-14s %12s %12s %9s %10s  %s\n","Ŀ","׼ ns/op","ǰ ns/op","仯","p()","");
+        for(c=1;c<nc;++c){
+            printf("%-14s %12.1f %12.1f %+8.1f%% %10.2g  %s",cur[c].name,bench_median_local(bp[c]->ns,bp[c]->n),
+                   bench_median_local(cur[c].ns,reps),chg[c],pslow[c],verdict[c]>0? "" : verdict[c]<0? "" : "ƽ");
+            if(nret[c]) printf(" %d Σ",nret[c]);
+            printf("\n");
+            nreg+=(verdict[c]>0); nfast+=(verdict[c]<0);
+        }
+        printf("\nۣ%d ˣ%d 죬%d ƽ\n",nreg,nfast,nc-1-nreg-nfast);
+        rc=nreg? 1 : 0;
+    }
+    bench_release_local(loaded);
+    calc_free(base); calc_free(cur);
+    return rc;
+}
 
 /* ------------ Լ죨Ҫ ------------ */
 typedef struct { const char* expr; double expect; double tol; } CaseItem;
 static int run_selftest_local(void){
-    int pass=0,total=0,i;
+    int pass=0,total=0,i,all_ok=1;
     CaseItem c1[]={
         {"1+2*3",7,1e-12},{"(2+3)*4",20,1e-12},{"-3^2",-9,1e-12},{"(-3)^2",9,1e-12},
         {"5!",120,1e-12},{"50%",0.5,1e-12},{"sqrt(2)^2",2,1e-12},{"ln(exp(1))",1,1e-12},
@@ -750,25 +7232,822 @@ static int run_selftest_local(void){
     g_mode=MODE_RAD;
     for(i=0;c1[i].expr;++i){ total++; if(eval_expr_local(c1[i].expr,&out,err,sizeof(err)) && fabs(out-c1[i].expect)<=c1[i].tol) pass++; }
     printf("SelfTest basic: %d/%d\n",pass,total);
-    return (pass==total)?0:1;
+    all_ok = all_ok && (pass==total);
+
+    /* ֵAv=vֵع */
+    pass=0; total=0;
+    {
+        double a2[4]={2,1,1,2}, a3[9]={2,-1,0,-1,2,-1,0,-1,2}, b[6]={3,0,4,5,1,2};
+        double w[3], v[9], u[6], sv[2], vt[6], r;
+        int j,k;
+        total++; if(mat_eig_sym(2,a2,w,v,err,sizeof(err)) && fabs(w[0]-1)<1e-12 && fabs(w[1]-3)<1e-12) pass++;
+        total++; if(mat_eig_sym(3,a3,w,v,err,sizeof(err)) && fabs(w[0]-(2-sqrt(2.0)))<1e-12 && fabs(w[1]-2)<1e-12 && fabs(w[2]-(2+sqrt(2.0)))<1e-12) pass++;
+        total++;
+        for(r=0,i=0;i<3;++i){ double av=0; for(k=0;k<3;++k) av+=a3[i*3+k]*v[k*3+2]; r+=fabs(av-w[2]*v[i*3+2]); }
+        if(r<1e-12) pass++;
+        total++; if(mat_svd(2,2,b,u,sv,vt,err,sizeof(err)) && fabs(sv[0]-sqrt(45.0))<1e-12 && fabs(sv[1]-sqrt(5.0))<1e-12) pass++;
+        total++;
+        if(mat_svd(2,3,b,u,sv,vt,err,sizeof(err))){
+            for(r=0,i=0;i<2;++i) for(j=0;j<3;++j){
+                double x=0; for(k=0;k<2;++k) x+=u[i*2+k]*sv[k]*vt[j*2+k];
+                r+=fabs(x-b[i*3+j]);
+            }
+            if(r<1e-12) pass++;
+        }
+    }
+    printf("SelfTest matrix: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ֵֵһ£ʧܵΪ NaN */
+    pass=0; total=0;
+    {
+        const char* names[2]={"x","y"}; CalcProgram prog;
+        double xs[100], ys[100], zs[100], ref, pt[2]={0.5,0.0};
+        const double* in[2]; int k, same=1;
+        for(k=0;k<100;++k){ xs[k]=-2.0+0.05*k; ys[k]=0.1*k; }
+        in[0]=xs; in[1]=ys;
+        total++;
+        if(calc_compile("x^2*y-sin(x)/2+pow(y,0.5)+pi",names,2,&prog,err,sizeof(err))){
+            calc_eval_batch(&prog,in,100,zs);
+            for(k=0;k<100;++k){
+                ref=xs[k]*xs[k]*ys[k]-sin(xs[k])/2+sqrt(ys[k])+M_PI;
+                if(fabs(zs[k]-ref)>1e-12) same=0;
+            }
+            if(same) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("sqrt(x)",names,1,&prog,err,sizeof(err))){
+            if(!isfinite(calc_eval_point(&prog,xs)) && fabs(calc_eval_point(&prog,pt)-sqrt(0.5))<1e-15) pass++;
+            calc_program_free(&prog);
+        }
+        total++; if(!calc_compile("x+undefined_v",names,1,&prog,err,sizeof(err))) pass++;
+    }
+    printf("SelfTest batch: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* FFT DFT Աȣ 2/4 2/3/5Bluestein */
+    pass=0; total=0;
+    {
+        static const int sizes[]={1,8,12,30,64,7,97,0};
+        CalcCplx x[128], y[128];
+        int t,k,j,n;
+        for(t=0;sizes[t];++t){
+            double maxerr=0.0;
+            n=sizes[t];
+            for(k=0;k<n;++k){ x[k].re=cos(0.3*k*k)+0.1*k; x[k].im=sin(1.7*k); }
+            total++;
+            if(!fft_forward(n,x,y,err,sizeof(err))) continue;
+            for(k=0;k<n;++k){
+                double re=0.0, im=0.0;
+                for(j=0;j<n;++j){
+                    double ang=-2.0*M_PI*(double)((long)j*k%n)/n;
+                    re+=x[j].re*cos(ang)-x[j].im*sin(ang);
+                    im+=x[j].re*sin(ang)+x[j].im*cos(ang);
+                }
+                if(fabs(re-y[k].re)+fabs(im-y[k].im)>maxerr) maxerr=fabs(re-y[k].re)+fabs(im-y[k].im);
+            }
+            if(maxerr<1e-9) pass++;
+        }
+        /* 󳤶ĲƵָӦ任ΪλڸƵ㡢ֵΪ n ĳ弤 */
+        total++;
+        {
+            CalcCplx *bx, *by; double maxerr=0.0;
+            n=3*FFT_FOURSTEP_MIN;
+            bx=(CalcCplx*)calc_malloc(MEM_OTHER,sizeof(CalcCplx)*(size_t)n);
+            by=(CalcCplx*)calc_malloc(MEM_OTHER,sizeof(CalcCplx)*(size_t)n);
+            if(bx && by){
+                for(k=0;k<n;++k){ double ang=2.0*M_PI*(double)((5L*k)%n)/n; bx[k].re=cos(ang); bx[k].im=sin(ang); }
+                if(fft_forward(n,bx,by,err,sizeof(err))){
+                    for(k=0;k<n;++k){
+                        double d=fabs(by[k].re-(k==5? n:0))+fabs(by[k].im);
+                        if(d>maxerr) maxerr=d;
+                    }
+                    if(maxerr<1e-6) pass++;
+                }
+            }
+            calc_free(bx); calc_free(by);
+        }
+        /* Bluestein ڲ㣨ĲʱʧʱӦ屨黹ʱǷδĽ */
+        total++;
+        {
+            CalcCplx *bx, *by; size_t i0;
+            n=2*65537;
+            bx=(CalcCplx*)calc_calloc(MEM_OTHER,(size_t)n,sizeof(CalcCplx));
+            by=(CalcCplx*)calc_malloc(MEM_OTHER,sizeof(CalcCplx)*(size_t)n);
+            if(bx && by && fft_forward(n,bx,by,err,sizeof(err))){
+                calc_arena_reset(); i0=g_arena.inuse;
+                g_mem[MEM_ARENA].limit=(double)g_mem[MEM_ARENA].cur+sizeof(ArenaHead)+sizeof(CalcCplx)*2.0*524288+1048576.0;
+                if(!fft_forward(n,bx,by,err,sizeof(err)) && g_arena.inuse==i0) pass++;
+                g_mem[MEM_ARENA].limit=0.0;
+                calc_arena_reset();
+            }
+            calc_free(bx); calc_free(by);
+        }
+    }
+    printf("SelfTest fft: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ͣ޺Ͳۼӡ2^53 ޡ */
+    pass=0; total=0;
+    {
+        double v, e2; int nt; const char* mth;
+        total++; if(sum_finite("k","k",1,100,&v,err,sizeof(err)) && v==5050.0) pass++;
+        total++; if(sum_finite("0.1","k",1,10,&v,err,sizeof(err)) && v==1.0) pass++;
+        total++; if(sum_finite("k-9007199254740000","k",9007199254740000.0,9007199254740991.0,&v,err,sizeof(err)) && v==491536.0
+                    && !sum_finite("1","k",1e16,1e16,&v,err,sizeof(err)) && !sum_finite("1","k",1,1e10,&v,err,sizeof(err)) && strstr(err,"")) pass++;
+        total++; if(sum_infinite("1/k^2","k",1,&v,&e2,&nt,&mth,err,sizeof(err)) && fabs(v-M_PI*M_PI/6)<1e-12) pass++;
+        total++; if(sum_infinite("(-1)^k/(2*k+1)","k",0,&v,&e2,&nt,&mth,err,sizeof(err)) && fabs(v-M_PI/4)<1e-12) pass++;
+        total++; if(sum_infinite("1/k!","k",0,&v,&e2,&nt,&mth,err,sizeof(err)) && fabs(v-exp(1.0))<1e-13) pass++;
+        /* Levin ʱʮͣRichardson  8192 ƲΪ 0 */
+        total++; if(sum_infinite("1/k^4","k",1,&v,&e2,&nt,&mth,err,sizeof(err)) && fabs(v-pow(M_PI,4)/90)<1e-12 && nt<=SUM_ACCEL_TERMS && e2>0.0) pass++;
+        total++; if(sum_infinite("1/k^2","k",1,&v,&e2,&nt,&mth,err,sizeof(err)) && nt<SUM_RICH_TERMS && e2>0.0) pass++;
+    }
+    printf("SelfTest sum: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ˻ռ䣩ֵ */
+    pass=0; total=0;
+    {
+        double la, v, e2; int sg; CalcProgram prog; const char* names[1]={"x"};
+        total++; if(prod_finite("k","k",1,20,&la,&sg,err,sizeof(err)) && sg==1 && fabs(exp(la)/2432902008176640000.0-1)<1e-13) pass++;
+        total++; if(prod_finite("-k","k",1,1000,&la,&sg,err,sizeof(err)) && sg==1 && fabs(la-lgamma(1001.0))<1e-9
+                    && !prod_finite("1","k",1e16,1e16,&la,&sg,err,sizeof(err)) && !prod_finite("1","k",0,1e9,&la,&sg,err,sizeof(err))) pass++;
+        total++;
+        if(calc_compile("sin(x)/x",names,1,&prog,err,sizeof(err))){
+            if(limit_side(&prog,0.0,0,1,&v,&e2,err,sizeof(err)) && fabs(v-1)<1e-12) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("(1+1/x)^x",names,1,&prog,err,sizeof(err))){
+            if(limit_side(&prog,0.0,1,1,&v,&e2,err,sizeof(err)) && fabs(v-exp(1.0))<1e-10) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("1/x",names,1,&prog,err,sizeof(err))){
+            if(!limit_side(&prog,0.0,0,1,&v,&e2,err,sizeof(err))) pass++;
+            calc_program_free(&prog);
+        }
+    }
+    printf("SelfTest prod/limit: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ɨ */
+    pass=0; total=0;
+    {
+        SweepAxis ax[3]; SweepStats st; FILE* fp; char line[MAX_LINE]; int rows=0;
+        strcpy(ax[0].name,"x"); ax[0].a=0; ax[0].b=1; ax[0].n=11;
+        strcpy(ax[1].name,"y"); ax[1].a=-2; ax[1].b=2; ax[1].n=5;
+        strcpy(ax[2].name,"z"); ax[2].a=0; ax[2].b=0; ax[2].n=1;
+        total++; if(sweep_run("(x-0.3)^2+(y+1)^2",ax,2,NULL,NULL,&st,0,err,sizeof(err)) && st.npts==55 && fabs(st.vmin)<1e-15) pass++;
+        total++; if(fabs(st.argmin[0]-0.3)<1e-15 && st.argmin[1]==-1 && fabs(st.vmax-9.49)<1e-12 && st.argmax[0]==1 && st.argmax[1]==2) pass++;
+        total++;
+        fp=tmpfile();
+        if(fp && sweep_run("x*y+z",ax,3,fp,NULL,&st,0,err,sizeof(err))){
+            rewind(fp);
+            while(fgets(line,sizeof(line),fp)) rows++;
+            if(rows==56 && st.nbad==0) pass++;
+        }
+        if(fp) fclose(fp);
+    }
+    printf("SelfTest sweep: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ؿ */
+    pass=0; total=0;
+    {
+        CalcRng r, r2; McVar mv[2]; McStats st, st2; double s1=0, s2=0, z; int i;
+        r.s[0]=1; r.s[1]=2; r.s[2]=3; r.s[3]=4;
+        total++; if(rng_next(&r)==41943041UL && rng_next(&r)==58720359UL) pass++;   /* οʵǰ */
+        rng_seed(&r,1); r2=r; rng_jump(&r2);
+        total++; if(r2.s[0]!=r.s[0] && rng_next(&r2)!=rng_next(&r)) pass++;
+        rng_seed(&r,12345);
+        for(i=0;i<200000;++i){ z=rng_normal(&r); s1+=z; s2+=z*z; }
+        total++; if(fabs(s1/200000)<0.01 && fabs(s2/200000-1.0)<0.02) pass++;
+        strcpy(mv[0].name,"x"); mv[0].dist=MC_DIST_U; mv[0].p1=0; mv[0].p2=1;
+        strcpy(mv[1].name,"y"); mv[1].dist=MC_DIST_N; mv[1].p1=2; mv[1].p2=0.5;
+        total++;
+        if(mc_run("x^2+y",mv,2,200000,7,&st,0,err,sizeof(err)) && mc_run("x^2+y",mv,2,200000,7,&st2,0,err,sizeof(err)))
+            if(st.mean==st2.mean && fabs(st.mean-(1.0/3+2))<5*sqrt(st.m2/(st.n-1)/st.n)) pass++;
+        total++; if(mc_run("rand()",mv,0,100000,7,&st,0,err,sizeof(err)) && fabs(st.mean-0.5)<0.005 && g_rng_active==&g_rng) pass++;
+    }
+    printf("SelfTest rng/mc: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ά */
+    pass=0; total=0;
+    {
+        SobolGen* sg=(SobolGen*)calc_malloc(MEM_OTHER,sizeof(SobolGen)); unsigned long pt[2];
+        const char* nm[6]={"x","y","z","u","v","w"}; double lo[6]={0,0,0,0,0,0}, hi[6]={1,1,1,1,1,1};
+        CalcProgram prog; IntegnResult res;
+        total++;
+        if(sg){
+            int okp=1;
+            sobol_init(sg,2);
+            sobol_next(sg,pt); okp=okp && pt[0]==0 && pt[1]==0;
+            sobol_next(sg,pt); okp=okp && pt[0]==0x80000000UL && pt[1]==0x80000000UL;
+            sobol_next(sg,pt); okp=okp && pt[0]==0xC0000000UL && pt[1]==0x40000000UL;
+            if(okp) pass++;
+            calc_free(sg);
+        }
+        total++;
+        if(calc_compile("x*y*z^3",nm,3,&prog,err,sizeof(err))){
+            if(integn_gm(&prog,3,lo,hi,1e-10,1e-14,100000,&res,err,sizeof(err)) && fabs(res.val-1.0/16)<1e-15) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        lo[0]=lo[1]=-3; hi[0]=hi[1]=3;
+        if(calc_compile("exp(-(x^2+y^2))",nm,2,&prog,err,sizeof(err))){
+            if(integn_gm(&prog,2,lo,hi,1e-9,1e-14,GM_DEFAULT_MAXEVAL,&res,err,sizeof(err))
+               && fabs(res.val-3.14145385643669)<1e-8) pass++;
+            calc_program_free(&prog);
+        }
+        lo[0]=lo[1]=0; hi[0]=hi[1]=1;
+        total++;
+        if(calc_compile("exp(-(x^2+y^2+z^2+u^2+v^2+w^2))",nm,6,&prog,err,sizeof(err))){
+            double ex=pow(0.746824132812427,6.0);
+            if(integn_qmc(&prog,6,lo,hi,1L<<18,0,1,&res,err,sizeof(err)) && fabs(res.val-ex)<5*res.err+1e-12 && res.err<1e-5) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("x*y",nm,2,&prog,err,sizeof(err))){
+            if(integn_qmc(&prog,2,lo,hi,1L<<16,1,1,&res,err,sizeof(err)) && fabs(res.val-0.25)<1e-3) pass++;
+            calc_program_free(&prog);
+        }
+    }
+    printf("SelfTest integn: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* Ӧ GaussCKronrod */
+    pass=0; total=0;
+    {
+        double v, e2; long nev;
+        total++; if(integ_adaptive("x^3","x",0,2,&v,&e2,&nev,err,sizeof(err)) && fabs(v-4)<1e-14 && nev==15) pass++;
+        total++; if(integ_adaptive("exp(-(x^2))","x",-HUGE_VAL,HUGE_VAL,&v,&e2,&nev,err,sizeof(err)) && fabs(v-sqrt(M_PI))<1e-13) pass++;
+        total++; if(integ_adaptive("1/(1+x^2)","x",0,HUGE_VAL,&v,&e2,&nev,err,sizeof(err)) && fabs(v-M_PI/2)<1e-13) pass++;
+        total++; if(integ_adaptive("ln(x)","x",1,0,&v,&e2,&nev,err,sizeof(err)) && fabs(v-1)<1e-12) pass++;
+        total++; if(integ_adaptive("sin(1/x)","x",0.001,1,&v,&e2,&nev,err,sizeof(err)) && fabs(v-0.504066497877487)<1e-11 && e2<1e-10) pass++;
+    }
+    printf("SelfTest integ: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /*  */
+    pass=0; total=0;
+    {
+        const char* nm[2]={"x","p"}; CalcProgram prog; TrackInfo info; double *ps=NULL, *xs=NULL;
+        total++;
+        if(calc_compile("x^2-p",nm,2,&prog,err,sizeof(err))){
+            if(track_run(&prog,1,4,30,1.2,NULL,&ps,&xs,&info,err,sizeof(err))){
+                if(info.reached && fabs(info.x_end-2)<1e-12 && info.nturn==0) pass++;
+                calc_free(ps); calc_free(xs);
+            }
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("x^3-x+p",nm,2,&prog,err,sizeof(err))){
+            if(track_run(&prog,-1,1,40,-1.5,NULL,&ps,&xs,&info,err,sizeof(err))){
+                if(info.nturn==2 && fabs(info.turn_p[0]-2/sqrt(27.0))<1e-8 && fabs(info.turn_x[0]-1/sqrt(3.0))<1e-7
+                   && fabs(info.turn_p[1]+2/sqrt(27.0))<1e-8 && fabs(info.x_end+1.324717957244746)<1e-10) pass++;
+                calc_free(ps); calc_free(xs);
+            }
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("x^2+p",nm,2,&prog,err,sizeof(err))){
+            /* ۻ p0 һֹͣյһ֧ */
+            if(track_run(&prog,-1,1,20,1,NULL,&ps,&xs,&info,err,sizeof(err))){
+                if(info.nturn==1 && fabs(info.turn_p[0])<1e-8 && !info.reached && xs[info.npts-1]<0) pass++;
+                calc_free(ps); calc_free(xs);
+            }
+            calc_program_free(&prog);
+        }
+    }
+    printf("SelfTest track: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /*  */
+    pass=0; total=0;
+    {
+        const char* nm[2]={"x","a"}; CalcProgram prog; SolveManyStats st;
+        double ps[200], roots[200]; unsigned char status[200]; int i, okc;
+        for(i=0;i<200;++i) ps[i]=-8.0+16.0*i/199.0;
+        total++;
+        if(calc_compile("x^3-a",nm,2,&prog,err,sizeof(err))){
+            solvemany_run(&prog,ps,200,1.0,30,1e-12,roots,status,&st);
+            for(i=0,okc=1;i<200;++i) if(fabs(roots[i]*roots[i]*roots[i]-ps[i])>1e-9) okc=0;
+            if(okc && st.n_fail==0 && st.n_newton>0) pass++;
+            /* x0=0 Ϊ 0ȫ Brent  */
+            total++;
+            solvemany_run(&prog,ps,200,0.0,30,1e-12,roots,status,&st);
+            for(i=0,okc=1;i<200;++i) if(fabs(roots[i]*roots[i]*roots[i]-ps[i])>1e-9) okc=0;
+            if(okc && st.n_brent>=199 && st.n_fail==0) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        if(calc_compile("x^2+a",nm,2,&prog,err,sizeof(err))){
+            for(i=0;i<10;++i) ps[i]=1.0+i;
+            solvemany_run(&prog,ps,10,1.0,30,1e-12,roots,status,&st);
+            if(st.n_fail==10 && status[0]==SM_FAIL) pass++;
+            calc_program_free(&prog);
+        }
+    }
+    printf("SelfTest solvemany: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ⺯κղοֵ */
+    pass=0; total=0;
+    {
+        CaseItem c2[]={
+            {"gamma(0.5)",1.7724538509055160,1e-15},{"2.5!",3.3233509704478426,1e-15},
+            {"lgamma(100)",359.13420536957540,1e-15},{"beta(2.5,1.5)",0.19634954084936207,1e-14},
+            {"erf(0.5)",0.52049987781304654,1e-15},{"erfc(10)",2.0884875837625448e-45,1e-13},
+            {"erfinv(0.5)",0.47693627620446987,1e-15},{"besselj(5,10)",-0.23406152818679364,1e-14},
+            {"bessely(0,1)",0.088256964215676956,1e-14},{"zeta(2)",1.6449340668482264,1e-15},
+            {"max(1,5,3)",5,0},{"min(4,-2)",-2,0},{"hypot(1,2,2)",3,1e-15},
+            {"atan2(1,-1)",2.3561944901923449,1e-15},{"round(-2.5)+floor(1.5)+ceil(1.2)",0,0},
+            {NULL,0,0}
+        };
+        g_mode=MODE_RAD;
+        for(i=0;c2[i].expr;++i){
+            total++;
+            if(eval_expr_local(c2[i].expr,&out,err,sizeof(err))
+               && fabs(out-c2[i].expect)<=c2[i].tol*(c2[i].expect!=0?fabs(c2[i].expect):1.0)) pass++;
+        }
+        total++; if(!eval_expr_local("pow(2)",&out,err,sizeof(err))) pass++;
+        total++; if(!eval_expr_local("(-2)!",&out,err,sizeof(err))) pass++;
+        /* ʶɺ֣x2 һ x*2 */
+        total++;
+        {
+            char cl[]="/let x2=3", cm[160];
+            var_set("x",10.0);
+            if(handle_command_local(cl,cm,sizeof(cm)) && eval_expr_local("x2*2",&out,err,sizeof(err)) && out==6.0) pass++;
+            var_del("x2"); var_del("x");
+        }
+    }
+    printf("SelfTest special: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ٽģʽ libm Ͻ磬Χһ */
+    pass=0; total=0;
+    {
+        const char* fx[]={"sin(x)+cos(3*x)","exp(x/2)","ln(x+21)","(x+21)^2.5","x^3-x^-2",NULL};
+        const double tol[]={1e-8,1e-7,1e-8,1e-7,1e-12};
+        const char* nm[1]={"x"}; CalcProgram prog; const double* in[1];
+        double xs[300], y0[300], y1[300], e; int j, k;
+        for(j=0;j<300;++j) xs[j]=-20.0+40.0*j/299.0;
+        in[0]=xs;
+        for(k=0;fx[k];++k){
+            total++;
+            if(calc_compile(fx[k],nm,1,&prog,err,sizeof(err))){
+                calc_eval_batch(&prog,in,300,y0);
+                prog.fast=1; calc_eval_batch(&prog,in,300,y1);
+                for(j=0,e=0;j<300;++j){
+                    double d;
+                    if((y0[j]!=y0[j]) != (y1[j]!=y1[j])) d=1.0;   /* NaN λñһ */
+                    else d=fabs(y1[j]-y0[j])/(fabs(y0[j])>1.0? fabs(y0[j]) : 1.0);
+                    if(d>e) e=d;
+                }
+                if(e<=tol[k]) pass++;
+                calc_program_free(&prog);
+            }
+        }
+        total++;
+        {
+            double v[4]={0.0,-1.0,1e200,1e6}, w[4]={-2.0,0.5,2.0,1e6};
+            double r[4]; int okc;
+            memcpy(r,v,sizeof r); fast_pow_batch(r,w,4);
+            okc = r[0]!=r[0] && r[1]!=r[1] && r[2]!=r[2] && r[3]!=r[3];
+            memcpy(r,v,sizeof r); fast_log_batch(r,4);
+            okc = okc && r[0]!=r[0] && r[1]!=r[1] && fabs(r[3]-log(1e6))<1e-12;
+            if(okc) pass++;
+        }
+    }
+    printf("SelfTest fast: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* float32 · double ·գͬΪ NaN */
+    pass=0; total=0;
+    {
+        const char* fx[]={"sin(x)*exp(-x^2)+ln(x+5)+cos(3*x)","x^3-2*x","sqrt(abs(x))+erf(x)",NULL};
+        const char* nm[1]={"x"}; CalcProgram prog; const double* in[1]; const float* fin[1];
+        double xs[200], y0[200], e; float xf[200], yf[200]; int j, k;
+        for(j=0;j<200;++j){ xf[j]=(float)(-4.0+8.0*j/199.0); xs[j]=xf[j]; }
+        in[0]=xs; fin[0]=xf;
+        for(k=0;fx[k];++k){
+            total++;
+            if(calc_compile(fx[k],nm,1,&prog,err,sizeof(err))){
+                calc_eval_batch(&prog,in,200,y0);
+                calc_eval_batch_f32(&prog,fin,200,yf);
+                for(j=0,e=0;j<200;++j){
+                    double d=fabs(yf[j]-y0[j])/(fabs(y0[j])>1.0? fabs(y0[j]) : 1.0);
+                    if(d>e) e=d;
+                }
+                if(e<=2e-6) pass++;
+                calc_program_free(&prog);
+            }
+        }
+        total++;
+        if(calc_compile("ln(x)+1/(x-1)",nm,1,&prog,err,sizeof(err))){
+            xs[0]=-1.0; xs[1]=1.0; xs[2]=2.0; prog.f32=1;
+            calc_eval_batch(&prog,in,3,y0);
+            if(y0[0]!=y0[0] && y0[1]!=y0[1] && fabs(y0[2]-(log(2.0)+1.0))<1e-6) pass++;
+            calc_program_free(&prog);
+        }
+        total++;
+        {
+            SweepAxis ax[2]; SweepStats st;
+            sweep_parse_axis("x=-1:1:11",&ax[0],err,sizeof(err)); sweep_parse_axis("y=-2:0:5",&ax[1],err,sizeof(err));
+            if(sweep_run("(x-0.4)^2+(y+1)^2",ax,2,NULL,NULL,&st,CALC_OPT_F32,err,sizeof(err))
+               && fabs(st.vmin)<1e-6 && fabs(st.argmin[0]-0.4)<1e-12 && fabs(st.argmin[1]+1.0)<1e-12) pass++;
+        }
+    }
+    printf("SelfTest f32: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ˫˫ȣʮƲοֵȶԣ 1e-30 */
+    pass=0; total=0;
+    {
+        const char* ex[]={"1/3","sin(1)","exp(1)","ln(2)","sqrt(2)","tan(1)","atan(1)*4","exp(-30)",NULL};
+        const char* rf[]={"0.333333333333333333333333333333333333",
+                          "0.841470984807896506652502321630298999",
+                          "2.718281828459045235360287471352662498",
+                          "0.693147180559945309417232121458176568",
+                          "1.414213562373095048801688724209698079",
+                          "1.557407724654902230506974807458360173",
+                          "3.141592653589793238462643383279502884",
+                          "9.357622968840174604915832223378706744e-14"};
+        CalcDD v, r; char buf[64]; double e; int k; PrecMode pm=g_prec; AngleMode am=g_mode;
+        g_mode=MODE_RAD;
+        for(k=0;ex[k];++k){
+            total++;
+            r=dd_parse_local(rf[k],strlen(rf[k]));
+            if(eval_expr_dd_local(ex[k],&v,err,sizeof(err))){
+                e=fabs(dd_sub(v,r).hi)/fabs(r.hi);
+                if(e<=1e-30) pass++;
+            }
+        }
+        total++;
+        dd_format_local(DD_PI,32,buf,sizeof(buf));
+        if(strcmp(buf,"3.1415926535897932384626433832795")==0) pass++;
+        total++;
+        {
+            double es; long ne;
+            r=dd_parse_local("0.746824132812427025399467436131853",35);
+            if(integ_tanhsinh_dd("exp(-(x^2))","x",0.0,1.0,&v,&es,&ne,err,sizeof(err))
+               && fabs(dd_sub(v,r).hi)<=1e-30) pass++;
+        }
+        total++;
+        r=dd_div_d(dd_make(1000.0,0.0),1001.0);
+        if(sum_finite_dd("1/(k*(k+1))","k",1.0,1000.0,&v,err,sizeof(err)) && fabs(dd_sub(v,r).hi)<=1e-30) pass++;
+        total++;   /*  double һõ inf  NaN䳬 2^53  */
+        v=dd_mul(dd_make(1e300,0.0),dd_make(1e10,0.0)); r=dd_add(dd_make(-1e308,0.0),dd_make(-1e308,0.0));
+        if(v.hi==HUGE_VAL && r.hi==-HUGE_VAL && !sum_finite_dd("1","k",1e16,1e16,&v,err,sizeof(err))) pass++;
+        g_prec=pm; g_mode=am;
+    }
+    printf("SelfTest dd: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ȷ num/den ıȶԣǾȷΪ "~" */
+    pass=0; total=0;
+    {
+        const char* ex[]={"1/3+1/6","0.1+0.2-0.3","2^100","25!/23!","(2/3)^-3","-1.25e-3*4",
+                          "floor(-7/2)","round(-5/2)","max(1/3,0.333,2/7)","sqrt(2)*sqrt(2)","0x10/3",NULL};
+        const char* rf[]={"1/2","0","1267650600228229401496703205376","600","27/8","-1/200",
+                          "-4","-3","1/3","~","16/3"};
+        ExVal v; char* t; int k;
+        for(k=0;ex[k];++k){
+            total++;
+            if(eval_expr_exact_local(ex[k],&v,err,sizeof(err))){
+                if(!v.exact){ if(strcmp(rf[k],"~")==0) pass++; }
+                else{
+                    t=rat_to_str(&v.q);
+                    if(t && strcmp(t,rf[k])==0) pass++;
+                    calc_free(t); rat_free(&v.q);
+                }
+            }
+        }
+        total++;
+        {
+            CalcRat r; int inx;
+            rat_init(&r);
+            if(sum_finite_exact("1/k","k",1.0,20.0,&r,&inx,err,sizeof(err)) && !inx){
+                t=rat_to_str(&r);
+                if(t && strcmp(t,"55835135/15519504")==0 && !sum_finite_exact("1","k",1e16,1e16,&r,&inx,err,sizeof(err))) pass++;
+                calc_free(t);
+            }
+            rat_free(&r);
+        }
+        total++;
+        {   /*  limb  Lehmer ·gcd((2^200-1)*3^50,(2^150-1)*3^40)=(2^50-1)*3^40 */
+            const char* a="1153617588319010271378133306175011326520419737189530113840977117561441452306548792375";
+            const char* b="17351999975129946189257838438103207095944895210165596199334189023";
+            CalcRat x, y; CalcBig g;
+            rat_init(&x); rat_init(&y); big_init(&g);
+            if(rat_parse_dec(&x,a,strlen(a))==1 && rat_parse_dec(&y,b,strlen(b))==1 && big_gcd(&g,&x.num,&y.num)){
+                t=big_to_dec(&g);
+                if(t && strcmp(t,"41064943223327914583404557669255069")==0) pass++;
+                calc_free(t);
+            }
+            rat_free(&x); rat_free(&y); big_free(&g);
+        }
+        total++;
+        {   /* ת double Ϊȷ */
+            const char* lit[]={"1/3","0.1","2/3","123456789012345678901234567890/7"};
+            double want[4]; int ok=1;
+            want[0]=1.0/3.0; want[1]=0.1; want[2]=2.0/3.0; want[3]=1.763668414462081e28;
+            for(k=0;k<4;++k){
+                if(eval_expr_exact_local(lit[k],&v,err,sizeof(err)) && v.exact){
+                    if(rat_to_double(&v.q)!=want[k]) ok=0;
+                    rat_free(&v.q);
+                }else ok=0;
+            }
+            if(ok) pass++;
+        }
+    }
+    printf("SelfTest exact: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* Աģʽλ//µλģʽok=0 ʾӦ */
+    pass=0; total=0;
+    {
+        struct { int bits, sgn, checked; const char* e; calc_u64 want; int ok; } pc[]={
+            {64,0,0,"0xFFFF_FFFF_FFFF_FFFF+1",0,1},
+            {64,0,1,"0xFFFF_FFFF_FFFF_FFFF+1",0,0},
+            {8,1,0,"127+1",CALC_U64(0xFFFFFFFFu,0xFFFFFF80u),1},
+            {8,1,1,"-128/-1",0,0},
+            {8,0,0,"-1",0xFF,1},
+            {32,0,0,"rotl(0x80000001,1)+rotr(1,1)",CALC_U64(0,0x80000003u),1},
+            {32,0,0,"popcount(0xF0F0F0F0)*100+clz(1)+ctz(0)",1663,1},
+            {16,1,0,"(-16>>2)*100+(-7/2)*10+(-7%2)",(calc_u64)0-431,1},
+            {64,1,1,"3037000499*3037000499",CALC_U64(0x7FFFFFFEu,0x9EA1DC29u),1},
+            {64,1,1,"3037000500*3037000500",0,0},
+            {64,1,1,"-9223372036854775808",CALC_U64(0x80000000u,0),1},
+            {64,0,0,"1+2<<3 | 6&3 ^ 0b1",27,1},
+            {64,0,0,"1<<64",0,0}
+        };
+        ProgMode pm=g_prog; calc_u64 x; int k;
+        for(k=0;k<(int)(sizeof(pc)/sizeof(pc[0]));++k){
+            total++;
+            g_prog.bits=pc[k].bits; g_prog.sgn=pc[k].sgn; g_prog.checked=pc[k].checked;
+            if(eval_prog_local(pc[k].e,&x,err,sizeof(err))? (pc[k].ok && x==pc[k].want) : !pc[k].ok) pass++;
+        }
+        g_prog=pm;
+    }
+    printf("SelfTest prog: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ˷תKaratsuba/Barrett ս̿㷨תִ֪ */
+    pass=0; total=0;
+    {
+        static const struct { int b; long e; int sub, base; char head, rest; long nrest; } rc[]={
+            {3,20000,0,3,'1','0',20000}, {3,20000,1,3,'2','2',19999},
+            {10,3000,0,10,'1','0',3000}, {10,3000,1,10,'9','9',2999},
+            {36,500,0,36,'1','0',500},   {2,201,0,8,'1','0',67}, {2,200,1,16,'F','F',49}
+        };
+        CalcBig a, b, c, d, q, r; calc_u32 s=12345u, *ref=NULL; char *t, *u; int k, i, ok;
+        big_init(&a); big_init(&b); big_init(&c); big_init(&d); big_init(&q); big_init(&r);
+        for(k=0;k<3;++k){   /* 300x3001000x77517x130  limb  */
+            int na=(k==0)? 300 : (k==1)? 1000 : 517, nb=(k==0)? 300 : (k==1)? 77 : 130;
+            total++;
+            ok=big_reserve(&a,na) && big_reserve(&b,nb) && (ref=(calc_u32*)calc_malloc(MEM_OTHER,sizeof(calc_u32)*(size_t)(na+nb)))!=NULL;
+            if(ok){
+                for(i=0;i<na;++i){ s=s*1103515245u+12345u; a.d[i]=s; }
+                for(i=0;i<nb;++i){ s=s*1103515245u+12345u; b.d[i]=s|1u; }
+                a.n=na; b.n=nb; big_trim(&a);
+                limb_mul_school(ref,a.d,a.n,b.d,nb);
+                if(big_mul(&c,&a,&b) && c.n==a.n+nb && memcmp(c.d,ref,sizeof(calc_u32)*(size_t)c.n)==0) pass++;
+            }
+            calc_free(ref); ref=NULL;
+        }
+        total++;
+        {   /* Barrett(7^6000)^2-1  7^6000̡ӦΪ 7^6000-1 */
+            ok=big_set_u64(&d,1);
+            for(i=0;ok && i<6000;++i) ok=big_mul_small(&d,7,0);
+            ok=ok && big_recip(&c,&d) && big_mul(&a,&d,&d) && big_set_u64(&b,1) && big_sub(&a,&a,&b)
+               && big_sub(&b,&d,&b) && big_divmod_pre(&q,&r,&a,&d,&c);
+            if(ok && big_cmp(&q,&b)==0 && big_cmp(&r,&b)==0) pass++;
+        }
+        for(k=0;k<(int)(sizeof(rc)/sizeof(rc[0]));++k){
+            long j;
+            total++;
+            ok=big_set_u64(&a,1);
+            for(j=0;ok && j<rc[k].e;++j) ok=big_mul_small(&a,(calc_u32)rc[k].b,0);
+            if(ok && rc[k].sub) ok=big_set_u64(&b,1) && big_sub(&a,&a,&b);
+            t=ok? big_to_base(&a,rc[k].base) : NULL;
+            if(t && (long)strlen(t)==rc[k].nrest+1 && t[0]==rc[k].head){
+                for(j=1;j<=rc[k].nrest && t[j]==rc[k].rest;++j) ;
+                if(j>rc[k].nrest) pass++;
+            }
+            calc_free(t);
+        }
+        total++;
+        {   /* 7^12345 ʮƣν̳ */
+            ok=big_set_u64(&a,1);
+            for(i=0;ok && i<12345;++i) ok=big_mul_small(&a,7,0);
+            t=ok? big_to_dec(&a) : NULL;
+            u=(char*)calc_malloc(MEM_OTHER,(size_t)a.n*10+12);
+            if(t && u && big_copy(&b,&a)){
+                calc_u32 ch[1300]; int nc=0; size_t p=0;
+                while(b.n>0 && nc<1300) ch[nc++]=big_div_small(&b,1000000000u);
+                p+=(size_t)sprintf(u,"%u",ch[nc-1]);
+                for(i=nc-2;i>=0;--i) p+=(size_t)sprintf(u+p,"%09u",ch[i]);
+                if(strcmp(t,u)==0) pass++;
+            }
+            calc_free(t); calc_free(u);
+        }
+        total++;
+        {   /* ȷģʽʮ double */
+            ExVal v;
+            if(eval_expr_exact_local("0xFFFFFFFFFFFFFFFFFFFFFFFF+1",&v,err,sizeof(err))){
+                t=(v.exact && rat_is_int(&v.q))? big_to_base(&v.q.num,16) : NULL;
+                if(t && strcmp(t,"1000000000000000000000000")==0) pass++;
+                calc_free(t); ex_free_local(&v);
+            }
+        }
+        big_free(&a); big_free(&b); big_free(&c); big_free(&d); big_free(&q); big_free(&r);
+    }
+    printf("SelfTest radix: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ɣɵıʽֵϲοֵһ£ MAX_TOKENS Խ */
+    pass=0; total=0;
+    {
+        static GenCtx g; static char text[CORPUS_MAX_TEXT]; int k, j, bad;
+        double ov[3]; int had[3];
+        for(j=0;j<3;++j){ had[j]=var_get(g_corpus_vars[j],&ov[j]); var_set(g_corpus_vars[j],g_corpus_vals[j]); }
+        for(k=0;g_corpus_profiles[k].name;++k){
+            total++;
+            g.pf=g_corpus_profiles[k]; rng_seed(&g.rng,(calc_u64)(k+1));
+            for(j=0,bad=0;j<200 && !bad;++j){
+                double ref, v;
+                bad=!gen_expr_local(&g,text,&ref) || !eval_expr_local(text,&v,err,sizeof(err))
+                    || !(fabs(v-ref)<=1e-9*(fabs(ref)>1.0? fabs(ref) : 1.0));
+            }
+            if(!bad) pass++;
+        }
+        for(j=0;j<3;++j){ if(had[j]) var_set(g_corpus_vars[j],ov[j]); else var_del(g_corpus_vars[j]); }
+        total++;
+        for(j=0;j<MAX_TOKENS+1;++j){ text[2*j]='1'; text[2*j+1]='+'; }
+        text[2*j]='1'; text[2*j+1]='\0';
+        if(!eval_expr_local(text,&out,err,sizeof(err)) && strstr(err,"")) pass++;
+    }
+    printf("SelfTest corpus: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ֽ׶μʱʱѭķʽʱһֵʷת RPNֵм룻رպٸ */
+    pass=0; total=0;
+    {
+        const char* ex="zeta(3)+gamma(0.5)*besselj(2,3)"; int saved=g_timing;
+        g_timing=1;
+        timing_begin_line_local();
+        timing_mark_local();
+        total++;
+        if(eval_expr_local(ex,&out,err,sizeof(err))){
+            timing_stop_local(TM_EVAL);
+            if(g_tm_calls[TM_TOKENIZE]>=1 && g_tm_cur[TM_TOKENIZE]>0.0 && g_tm_calls[TM_RPN]>=1 && g_tm_cur[TM_RPN]>0.0
+               && g_tm_calls[TM_EVAL]==1 && g_tm_cur[TM_EVAL]>0.0) pass++;
+        }
+        g_timing=0;
+        timing_reset_line_local();
+        total++;
+        if(eval_expr_local(ex,&out,err,sizeof(err)) && g_tm_calls[TM_TOKENIZE]==0 && g_tm_calls[TM_RPN]==0
+           && g_tm_cur[TM_TOKENIZE]==0.0 && g_tm_cur[TM_RPN]==0.0) pass++;
+        g_timing=saved;
+    }
+    printf("SelfTest timing: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ֵSimpson ֵ n+1 ͬţÿ 3 Σ--trace ժȡ */
+    pass=0; total=0;
+    {
+        double v, e, r; char a1[64]="sin(x) x 0 1 --trace t.csv 100", a2[16]="x --trace", f[16];
+        ntrace_begin_local(NULL);
+        total++; if(integ_simpson("sin(x)","x",0.0,M_PI,100,&v,&e,err,sizeof(err)) && g_ntrace.nevals==101
+                    && e>0.5*fabs(v-2.0) && e<2.0*fabs(v-2.0)) pass++;
+        ntrace_begin_local(NULL);
+        total++; if(integ_simpson("sin(x)","x",0.0,M_PI,102,&v,&e,err,sizeof(err)) && !isfinite(e)) pass++;
+        ntrace_begin_local(NULL);
+        total++; if(solve_newton("x^3-2*x-5","x",2.0,30,1e-12,&r,err,sizeof(err)) && g_ntrace.iters>0 && g_ntrace.nevals==3*g_ntrace.iters) pass++;
+        ntrace_end_local(f,sizeof(f));
+        total++; if(take_opt_local(a1,"--trace",f,sizeof(f))==1 && strcmp(f,"t.csv")==0
+                    && !strstr(a1,"--trace") && !strstr(a1,"t.csv") && strstr(a1," 100")) pass++;
+        total++; if(take_opt_local(a2,"--trace",f,sizeof(f))==-1) pass++;
+    }
+    printf("SelfTest trace: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ڴˣ/realloc/ͷźλ޷ NULL ʧܣļϵͳcalloc  */
+    pass=0; total=0;
+    {
+        size_t c0=g_mem[MEM_OTHER].cur, k0=g_mem[MEM_CACHE].cur; long f0=g_mem[MEM_OTHER].nfail;
+        char* p1=(char*)calc_malloc(MEM_OTHER,1000); char* p2; double* z; int j, zero=1;
+        total++; if(p1 && g_mem[MEM_OTHER].cur==c0+1000) pass++;
+        p2=(char*)calc_realloc(MEM_ARRAY,p1,3000);   /* realloc ԭ */
+        total++; if(p2 && g_mem[MEM_OTHER].cur==c0+3000 && g_mem[MEM_OTHER].peak>=c0+3000) pass++;
+        g_mem[MEM_OTHER].limit=(double)(g_mem[MEM_OTHER].cur+100);
+        total++; if(!calc_malloc(MEM_OTHER,200) && g_mem[MEM_OTHER].nfail==f0+1 && !calc_realloc(MEM_OTHER,p2,4000)) pass++;
+        g_mem[MEM_OTHER].limit=0.0;
+        calc_mem_retag(p2,MEM_CACHE);
+        total++; if(g_mem[MEM_OTHER].cur==c0 && g_mem[MEM_CACHE].cur==k0+3000) pass++;
+        calc_free(p2);
+        z=(double*)calc_calloc(MEM_OTHER,64,sizeof(double));
+        for(j=0;z && j<64;++j) zero&=(z[j]==0.0);
+        calc_free(z);
+        total++; if(z && zero && g_mem[MEM_OTHER].cur==c0 && g_mem[MEM_CACHE].cur==k0) pass++;
+    }
+    printf("SelfTest mem: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ʱСأ롢/ͷźá븴λذòļϵͳ */
+    pass=0; total=0;
+    {
+        ArenaMark m0=calc_arena_mark(), m1; char *a1, *a2, *a3, *big; void *q1, *q2;
+        size_t h0=g_mem[MEM_HISTORY].cur, v0=g_mem[MEM_VARS].cur, i0=g_arena.inuse;
+        a1=(char*)calc_arena_alloc(100); a2=(char*)calc_arena_alloc(200);
+        total++; if(a1 && a2 && ((size_t)a1&15)==0 && ((size_t)a2&15)==0 && a2==a1+112 && g_arena.inuse==i0+320) pass++;
+        m1=calc_arena_mark();
+        big=(char*)calc_arena_alloc(3*ARENA_CHUNK);
+        if(big){ big[0]=1; big[3*ARENA_CHUNK-1]=1; }
+        calc_arena_release(m1);
+        a3=(char*)calc_arena_alloc(16);
+        total++; if(big && a3==a2+208) pass++;
+        calc_arena_release(m0);
+        total++; if(g_arena.inuse==i0 && calc_arena_alloc(100)==a1) pass++;
+        calc_arena_release(m0);
+        calc_arena_reset();
+        total++; if(g_arena.chunks==1 && g_mem[MEM_ARENA].cur==sizeof(ArenaHead)+ARENA_CHUNK) pass++;
+        q1=calc_pool_alloc(MEM_HISTORY,40); calc_pool_free(q1);
+        q2=calc_pool_alloc(MEM_VARS,33);
+        total++; if(q1 && q2==q1 && g_mem[MEM_HISTORY].cur==h0 && g_mem[MEM_VARS].cur==v0+64) pass++;
+        calc_pool_free(q2);
+    }
+    printf("SelfTest arena: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+
+    /* ܻع飺MannCWhitney ķ벢д׼ļдһ£ǻ׼ļܾ */
+    pass=0; total=0;
+    {
+        static PerfCase wr[2], rd[2];
+        double a[20], b[20], pa, pb; int j, nrd=0, same=1; PerfEnv e, e2; FILE* fp=tmpfile();
+        for(j=0;j<20;++j){ a[j]=100.0+j; b[j]=a[j]; }
+        pa=perf_mwu_p_local(a,20,b,20);
+        total++; if(pa>0.4 && pa<0.6) pass++;
+        for(j=0;j<20;++j) b[j]=a[j]+15.0;
+        pa=perf_mwu_p_local(a,20,b,20); pb=perf_mwu_p_local(b,20,a,20);
+        total++; if(pa<1e-4 && pb>0.999) pass++;
+        for(j=0;j<20;++j) a[j]=b[j]=7.0;
+        total++; if(perf_mwu_p_local(a,20,b,20)==1.0) pass++;
+        memset(&e,0,sizeof(e)); strcpy(e.cpu,"x\"y\\z"); strcpy(e.corpus,"builtin"); e.pinned=3; e.reps=6; e.opt=1;
+        strcpy(wr[0].name,"tokenize"); strcpy(wr[1].name,"plot"); wr[0].ops=123; wr[1].ops=7;
+        for(j=0;j<6;++j){ wr[0].ns[j]=10.5+j; wr[1].ns[j]=2000.0*(j+1); }
+        wr[0].n=wr[1].n=6;
+        if(fp){ perf_write_local(fp,&e,wr,2); rewind(fp); perf_load_local(fp,&e2,rd,&nrd); fclose(fp); }
+        for(j=0;nrd==2 && j<6;++j) same&=(rd[0].ns[j]==wr[0].ns[j] && rd[1].ns[j]==wr[1].ns[j]);
+        total++; if(nrd==2 && same && rd[0].ops==123 && rd[1].ops==7 && strcmp(rd[1].name,"plot")==0
+                    && strcmp(e2.cpu,e.cpu)==0 && e2.pinned==3 && e2.reps==6) pass++;
+        total++; if(!perf_parse_local("{\"cases\": [{\"name\": \"x\"}]}",&e2,rd,&nrd) && nrd==0) pass++;
+    }
+    printf("SelfTest perfcheck: %d/%d\n",pass,total);
+    all_ok = all_ok && (pass==total);
+    return all_ok?0:1;
 }
 
 /* ------------ ѭ ------------ */
 int main(int argc,char** argv){
     char line[MAX_LINE], msg[160]="ʽ /help 鿴", last_expr[MAX_LINE];
-    int len;
+    int len, i;
 
     enable_ansi_if_windows();
     vars_init_defaults();
+    rng_seed(&g_rng,RNG_DEFAULT_SEED);
+
+    /* --trace-out f ÷ϣժճɣ˳ʱд겢ر */
+    for(i=1;i+1<argc;++i)
+        if(strcmp(argv[i],"--trace-out")==0){
+            if(!trace_open_local(argv[i+1])){ printf("޷д׷ļ %s\n",argv[i+1]); return 1; }
+            atexit(trace_close_local);
+            for(;i+2<=argc;++i) argv[i]=argv[i+2];
+            argc-=2;
+            break;
+        }
 
     if(argc>1 && strcmp(argv[1],"--selftest")==0) return run_selftest_local();
+    if(argc>1 && strcmp(argv[1],"--bench-f32")==0) return bench_f32_local();
+    if(argc>1 && strcmp(argv[1],"--bench")==0) return bench_main_local(argc,argv);
+    if(argc>1 && strcmp(argv[1],"--perfcheck")==0) return perfcheck_main_local(argc,argv);
+    if(argc>1 && strcmp(argv[1],"--gen-corpus")==0) return gen_corpus_main_local(argc,argv);
 
     last_expr[0]='\0';
 
     for(;;){
+        double tr=(g_timing|g_trace.on)? calc_now() : 0.0;
         render_panel(msg);
+        if(g_trace.on){ trace_event_local("render","ui",tr,-1); trace_flush_local(); trace_line_begin_local(); }   /* ȴǰд */
+        if(g_timing) timing_end_line_local(tr);
+        calc_arena_reset();   /* һеʱȫʧЧ */
         printf("\n> ʽ: ");
         if(!fgets(line,sizeof(line),stdin)) break;
+        if(g_timing) timing_begin_line_local();
         len=(int)strlen(line);
         while(len>0 && (line[len-1]=='\n'||line[len-1]=='\r')) line[--len]=0;
         if(len==0){ msg[0]='\0'; continue; }
@@ -779,22 +8058,67 @@ int main(int argc,char** argv){
         }
 
         {
-            char work[MAX_LINE];
+            char work[MAX_LINE]; double tc=g_trace.on? calc_now() : 0.0;
             strncpy(work,line,sizeof(work)-1); work[sizeof(work)-1]='\0';
-            if(handle_command_local(work,msg,sizeof(msg))) continue;
+            if(g_timing) timing_mark_local();
+            if(handle_command_local(work,msg,sizeof(msg))){
+                if(g_timing) timing_stop_local(TM_CMD);
+                if(g_trace.on) trace_event_local(work,"command",tc,-1);   /* strtok  work  */
+                continue;
+            }
         }
 
         {
-            double val=0.0; char err[128]; err[0]='\0';
-            if(eval_expr_local(line,&val,err,sizeof(err))){
+            double val=0.0, tf=0.0, te=g_trace.on? calc_now() : 0.0; char err[128]; CalcDD dv; ExVal ev; int ok;
+            err[0]='\0'; ev.exact=0;
+            if(g_timing) timing_mark_local();
+            if(g_prog.on){
+                calc_u64 iv=0;
+                ok=eval_prog_local(line,&iv,err,sizeof(err));
+                if(g_timing){ timing_stop_local(TM_EVAL); tf=calc_now(); }
+                if(g_trace.on) trace_event_local("eval","command",te,-1);
+                if(ok){
+                    g_last_result=prog_to_double_local(iv); var_set("ans",g_last_result);
+                    g_last_prog=iv; g_last_prog_ok=1;
+                    prog_result_msg_local(iv,msg,sizeof(msg));
+                    strncpy(last_expr,line,sizeof(last_expr)-1); last_expr[sizeof(last_expr)-1]='\0';
+                    history_add(line,g_last_result,1,NULL);
+                }else{
+                    snprintf(msg,sizeof(msg),": %s",err);
+                    history_add(line,0.0,0,err);
+                }
+                if(g_timing) timing_add_local(TM_FORMAT,calc_now()-tf);
+                continue;
+            }
+            if(g_exact){
+                ok=eval_expr_exact_local(line,&ev,err,sizeof(err));
+                if(ok) val=ev.exact? rat_to_double(&ev.q) : ev.v;
+            }else if(g_prec==PREC_DD){
+                ok=eval_expr_dd_local(line,&dv,err,sizeof(err));
+                if(ok){ val=dv.hi; g_last_dd=dv; g_last_dd_lossy=g_dd_lossy; }
+            }else ok=eval_expr_local(line,&val,err,sizeof(err));
+            if(g_timing){ timing_stop_local(TM_EVAL); tf=calc_now(); }
+            if(g_trace.on) trace_event_local("eval","command",te,-1);
+            if(ok){
                 g_last_result=val; var_set("ans",g_last_result);
-                snprintf(msg,sizeof(msg)," = %.15g",val);
+                g_last_rat_ok=0;
+                if(g_exact && ev.exact){
+                    rat_result_msg_local(" = ",&ev.q,msg,sizeof(msg));
+                    rat_free(&g_last_rat); g_last_rat=ev.q; g_last_rat_ok=1;
+                }else if(g_exact){
+                    snprintf(msg,sizeof(msg),"  %.15g (Ǿȷ)",val);
+                }else if(g_prec==PREC_DD){
+                    char buf[64];
+                    dd_format_local(dv,g_dd_lossy? 17 : 32,buf,sizeof(buf));
+                    snprintf(msg,sizeof(msg)," = %s%s",buf,g_dd_lossy? " (˫Ⱥ)" : "");
+                }else snprintf(msg,sizeof(msg)," = %.15g",val);
                 strncpy(last_expr,line,sizeof(last_expr)-1); last_expr[sizeof(last_expr)-1]='\0';
                 history_add(line,val,1,NULL);
             }else{
                 snprintf(msg,sizeof(msg),": %s",err);
                 history_add(line,0.0,0,err);
             }
+            if(g_timing) timing_add_local(TM_FORMAT,calc_now()-tf);
         }
     }
     return 0;